@@ -214,6 +214,29 @@ int                 direction;
 
 am_frame_t          am_frame;
 
+// Everything that can change what is drawn on the external automap
+typedef struct
+{
+    int         thingstic;
+    fixed_t     x, y;
+    fixed_t     w, h;
+    fixed_t     scale;
+    fixed_t     viewx, viewy;
+    angle_t     viewangle;
+    fixed_t     playerx, playery;
+    dboolean    invisible;
+    int         cheats;
+    int         allmap;
+    int         markpointnum;
+    int         pathpointnum;
+    dboolean    grid, path, rotatemode, followmode;
+    dboolean    menu;
+} mapwindowstate_t;
+
+static mapwindowstate_t mapwindowstate;
+dboolean                mapwindowchanged = true;
+dboolean                mapwindowredraw;
+
 static dboolean     isteleportline[NUMLINESPECIALS];
 
 static void AM_Rotate(fixed_t *x, fixed_t *y, angle_t angle);
@@ -343,6 +366,8 @@ void AM_SetColors(void)
     teleportercolor = &priorities[nearestcolors[am_teleportercolor] << 8];
     tswallcolor = &priorities[nearestcolors[am_tswallcolor] << 8];
     gridcolor = &priorities[nearestcolors[am_gridcolor ]<< 8];
+
+    mapwindowchanged = true;
 }
 
 void AM_GetGridSize(void)
@@ -363,6 +388,8 @@ void AM_GetGridSize(void)
         am_gridsize = am_gridsize_default;
         M_SaveCVARs();
     }
+
+    mapwindowchanged = true;
 }
 
 void AM_Init(void)
@@ -443,6 +470,7 @@ void AM_Start(const dboolean mainwindow)
     }
 
     AM_InitVariables(mainwindow);
+    mapwindowchanged = true;
 }
 
 //
@@ -1198,7 +1226,7 @@ void AM_ClearFB(void)
 //
 // Based on Cohen-Sutherland clipping algorithm but with a slightly faster reject and precalculated
 // slopes. If the speed is needed, use a hash algorithm to handle the common cases.
-static dboolean AM_ClipMline(int *x0, int *y0, int *x1, int *y1)
+static dboolean AM_ClipFline(const int x0, const int y0, const int x1, const int y1)
 {
     enum
     {
@@ -1211,36 +1239,30 @@ static dboolean AM_ClipMline(int *x0, int *y0, int *x1, int *y1)
     unsigned int    outcode1 = 0;
     unsigned int    outcode2 = 0;
 
-    *x0 = CXMTOF(*x0);
-    *x1 = CXMTOF(*x1);
-
-    if (*x0 < 0)
+    if (x0 < 0)
         outcode1 = LEFT;
-    else if (*x0 >= MAPWIDTH)
+    else if (x0 >= MAPWIDTH)
         outcode1 = RIGHT;
 
-    if (*x1 < 0)
+    if (x1 < 0)
         outcode2 = LEFT;
-    else if (*x1 >= MAPWIDTH)
+    else if (x1 >= MAPWIDTH)
         outcode2 = RIGHT;
 
     if (outcode1 & outcode2)
         return false;
 
-    *y0 = CYMTOF(*y0);
-    *y1 = CYMTOF(*y1);
-
-    if (!((*x0 - *x1) | (*y0 - *y1)))
+    if (!((x0 - x1) | (y0 - y1)))
         return false;
 
-    if (*y0 < 0)
+    if (y0 < 0)
         outcode1 |= TOP;
-    else if (*y0 >= (int)mapheight)
+    else if (y0 >= (int)mapheight)
         outcode1 |= BOTTOM;
 
-    if (*y1 < 0)
+    if (y1 < 0)
         outcode2 |= TOP;
-    else if (*y1 >= (int)mapheight)
+    else if (y1 >= (int)mapheight)
         outcode2 |= BOTTOM;
 
     return !(outcode1 & outcode2);
@@ -1322,93 +1344,102 @@ static inline void PUTTRANSLUCENTDOT(unsigned int x, unsigned int y, byte *color
 //
 // Classic Bresenham w/ whatever optimizations needed for speed
 //
-static void AM_DrawFline(int x0, int y0, int x1, int y1, byte *color,
+static inline void AM_DrawClippedFline(int x0, int y0, int x1, int y1, byte *color,
     void (*putdot)(unsigned int, unsigned int, byte *))
 {
-    if (AM_ClipMline(&x0, &y0, &x1, &y1))
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+
+    if (!dy)
     {
-        int dx = x1 - x0;
-        int dy = y1 - y0;
+        // horizontal line
+        const int   sx = SIGN(dx);
 
-        if (!dy)
-        {
-            // horizontal line
-            const int   sx = SIGN(dx);
+        x0 = BETWEEN(-1, x0, MAPWIDTH - 1);
+        x1 = BETWEEN(-1, x1, MAPWIDTH - 1);
 
-            x0 = BETWEEN(-1, x0, MAPWIDTH - 1);
-            x1 = BETWEEN(-1, x1, MAPWIDTH - 1);
+        y0 *= MAPWIDTH;
 
-            y0 *= MAPWIDTH;
+        putdot(x0, y0, color);
+
+        while (x0 != x1)
+            putdot((x0 += sx), y0, color);
+    }
+    else if (!dx)
+    {
+        // vertical line
+        const int   sy = SIGN(dy) * MAPWIDTH;
 
-            putdot(x0, y0, color);
+        y0 = BETWEEN(-MAPWIDTH, y0 * MAPWIDTH, mapbottom);
+        y1 = BETWEEN(-MAPWIDTH, y1 * MAPWIDTH, mapbottom);
 
-            while (x0 != x1)
-                putdot((x0 += sx), y0, color);
-        }
-        else if (!dx)
-        {
-            // vertical line
-            const int   sy = SIGN(dy) * MAPWIDTH;
+        putdot(x0, y0, color);
 
-            y0 = BETWEEN(-MAPWIDTH, y0 * MAPWIDTH, mapbottom);
-            y1 = BETWEEN(-MAPWIDTH, y1 * MAPWIDTH, mapbottom);
+        while (y0 != y1)
+            putdot(x0, (y0 += sy), color);
+    }
+    else
+    {
+        const int   sx = SIGN(dx);
+        const int   sy = SIGN(dy) * MAPWIDTH;
 
-            putdot(x0, y0, color);
+        dx = ABS(dx);
+        dy = ABS(dy);
+        y0 *= MAPWIDTH;
+        putdot(x0, y0, color);
 
-            while (y0 != y1)
-                putdot(x0, (y0 += sy), color);
+        if (dx == dy)
+        {
+            // diagonal line
+            while (x0 != x1)
+                putdot((x0 += sx), (y0 += sy), color);
         }
-        else
+        else if (dx > dy)
         {
-            const int   sx = SIGN(dx);
-            const int   sy = SIGN(dy) * MAPWIDTH;
+            // x-major line
+            int error = (dy <<= 1) - dx;
 
-            dx = ABS(dx);
-            dy = ABS(dy);
-            y0 *= MAPWIDTH;
-            putdot(x0, y0, color);
+            dx <<= 1;
 
-            if (dx == dy)
-            {
-                // diagonal line
-                while (x0 != x1)
-                    putdot((x0 += sx), (y0 += sy), color);
-            }
-            else if (dx > dy)
+            while (x0 != x1)
             {
-                // x-major line
-                int error = (dy <<= 1) - dx;
-
-                dx <<= 1;
-
-                while (x0 != x1)
-                {
-                    const int   mask = ~(error >> 31);
+                const int   mask = ~(error >> 31);
 
-                    putdot((x0 += sx), (y0 += (sy & mask)), color);
-                    error += dy - (dx & mask);
-                }
+                putdot((x0 += sx), (y0 += (sy & mask)), color);
+                error += dy - (dx & mask);
             }
-            else
-            {
-                // y-major line
-                int error = (dx <<= 1) - dy;
+        }
+        else
+        {
+            // y-major line
+            int error = (dx <<= 1) - dy;
 
-                dy <<= 1;
-                y1 *= MAPWIDTH;
+            dy <<= 1;
+            y1 *= MAPWIDTH;
 
-                while (y0 != y1)
-                {
-                    const int   mask = ~(error >> 31);
+            while (y0 != y1)
+            {
+                const int   mask = ~(error >> 31);
 
-                    putdot((x0 += (sx & mask)), (y0 += sy), color);
-                    error += dx - (dy & mask);
-                }
+                putdot((x0 += (sx & mask)), (y0 += sy), color);
+                error += dx - (dy & mask);
             }
         }
     }
 }
 
+static void AM_DrawFline(int x0, int y0, int x1, int y1, byte *color,
+    void (*putdot)(unsigned int, unsigned int, byte *))
+{
+    x0 = CXMTOF(x0);
+    y0 = CYMTOF(y0);
+    x1 = CXMTOF(x1);
+    y1 = CYMTOF(y1);
+
+    if (AM_ClipFline(x0, y0, x1, y1))
+        AM_DrawClippedFline(x0, y0, x1, y1, color, putdot);
+}
+
 static mline_t (*rotatelinefunc)(mline_t);
 
 static mline_t AM_RotateLine(mline_t mline)
@@ -1454,45 +1485,133 @@ static void AM_DrawGrid(void)
     }
 }
 
-static void AM_DrawWalls(void)
+//
+// Wall lines
+//  Every vertex is projected onto the automap once a frame in a single pass,
+//  so lines sharing a vertex don't each transform it again. Lines are then
+//  culled against the view, and those still visible are added to a batch
+//  that is rasterized once all of them have been classified.
+//
+typedef struct
 {
-    for (int i = 0; i < numlines; i++)
+    int         x0, y0;
+    int         x1, y1;
+    byte        *color;
+    dboolean    big;
+} amline_t;
+
+static mpoint_t *amvertices;
+static int      maxamvertices;
+static amline_t *amlines;
+static int      numamlines;
+static int      maxamlines;
+
+static void AM_TransformVertices(void)
+{
+    if (numvertexes > maxamvertices)
+    {
+        maxamvertices = numvertexes;
+        amvertices = I_Realloc(amvertices, maxamvertices * sizeof(*amvertices));
+    }
+
+    if (rotatelinefunc == &AM_RotateLine)
     {
-        const line_t    line = lines[i];
-        const fixed_t   *lbbox = line.bbox;
-        const fixed_t   *ambbox = am_frame.bbox;
+        const fixed_t   x = am_frame.center.x;
+        const fixed_t   y = am_frame.center.y;
+        const fixed_t   sine = am_frame.sin;
+        const fixed_t   cosine = am_frame.cos;
 
-        if ((lbbox[BOXLEFT] >> FRACTOMAPBITS) <= ambbox[BOXRIGHT] && (lbbox[BOXRIGHT] >> FRACTOMAPBITS) >= ambbox[BOXLEFT]
-            && (lbbox[BOXBOTTOM] >> FRACTOMAPBITS) <= ambbox[BOXTOP] && (lbbox[BOXTOP] >> FRACTOMAPBITS) >= ambbox[BOXBOTTOM])
+        for (int i = 0; i < numvertexes; i++)
         {
-            const unsigned short    flags = line.flags;
+            const fixed_t   dx = (vertexes[i].x >> FRACTOMAPBITS) - x;
+            const fixed_t   dy = (vertexes[i].y >> FRACTOMAPBITS) - y;
 
-            if (!(flags & ML_DONTDRAW) && (flags & ML_MAPPED))
-            {
-                const sector_t  *back = line.backsector;
-                mline_t         mline;
+            amvertices[i].x = CXMTOF(FixedMul(dx, cosine) - FixedMul(dy, sine) + x);
+            amvertices[i].y = CYMTOF(FixedMul(dx, sine) + FixedMul(dy, cosine) + y);
+        }
+    }
+    else
+        for (int i = 0; i < numvertexes; i++)
+        {
+            amvertices[i].x = CXMTOF(vertexes[i].x >> FRACTOMAPBITS);
+            amvertices[i].y = CYMTOF(vertexes[i].y >> FRACTOMAPBITS);
+        }
 
-                mline.a.x = line.v1->x >> FRACTOMAPBITS;
-                mline.a.y = line.v1->y >> FRACTOMAPBITS;
-                mline.b.x = line.v2->x >> FRACTOMAPBITS;
-                mline.b.y = line.v2->y >> FRACTOMAPBITS;
+    numamlines = 0;
+}
 
-                mline = rotatelinefunc(mline);
+static dboolean AM_IsLineInView(const line_t *line)
+{
+    const fixed_t   *lbbox = line->bbox;
+    const fixed_t   *ambbox = am_frame.bbox;
 
-                if (isteleportline[line.special] && back && back->ceilingheight != back->floorheight
-                    && ((flags & ML_TELEPORTTRIGGERED) || isteleport[back->floorpic]) && !(flags & ML_SECRET))
-                    AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, teleportercolor, &PUTDOT);
-                else if (!back || (flags & ML_SECRET))
-                    AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, wallcolor, putbigdot);
-                else
-                {
-                    const sector_t  *front = line.frontsector;
+    return ((lbbox[BOXLEFT] >> FRACTOMAPBITS) <= ambbox[BOXRIGHT]
+        && (lbbox[BOXRIGHT] >> FRACTOMAPBITS) >= ambbox[BOXLEFT]
+        && (lbbox[BOXBOTTOM] >> FRACTOMAPBITS) <= ambbox[BOXTOP]
+        && (lbbox[BOXTOP] >> FRACTOMAPBITS) >= ambbox[BOXBOTTOM]);
+}
 
-                    if (back->floorheight != front->floorheight)
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, fdwallcolor, &PUTDOT);
-                    else if (back->ceilingheight != front->ceilingheight)
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, cdwallcolor, &PUTDOT);
-                }
+static void AM_AddLine(const line_t *line, byte *color, const dboolean big)
+{
+    const mpoint_t  *v1 = &amvertices[line->v1 - vertexes];
+    const mpoint_t  *v2 = &amvertices[line->v2 - vertexes];
+    amline_t        *amline;
+
+    if (!AM_ClipFline(v1->x, v1->y, v2->x, v2->y))
+        return;
+
+    if (numamlines == maxamlines)
+    {
+        maxamlines = (maxamlines ? maxamlines * 2 : 1024);
+        amlines = I_Realloc(amlines, maxamlines * sizeof(*amlines));
+    }
+
+    amline = &amlines[numamlines++];
+    amline->x0 = v1->x;
+    amline->y0 = v1->y;
+    amline->x1 = v2->x;
+    amline->y1 = v2->y;
+    amline->color = color;
+    amline->big = big;
+}
+
+static void AM_DrawLines(void)
+{
+    for (int i = 0; i < numamlines; i++)
+    {
+        const amline_t  *amline = &amlines[i];
+
+        if (amline->big)
+            AM_DrawClippedFline(amline->x0, amline->y0, amline->x1, amline->y1, amline->color, putbigdot);
+        else
+            AM_DrawClippedFline(amline->x0, amline->y0, amline->x1, amline->y1, amline->color, &PUTDOT);
+    }
+}
+
+static void AM_DrawWalls(void)
+{
+    for (int i = 0; i < numlines; i++)
+    {
+        const line_t            *line = &lines[i];
+        const unsigned short    flags = line->flags;
+
+        if (!(flags & ML_DONTDRAW) && (flags & ML_MAPPED) && AM_IsLineInView(line))
+        {
+            const sector_t  *back = line->backsector;
+
+            if (isteleportline[line->special] && back && back->ceilingheight != back->floorheight
+                && ((flags & ML_TELEPORTTRIGGERED) || isteleport[back->floorpic]) && !(flags & ML_SECRET))
+                AM_AddLine(line, teleportercolor, false);
+            else if (!back || (flags & ML_SECRET))
+                AM_AddLine(line, wallcolor, true);
+            else
+            {
+                const sector_t  *front = line->frontsector;
+
+                if (back->floorheight != front->floorheight)
+                    AM_AddLine(line, fdwallcolor, false);
+                else if (back->ceilingheight != front->ceilingheight)
+                    AM_AddLine(line, cdwallcolor, false);
             }
         }
     }
@@ -1502,48 +1621,27 @@ static void AM_DrawWalls_AllMap(void)
 {
     for (int i = 0; i < numlines; i++)
     {
-        const line_t    line = lines[i];
-        const fixed_t   *lbbox = line.bbox;
-        const fixed_t   *ambbox = am_frame.bbox;
-
-        if ((lbbox[BOXLEFT] >> FRACTOMAPBITS) <= ambbox[BOXRIGHT]
-            && (lbbox[BOXRIGHT] >> FRACTOMAPBITS) >= ambbox[BOXLEFT]
-            && (lbbox[BOXBOTTOM] >> FRACTOMAPBITS) <= ambbox[BOXTOP]
-            && (lbbox[BOXTOP] >> FRACTOMAPBITS) >= ambbox[BOXBOTTOM])
+        const line_t            *line = &lines[i];
+        const unsigned short    flags = line->flags;
+
+        if (!(flags & ML_DONTDRAW) && AM_IsLineInView(line))
         {
-            const unsigned short    flags = line.flags;
+            const sector_t  *back = line->backsector;
 
-            if (!(flags & ML_DONTDRAW))
+            if (isteleportline[line->special] && ((flags & ML_TELEPORTTRIGGERED) || (back && isteleport[back->floorpic])))
+                AM_AddLine(line, ((flags & ML_MAPPED) ? teleportercolor : allmapfdwallcolor), false);
+            else if (!back || (flags & ML_SECRET))
+                AM_AddLine(line, ((flags & ML_MAPPED) ? wallcolor : allmapwallcolor), true);
+            else
             {
-                const sector_t  *back = line.backsector;
-                mline_t         mline;
-
-                mline.a.x = line.v1->x >> FRACTOMAPBITS;
-                mline.a.y = line.v1->y >> FRACTOMAPBITS;
-                mline.b.x = line.v2->x >> FRACTOMAPBITS;
-                mline.b.y = line.v2->y >> FRACTOMAPBITS;
-
-                mline = rotatelinefunc(mline);
-
-                if (isteleportline[line.special] && ((flags & ML_TELEPORTTRIGGERED) || (back && isteleport[back->floorpic])))
-                    AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y,
-                        ((flags & ML_MAPPED) ? teleportercolor : allmapfdwallcolor), &PUTDOT);
-                else if (!back || (flags & ML_SECRET))
-                    AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y,
-                        ((flags & ML_MAPPED) ? wallcolor : allmapwallcolor), putbigdot);
-                else
-                {
-                    const sector_t  *front = line.frontsector;
+                const sector_t  *front = line->frontsector;
 
-                    if (back->floorheight != front->floorheight)
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y,
-                            ((flags & ML_MAPPED) ? fdwallcolor : allmapfdwallcolor), &PUTDOT);
-                    else if (back->ceilingheight != front->ceilingheight)
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y,
-                            ((flags & ML_MAPPED) ? cdwallcolor : allmapcdwallcolor), &PUTDOT);
-                    else
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, tswallcolor, &PUTDOT);
-                }
+                if (back->floorheight != front->floorheight)
+                    AM_AddLine(line, ((flags & ML_MAPPED) ? fdwallcolor : allmapfdwallcolor), false);
+                else if (back->ceilingheight != front->ceilingheight)
+                    AM_AddLine(line, ((flags & ML_MAPPED) ? cdwallcolor : allmapcdwallcolor), false);
+                else
+                    AM_AddLine(line, tswallcolor, false);
             }
         }
     }
@@ -1553,42 +1651,28 @@ static void AM_DrawWalls_Cheating(void)
 {
     for (int i = 0; i < numlines; i++)
     {
-        const line_t    line = lines[i];
-        const fixed_t   *lbbox = line.bbox;
-        const fixed_t   *ambbox = am_frame.bbox;
-
-        if ((lbbox[BOXLEFT] >> FRACTOMAPBITS) <= ambbox[BOXRIGHT]
-            && (lbbox[BOXRIGHT] >> FRACTOMAPBITS) >= ambbox[BOXLEFT]
-            && (lbbox[BOXBOTTOM] >> FRACTOMAPBITS) <= ambbox[BOXTOP]
-            && (lbbox[BOXTOP] >> FRACTOMAPBITS) >= ambbox[BOXBOTTOM])
-        {
-            mline_t mline;
-
-            mline.a.x = line.v1->x >> FRACTOMAPBITS;
-            mline.a.y = line.v1->y >> FRACTOMAPBITS;
-            mline.b.x = line.v2->x >> FRACTOMAPBITS;
-            mline.b.y = line.v2->y >> FRACTOMAPBITS;
-
-            mline = rotatelinefunc(mline);
+        const line_t    *line = &lines[i];
 
-            if (isteleportline[line.special])
-                AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, teleportercolor, &PUTDOT);
+        if (AM_IsLineInView(line))
+        {
+            if (isteleportline[line->special])
+                AM_AddLine(line, teleportercolor, false);
             else
             {
-                const sector_t  *back = line.backsector;
+                const sector_t  *back = line->backsector;
 
                 if (!back)
-                    AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, wallcolor, putbigdot);
+                    AM_AddLine(line, wallcolor, true);
                 else
                 {
-                    const sector_t *front = line.frontsector;
+                    const sector_t  *front = line->frontsector;
 
                     if (back->floorheight != front->floorheight)
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, fdwallcolor, &PUTDOT);
+                        AM_AddLine(line, fdwallcolor, false);
                     else if (back->ceilingheight != front->ceilingheight)
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, cdwallcolor, &PUTDOT);
+                        AM_AddLine(line, cdwallcolor, false);
                     else
-                        AM_DrawFline(mline.a.x, mline.a.y, mline.b.x, mline.b.y, tswallcolor, &PUTDOT);
+                        AM_AddLine(line, tswallcolor, false);
                 }
             }
         }
@@ -2024,10 +2108,70 @@ static void AM_SetFrameVariables(void)
     }
 }
 
+//
+// AM_MapWindowChanged
+//  The external automap is redrawn at most once a tic, and only if something
+//  shown on it may have changed since it was last drawn. It follows the
+//  player, so any movement changes the whole of it. Anything that changes how
+//  the map's lines are drawn, such as a line being seen for the first time or
+//  a sector's floor or ceiling moving, sets mapwindowchanged.
+//
+static dboolean AM_MapWindowChanged(void)
+{
+    static int          maptic = -1;
+    mapwindowstate_t    state;
+    const int           tic = I_GetTime();
+
+    if (tic == maptic)
+        return false;
+
+    memset(&state, 0, sizeof(state));
+    state.thingstic = ((viewplayer->cheats & CF_ALLMAP_THINGS) ? gametime : 0);
+    state.x = m_x;
+    state.y = m_y;
+    state.w = m_w;
+    state.h = m_h;
+    state.scale = scale_mtof;
+    state.viewx = viewx;
+    state.viewy = viewy;
+    state.viewangle = viewangle;
+    state.playerx = viewplayer->mo->x;
+    state.playery = viewplayer->mo->y;
+    state.invisible = (viewplayer->powers[pw_invisibility] > STARTFLASHING
+        || (viewplayer->powers[pw_invisibility] & 8));
+    state.cheats = viewplayer->cheats;
+    state.allmap = viewplayer->powers[pw_allmap];
+    state.markpointnum = markpointnum;
+    state.pathpointnum = pathpointnum;
+    state.grid = am_grid;
+    state.path = am_path;
+    state.rotatemode = am_rotatemode;
+    state.followmode = am_followmode;
+    state.menu = (menuactive && !inhelpscreens);
+
+    if (!mapwindowchanged && !memcmp(&state, &mapwindowstate, sizeof(state)))
+        return false;
+
+    mapwindowstate = state;
+    mapwindowchanged = false;
+    maptic = tic;
+
+    return true;
+}
+
 void AM_Drawer(void)
 {
+    if (mapwindow)
+    {
+        if (!AM_MapWindowChanged())
+            return;
+
+        mapwindowredraw = true;
+    }
+
     AM_SetFrameVariables();
     AM_ClearFB();
+    AM_TransformVertices();
 
     if (viewplayer->cheats & (CF_ALLMAP | CF_ALLMAP_THINGS))
         AM_DrawWalls_Cheating();
@@ -2036,6 +2180,8 @@ void AM_Drawer(void)
     else
         AM_DrawWalls();
 
+    AM_DrawLines();
+
     if (am_grid)
         AM_DrawGrid();
 
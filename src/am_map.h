@@ -99,6 +99,8 @@ extern int          pathpointnum;
 extern int          pathpointnum_max;
 
 extern am_frame_t   am_frame;
+extern dboolean     mapwindowchanged;
+extern dboolean     mapwindowredraw;
 extern int          direction;
 
 dboolean keystate(int key);
@@ -36,8 +36,13 @@
 ========================================================================
 */
 
+#include <stdint.h>
+#include <string.h>
+
 #include "c_console.h"
 #include "doomdef.h"
+#include "i_system.h"
+#include "m_misc.h"
 
 autocomplete_t autocompletelist[] =
 {
@@ -5158,6 +5163,10 @@ autocomplete_t autocompletelist[] =
     { "+fire",                                       DOOM1AND2 },
     { "+followmode",                                 DOOM1AND2 },
     { "+forward",                                    DOOM1AND2 },
+    { "framedump",                                   DOOM1AND2 },
+    { "framedump off",                               DOOM1AND2 },
+    { "framedump png",                               DOOM1AND2 },
+    { "framedump y4m",                               DOOM1AND2 },
     { "freeze ",                                     DOOM1AND2 },
     { "freeze off",                                  DOOM1AND2 },
     { "freeze on",                                   DOOM1AND2 },
@@ -6562,6 +6571,11 @@ autocomplete_t autocompletelist[] =
     { "if r_playersprites off then ",                DOOM1AND2 },
     { "if r_playersprites on ",                      DOOM1AND2 },
     { "if r_playersprites on then ",                 DOOM1AND2 },
+    { "if r_pvs ",                                   DOOM1AND2 },
+    { "if r_pvs off ",                               DOOM1AND2 },
+    { "if r_pvs off then ",                          DOOM1AND2 },
+    { "if r_pvs on ",                                DOOM1AND2 },
+    { "if r_pvs on then ",                           DOOM1AND2 },
     { "if r_rockettrails ",                          DOOM1AND2 },
     { "if r_rockettrails off ",                      DOOM1AND2 },
     { "if r_rockettrails off then ",                 DOOM1AND2 },
@@ -6909,6 +6923,8 @@ autocomplete_t autocompletelist[] =
     { "+left",                                       DOOM1AND2 },
     { "license",                                     DOOM1AND2 },
     { "load ",                                       DOOM1AND2 },
+    { "loadstats",                                   DOOM1AND2 },
+    { "loadstats ",                                  DOOM1AND2 },
     { "m_acceleration ",                             DOOM1AND2 },
     { "m_acceleration off",                          DOOM1AND2 },
     { "m_acceleration on",                           DOOM1AND2 },
@@ -7592,6 +7608,9 @@ autocomplete_t autocompletelist[] =
     { "r_playersprites ",                            DOOM1AND2 },
     { "r_playersprites off",                         DOOM1AND2 },
     { "r_playersprites on",                          DOOM1AND2 },
+    { "r_pvs ",                                      DOOM1AND2 },
+    { "r_pvs off",                                   DOOM1AND2 },
+    { "r_pvs on",                                    DOOM1AND2 },
     { "r_rockettrails ",                             DOOM1AND2 },
     { "r_rockettrails off",                          DOOM1AND2 },
     { "r_rockettrails on",                           DOOM1AND2 },
@@ -7739,6 +7758,7 @@ autocomplete_t autocompletelist[] =
     { "reset r_lowpixelsize",                        DOOM1AND2 },
     { "reset r_mirroredweapons",                     DOOM1AND2 },
     { "reset r_playersprites",                       DOOM1AND2 },
+    { "reset r_pvs",                                 DOOM1AND2 },
     { "reset r_rockettrails",                        DOOM1AND2 },
     { "reset r_screensize",                          DOOM1AND2 },
     { "reset r_shadows",                             DOOM1AND2 },
@@ -8273,3 +8293,118 @@ autocomplete_t autocompletelist[] =
     { "+zoomout",                                    DOOM1AND2 },
     { "",                                            0         }
 };
+
+// All of the entries above, along with any added while running, sorted so
+// those starting with the same text are next to each other
+static const autocomplete_t **autocompletes;
+static int                  numautocompletes;
+static int                  maxautocompletes;
+static int                  autocompletelistsize;
+
+static int C_CompareAutocompletes(const void *a, const void *b)
+{
+    return strcasecmp((*(const autocomplete_t **)a)->text, (*(const autocomplete_t **)b)->text);
+}
+
+void C_InitAutocomplete(void)
+{
+    if (autocompletes)
+        return;
+
+    while (*autocompletelist[autocompletelistsize].text)
+        autocompletelistsize++;
+
+    numautocompletes = autocompletelistsize;
+    maxautocompletes = numautocompletes + 256;
+    autocompletes = malloc(maxautocompletes * sizeof(*autocompletes));
+
+    for (int i = 0; i < numautocompletes; i++)
+        autocompletes[i] = &autocompletelist[i];
+
+    qsort(autocompletes, numautocompletes, sizeof(*autocompletes), C_CompareAutocompletes);
+}
+
+// Returns the first entry that comes after text, if after is set, or otherwise
+// the first entry that doesn't come before it. Only the first len characters
+// of each entry are compared.
+static int C_SearchAutocompletes(const char *text, const size_t len, const dboolean after)
+{
+    int low = 0;
+    int high = numautocompletes;
+
+    while (low < high)
+    {
+        const int   mid = (low + high) / 2;
+        const int   result = strncasecmp(autocompletes[mid]->text, text, len);
+
+        if (result < 0 || (after && !result))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+//
+// C_FindAutocompletes
+//  Return the index of the first entry that starts with text, and set end to
+//  the index after the last one.
+//
+int C_FindAutocompletes(const char *text, int *end)
+{
+    const size_t    len = strlen(text);
+
+    C_InitAutocomplete();
+    *end = C_SearchAutocompletes(text, len, true);
+
+    return C_SearchAutocompletes(text, len, false);
+}
+
+const autocomplete_t *C_GetAutocomplete(const int index)
+{
+    return autocompletes[index];
+}
+
+void C_AddAutocomplete(const char *text, const int game)
+{
+    autocomplete_t  *autocomplete;
+    int             index;
+
+    C_InitAutocomplete();
+    index = C_SearchAutocompletes(text, SIZE_MAX, false);
+
+    if (index < numautocompletes && M_StringCompare(autocompletes[index]->text, text))
+        return;
+
+    if (numautocompletes == maxautocompletes)
+        autocompletes = I_Realloc(autocompletes, (maxautocompletes *= 2) * sizeof(*autocompletes));
+
+    autocomplete = malloc(sizeof(*autocomplete));
+    M_StringCopy(autocomplete->text, text, sizeof(autocomplete->text));
+    autocomplete->game = game;
+
+    memmove(&autocompletes[index + 1], &autocompletes[index], (numautocompletes++ - index) * sizeof(*autocompletes));
+    autocompletes[index] = autocomplete;
+}
+
+void C_RemoveAutocomplete(const char *text)
+{
+    int index;
+
+    C_InitAutocomplete();
+    index = C_SearchAutocompletes(text, SIZE_MAX, false);
+
+    // only entries that were added by C_AddAutocomplete() can be removed
+    for (; index < numautocompletes && M_StringCompare(autocompletes[index]->text, text); index++)
+    {
+        const autocomplete_t    *autocomplete = autocompletes[index];
+
+        if (autocomplete < autocompletelist || autocomplete >= autocompletelist + autocompletelistsize)
+        {
+            memmove(&autocompletes[index], &autocompletes[index + 1], (--numautocompletes - index) * sizeof(*autocompletes));
+            free((autocomplete_t *)autocomplete);
+            break;
+        }
+    }
+}
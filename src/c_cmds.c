@@ -65,6 +65,7 @@
 #include "p_pspr.h"
 #include "p_setup.h"
 #include "p_tick.h"
+#include "r_pvs.h"
 #include "r_sky.h"
 #include "s_sound.h"
 #include "sc_man.h"
@@ -276,6 +277,7 @@ static void exec_cmd_func2(char *cmd, char *parms);
 static void exitmap_cmd_func2(char *cmd, char *parms);
 static dboolean fastmonsters_cmd_func1(char *cmd, char *parms);
 static void fastmonsters_cmd_func2(char *cmd, char *parms);
+static void framedump_cmd_func2(char *cmd, char *parms);
 static void freeze_cmd_func2(char *cmd, char *parms);
 static dboolean give_cmd_func1(char *cmd, char *parms);
 static void give_cmd_func2(char *cmd, char *parms);
@@ -286,6 +288,8 @@ static dboolean kill_cmd_func1(char *cmd, char *parms);
 static void kill_cmd_func2(char *cmd, char *parms);
 static void license_cmd_func2(char *cmd, char *parms);
 static void load_cmd_func2(char *cmd, char *parms);
+static dboolean loadstats_cmd_func1(char *cmd, char *parms);
+static void loadstats_cmd_func2(char *cmd, char *parms);
 static dboolean map_cmd_func1(char *cmd, char *parms);
 static void map_cmd_func2(char *cmd, char *parms);
 static void maplist_cmd_func2(char *cmd, char *parms);
@@ -365,6 +369,7 @@ static void r_gamma_cvar_func2(char *cmd, char *parms);
 static void r_hud_cvar_func2(char *cmd, char *parms);
 static void r_hud_translucency_cvar_func2(char *cmd, char *parms);
 static void r_lowpixelsize_cvar_func2(char *cmd, char *parms);
+static void r_pvs_cvar_func2(char *cmd, char *parms);
 static void r_screensize_cvar_func2(char *cmd, char *parms);
 static void r_shadows_translucency_cvar_func2(char *cmd, char *parms);
 static dboolean r_skycolor_cvar_func1(char *cmd, char *parms);
@@ -539,6 +544,8 @@ consolecmd_t consolecmds[] =
         "Toggles a fading effect when transitioning between\nsome screens."),
         CCMD(fastmonsters, "", fastmonsters_cmd_func1, fastmonsters_cmd_func2, true, "[<b>on</b>|<b>off</b>]",
         "Toggles fast monsters."),
+    CCMD(framedump, "", null_func1, framedump_cmd_func2, true, "[<b>png</b>|<b>y4m</b>|<b>off</b>]",
+        "Toggles dumping every frame to a sequence of\n<b>.png</b> files or a <b>.y4m</b> file."),
     CCMD(freeze, "", alive_func1, freeze_cmd_func2, true, "[<b>on</b>|<b>off</b>]",
         "Toggles freeze mode."),
     CVAR_TIME(gametime, "", null_func1, time_cvars_func2,
@@ -605,6 +612,8 @@ consolecmd_t consolecmds[] =
         "Displays the <i><b>" PACKAGE_LICENSE ".</b></i>"),
     CCMD(load, "", null_func1, load_cmd_func2, true, LOADCMDFORMAT,
         "Loads a game from a file."),
+    CCMD(loadstats, "", loadstats_cmd_func1, loadstats_cmd_func2, true, "[<i>filename</i><b>.json</b>]",
+        "Shows how long each part of loading the current\nmap took, or saves it to a file."),
     CVAR_BOOL(m_acceleration, "", bool_cvars_func1, bool_cvars_func2, BOOLVALUEALIAS,
         "Toggles the acceleration of mouse movement."),
     CVAR_BOOL(m_doubleclick_use, "", bool_cvars_func1, bool_cvars_func2, BOOLVALUEALIAS,
@@ -723,6 +732,8 @@ consolecmd_t consolecmds[] =
         "Toggles randomly mirroring the weapons dropped\nby monsters."),
     CVAR_BOOL(r_playersprites, "", bool_cvars_func1, bool_cvars_func2, BOOLVALUEALIAS,
         "Toggles showing the player's weapon."),
+    CVAR_BOOL(r_pvs, "", bool_cvars_func1, r_pvs_cvar_func2, BOOLVALUEALIAS,
+        "Toggles skipping parts of the map that can't be\nseen from where the player is."),
     CVAR_BOOL(r_rockettrails, "", bool_cvars_func1, bool_cvars_func2, BOOLVALUEALIAS,
         "Toggles the trails of smoke behind rockets fired by\nthe player and cyberdemons."),
     CVAR_INT(r_screensize, "", int_cvars_func1, r_screensize_cvar_func2, CF_NONE, NOVALUEALIAS,
@@ -1039,19 +1050,66 @@ static void weapon7_action_func(void)
     P_ChangeWeapon(wp_bfg);
 }
 
-static int C_GetIndex(const char *cmd)
+#define CONSOLECMDHASHSIZE  1024
+
+static short    consolecmdhash[CONSOLECMDHASHSIZE];
+
+static unsigned int C_ConsoleCmdHash(const char *name)
 {
-    int i = 0;
+    unsigned int    hash = 2166136261u;
 
-    while (*consolecmds[i].name)
+    while (*name)
     {
-        if (M_StringCompare(cmd, consolecmds[i].name) || M_StringCompare(cmd, consolecmds[i].alternate))
-            break;
+        hash ^= tolower((unsigned char)*name++);
+        hash *= 16777619u;
+    }
 
-        i++;
+    return (hash & (CONSOLECMDHASHSIZE - 1));
+}
+
+static void C_AddToConsoleCmdHash(const char *name, const int index)
+{
+    unsigned int    slot = C_ConsoleCmdHash(name);
+
+    while (consolecmdhash[slot])
+        slot = (slot + 1) & (CONSOLECMDHASHSIZE - 1);
+
+    consolecmdhash[slot] = index + 1;
+}
+
+//
+// C_FindConsoleCmd
+//  Return the index in consolecmds[] of the CCMD, CVAR or cheat with the given
+//  name or alternate name, or -1 if there isn't one.
+//
+int C_FindConsoleCmd(const char *name)
+{
+    static dboolean hashed;
+
+    if (!hashed)
+    {
+        // since the names are added in order, the first is always found first
+        for (int i = 0; *consolecmds[i].name; i++)
+        {
+            C_AddToConsoleCmdHash(consolecmds[i].name, i);
+
+            // most have no alternate name, which is stringified as ""
+            if (*consolecmds[i].alternate && !M_StringCompare(consolecmds[i].alternate, "\"\""))
+                C_AddToConsoleCmdHash(consolecmds[i].alternate, i);
+        }
+
+        hashed = true;
+    }
+
+    for (unsigned int slot = C_ConsoleCmdHash(name); consolecmdhash[slot]; slot = (slot + 1) & (CONSOLECMDHASHSIZE - 1))
+    {
+        const int   i = consolecmdhash[slot] - 1;
+
+        if (M_StringCompare(name, consolecmds[i].name) || M_StringCompare(name, consolecmds[i].alternate))
+            return i;
     }
 
-    return i;
+    return -1;
 }
 
 static void C_ShowDescription(int index)
@@ -1185,30 +1243,31 @@ dboolean C_ExecuteAlias(const char *alias)
         for (int i = 0; i < MAXALIASES; i++)
             if (M_StringCompare(alias, aliases[i].name))
             {
-                char    *string = M_StringDuplicate(aliases[i].string);
-                char    *strings[255];
-                int     j = 0;
-
-                strings[0] = strtok(string, ";");
                 executingalias = true;
-
-                while (strings[j])
-                {
-                    if (!C_ValidateInput(trimwhitespace(strings[j])))
-                        break;
-
-                    strings[++j] = strtok(NULL, ";");
-                }
-
+                C_ExecuteScript(aliases[i].string, false);
                 executingalias = false;
                 C_Input("%s", alias);
-                free(string);
                 return true;
             }
 
     return false;
 }
 
+static void C_RemoveAlias(alias_t *alias)
+{
+    if (*alias->name)
+        C_RemoveAutocomplete(alias->name);
+
+    alias->name[0] = '\0';
+    alias->string[0] = '\0';
+}
+
+void C_ClearAliases(void)
+{
+    for (int i = 0; i < MAXALIASES; i++)
+        C_RemoveAlias(&aliases[i]);
+}
+
 void alias_cmd_func2(char *cmd, char *parms)
 {
     char    parm1[128] = "";
@@ -1216,7 +1275,7 @@ void alias_cmd_func2(char *cmd, char *parms)
 
     if (sscanf(parms, "%127s %127[^\n]", parm1, parm2) <= 0)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, ALIASCMDFORMAT);
         return;
     }
@@ -1232,8 +1291,7 @@ void alias_cmd_func2(char *cmd, char *parms)
         for (int i = 0; i < MAXALIASES; i++)
             if (*aliases[i].name && M_StringCompare(parm1, aliases[i].name))
             {
-                aliases[i].name[0] = '\0';
-                aliases[i].string[0] = '\0';
+                C_RemoveAlias(&aliases[i]);
                 M_SaveCVARs();
                 return;
             }
@@ -1256,6 +1314,7 @@ void alias_cmd_func2(char *cmd, char *parms)
         {
             M_StringCopy(aliases[i].name, parm1, sizeof(aliases[i].name));
             M_StringCopy(aliases[i].string, parm2, sizeof(aliases[i].string));
+            C_AddAutocomplete(aliases[i].name, DOOM1AND2);
             M_SaveCVARs();
             return;
         }
@@ -1303,7 +1362,7 @@ void bind_cmd_func2(char *cmd, char *parms)
 
     if (sscanf(parms, "%127s %127[^\n]", parm1, parm2) <= 0)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, BINDCMDFORMAT);
         return;
     }
@@ -1680,38 +1739,128 @@ static void cmdlist_cmd_func2(char *cmd, char *parms)
         }
 }
 
-static FILE *condumpfile = NULL;
+static FILE         *condumpfile = NULL;
+static char         *condumpbuffer;
+static size_t       condumpbufferlen;
+static size_t       condumpbuffersize;
+static SDL_Thread   *condumpthread;
+static SDL_mutex    *condumpmutex;
+static SDL_cond     *condumpcond;
+static dboolean     condumpshutdown;
+
+//
+// C_ConsoleDumpThread
+//  Write the lines queued by C_DumpConsoleStringToFile() to the condump file,
+//  swapping buffers so more lines can be queued while it does.
+//
+static int SDLCALL C_ConsoleDumpThread(void *data)
+{
+    char    *buffer = NULL;
+    size_t  buffersize = 0;
+
+    while (true)
+    {
+        char    *temp = buffer;
+        size_t  size = buffersize;
+        size_t  len;
+
+        SDL_LockMutex(condumpmutex);
+
+        while (!condumpbufferlen && !condumpshutdown)
+            SDL_CondWait(condumpcond, condumpmutex);
+
+        if (!(len = condumpbufferlen))
+        {
+            SDL_UnlockMutex(condumpmutex);
+            break;
+        }
+
+        buffer = condumpbuffer;
+        buffersize = condumpbuffersize;
+        condumpbuffer = temp;
+        condumpbuffersize = size;
+        condumpbufferlen = 0;
+        SDL_UnlockMutex(condumpmutex);
+
+        fwrite(buffer, 1, len, condumpfile);
+    }
+
+    free(buffer);
+    return 0;
+}
+
+//
+// C_ShutdownConsoleDump
+//  Wait for any lines still queued to be written, and close the condump file.
+//
+void C_ShutdownConsoleDump(void)
+{
+    if (!condumpfile)
+        return;
+
+    SDL_LockMutex(condumpmutex);
+    condumpshutdown = true;
+    SDL_CondSignal(condumpcond);
+    SDL_UnlockMutex(condumpmutex);
+
+    SDL_WaitThread(condumpthread, NULL);
+    condumpthread = NULL;
+    condumpshutdown = false;
+
+    fclose(condumpfile);
+    condumpfile = NULL;
+}
 
 //
 // condump CCMD
 //
 void C_DumpConsoleStringToFile(int index)
 {
+    char    buffer[CONSOLETEXTMAXLENGTH * 2];
+    size_t  len = 0;
+
     if (!condumpfile)
         return;
 
     if (console[index].stringtype == dividerstring)
-        fprintf(condumpfile, "%s\n", DIVIDERSTRING);
+    {
+        M_StringCopy(buffer, DIVIDERSTRING "\n", sizeof(buffer));
+        len = strlen(buffer);
+    }
     else
     {
-        char            *string = M_StringDuplicate(console[index].string);
-        int             len;
+        const char      *string = console[index].string;
         unsigned int    outpos = 0;
         int             tabcount = 0;
 
-        strreplace(string, "<b>", "");
-        strreplace(string, "</b>", "");
-        strreplace(string, "<i>", "");
-        strreplace(string, "</i>", "");
-        len = (int)strlen(string);
-
         if (console[index].stringtype == warningstring)
-            fputs((console[index].line == 1 ? "! " : (string[0] == ' ' ? " " : "  ")), condumpfile);
+        {
+            M_StringCopy(buffer, (console[index].line == 1 ? "! " : (string[0] == ' ' ? " " : "  ")), sizeof(buffer));
+            len = strlen(buffer);
+        }
 
-        for (int inpos = 0; inpos < len; inpos++)
+        for (int inpos = 0; string[inpos] && len < sizeof(buffer) - 256; inpos++)
         {
             const unsigned char letter = string[inpos];
 
+            // skip over any formatting
+            if (letter == '<')
+            {
+                const char  *tags[] = { "<b>", "</b>", "<i>", "</i>" };
+                dboolean    tag = false;
+
+                for (int i = 0; i < arrlen(tags); i++)
+                    if (!strncmp(string + inpos, tags[i], strlen(tags[i])))
+                    {
+                        inpos += (int)strlen(tags[i]) - 1;
+                        tag = true;
+                        break;
+                    }
+
+                if (tag)
+                    continue;
+            }
+
             if (letter != '\n')
             {
                 if (letter == '\t')
@@ -1720,21 +1869,23 @@ void C_DumpConsoleStringToFile(int index)
 
                     if (outpos < tabstop)
                     {
-                        for (unsigned int spaces = 0; spaces < tabstop - outpos; spaces++)
-                            fputc(' ', condumpfile);
+                        while (outpos < tabstop)
+                        {
+                            buffer[len++] = ' ';
+                            outpos++;
+                        }
 
-                        outpos = tabstop;
                         tabcount++;
                     }
                     else
                     {
-                        fputc(' ', condumpfile);
+                        buffer[len++] = ' ';
                         outpos++;
                     }
                 }
                 else
                 {
-                    fputc(letter, condumpfile);
+                    buffer[len++] = letter;
                     outpos++;
                 }
             }
@@ -1742,22 +1893,42 @@ void C_DumpConsoleStringToFile(int index)
 
         if (console[index].stringtype == playermessagestring || console[index].stringtype == obituarystring)
         {
-            char    buffer[9];
-
-            for (unsigned int spaces = 0; spaces < 92 - outpos; spaces++)
-                fputc(' ', condumpfile);
+            const char  *timestamp = C_CreateTimeStamp(index);
 
-            M_StringCopy(buffer, C_CreateTimeStamp(index), sizeof(buffer));
+            while (outpos++ < 92)
+                buffer[len++] = ' ';
 
-            if (strlen(buffer) == 7)
-                fputc(' ', condumpfile);
+            if (strlen(timestamp) == 7)
+                buffer[len++] = ' ';
 
-            fputs(C_CreateTimeStamp(index), condumpfile);
+            M_StringCopy(buffer + len, timestamp, sizeof(buffer) - len);
+            len += strlen(timestamp);
         }
 
-        fputc('\n', condumpfile);
-        free(string);
+        buffer[len++] = '\n';
+    }
+
+    // write the line straight away if there's no thread to queue it for
+    if (!condumpthread)
+    {
+        fwrite(buffer, 1, len, condumpfile);
+        return;
+    }
+
+    SDL_LockMutex(condumpmutex);
+
+    if (condumpbufferlen + len > condumpbuffersize)
+    {
+        while (condumpbufferlen + len > condumpbuffersize)
+            condumpbuffersize = (condumpbuffersize ? condumpbuffersize * 2 : sizeof(buffer) * 64);
+
+        condumpbuffer = I_Realloc(condumpbuffer, condumpbuffersize);
     }
+
+    memcpy(condumpbuffer + condumpbufferlen, buffer, len);
+    condumpbufferlen += len;
+    SDL_CondSignal(condumpcond);
+    SDL_UnlockMutex(condumpmutex);
 }
 
 static dboolean condump_cmd_func1(char *cmd, char *parms)
@@ -1790,10 +1961,22 @@ static void condump_cmd_func2(char *cmd, char *parms)
     else
         M_snprintf(filename, sizeof(filename), "%s" DIR_SEPARATOR_S "%s", appdatafolder, parms);
 
+    C_ShutdownConsoleDump();
+
     if ((condumpfile = fopen(filename, "wt")))
     {
         char    *temp = commify((int64_t)consolestrings - 2);
 
+        if (!condumpmutex)
+        {
+            condumpmutex = SDL_CreateMutex();
+            condumpcond = SDL_CreateCond();
+        }
+
+        // if the thread can't be created, lines are written as they're dumped instead
+        if (condumpmutex && condumpcond)
+            condumpthread = SDL_CreateThread(C_ConsoleDumpThread, "C_ConsoleDumpThread", NULL);
+
         for (int i = 1; i < consolestrings; i++)
             C_DumpConsoleStringToFile(i);
 
@@ -1955,23 +2138,27 @@ static void exec_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, EXECCMDFORMAT);
     }
     else
     {
-        FILE    *file = fopen(parms, "r");
-        char    strparm[256] = "";
+        FILE    *file = fopen(parms, "rb");
+        char    *string;
+        long    size;
 
         if (!file)
             return;
 
-        while (fgets(strparm, 256, file) != NULL)
-        {
-            if (strparm[0] == ';')
-                continue;
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        fseek(file, 0, SEEK_SET);
 
-            C_ValidateInput(strparm);
+        if (size > 0 && (string = malloc((size_t)size + 1)))
+        {
+            string[fread(string, 1, size, file)] = '\0';
+            C_ExecuteScript(string, true);
+            free(string);
         }
 
         fclose(file);
@@ -2027,6 +2214,44 @@ static void fastmonsters_cmd_func2(char *cmd, char *parms)
     message_dontfuckwithme = true;
 }
 
+//
+// framedump CCMD
+//
+static void framedump_cmd_func2(char *cmd, char *parms)
+{
+    framedump_t type = framedump_png;
+
+    if (M_StringCompare(parms, "off") || (!*parms && framedump != framedump_none))
+    {
+        if (framedump != framedump_none)
+        {
+            char    *temp = commify(framedumpframes);
+
+            V_StopFrameDump();
+            C_Output("Dumped %s frame%s to <b>%s</b>.", temp, (framedumpframes == 1 ? "" : "s"), framedumpfolder);
+            free(temp);
+        }
+
+        return;
+    }
+
+    if (M_StringCompare(parms, "y4m"))
+        type = framedump_y4m;
+    else if (*parms && !M_StringCompare(parms, "png"))
+    {
+        C_ShowDescription(C_FindConsoleCmd(cmd));
+        return;
+    }
+
+    if (framedump != framedump_none)
+        V_StopFrameDump();
+
+    if (V_StartFrameDump(type))
+        C_Output("Dumping every frame to <b>%s</b>.", framedumpfolder);
+    else
+        C_Warning(0, "Frames couldn't be dumped to <b>%s</b>.", framedumpfolder);
+}
+
 //
 // freeze CCMD
 //
@@ -2130,7 +2355,7 @@ static void give_cmd_func2(char *cmd, char *parms)
 
     if (!*parm)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, GIVECMDFORMAT);
     }
     else
@@ -2450,7 +2675,7 @@ static void if_cmd_func2(char *cmd, char *parms)
 
     if (sscanf(parms, "%63s %63s then %127[^\n]", parm1, parm2, parm3) != 3)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, IFCMDFORMAT);
         return;
     }
@@ -2507,21 +2732,7 @@ static void if_cmd_func2(char *cmd, char *parms)
                 condition = match(vanilla, parm2);
 
             if (condition)
-            {
-                char    *strings[255];
-                int     j = 0;
-
-                M_StripQuotes(parm3);
-                strings[0] = strtok(parm3, ";");
-
-                while (strings[j])
-                {
-                    if (!C_ValidateInput(trimwhitespace(strings[j])))
-                        break;
-
-                    strings[++j] = strtok(NULL, ";");
-                }
-            }
+                C_ExecuteInputString(parm3);
 
             break;
         }
@@ -2645,7 +2856,7 @@ void kill_cmd_func2(char *cmd, char *parms)
 
     if (!*parm)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, KILLCMDFORMAT);
     }
     else
@@ -2926,7 +3137,7 @@ static void load_cmd_func2(char *cmd, char *parms)
 
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, LOADCMDFORMAT);
         return;
     }
@@ -2936,6 +3147,51 @@ static void load_cmd_func2(char *cmd, char *parms)
     G_LoadGame(buffer);
 }
 
+//
+// loadstats CCMD
+//
+static dboolean loadstats_cmd_func1(char *cmd, char *parms)
+{
+    return (numprofiles > 0);
+}
+
+static void loadstats_cmd_func2(char *cmd, char *parms)
+{
+    const int   tabs[4] = { 200, 280, 330, 0 };
+
+    if (*parms)
+    {
+        char    filename[MAX_PATH];
+        char    *appdatafolder = M_GetAppDataFolder();
+
+        M_snprintf(filename, sizeof(filename), "%s" DIR_SEPARATOR_S "%s%s",
+            appdatafolder, parms, (M_StringEndsWith(parms, ".json") ? "" : ".json"));
+        free(appdatafolder);
+
+        if (P_SaveLoadStats(filename))
+            C_Output("Saved how long each part of loading <b>%s</b> took to <b>%s</b>.", mapnum, filename);
+        else
+            C_Warning(0, "<b>%s</b> couldn't be saved.", filename);
+
+        return;
+    }
+
+    C_Output("Loading <b>%s</b>%s took <b>%.2f</b> milliseconds.",
+        mapnum, (levelcacheloaded ? " from the level cache" : ""), I_ProfileTime(profiles));
+
+    for (int i = 1; i < numprofiles; i++)
+    {
+        const profile_t *profile = profiles + i;
+        char            *temp1 = commify(profile->calls);
+        char            *temp2 = commify(profile->bytes);
+
+        C_TabbedOutput(tabs, "%*s%.*s\t<b>%.2fms</b>\t<b>%s</b>\t<b>%s</b> bytes", (profile->depth - 1) * 3, "",
+            profile->namelength, profile->name, I_ProfileTime(profile), temp1, temp2);
+        free(temp1);
+        free(temp2);
+    }
+}
+
 //
 // map CCMD
 //
@@ -3341,7 +3597,7 @@ static void map_cmd_func2(char *cmd, char *parms)
 
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, (gamemission == doom ? MAPCMDFORMAT1 : MAPCMDFORMAT2));
         return;
     }
@@ -4118,7 +4374,7 @@ static void name_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, NAMECMDFORMAT);
     }
     else if (M_StringCompare(namecmdold, "player"))
@@ -4419,7 +4675,7 @@ static void play_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, PLAYCMDFORMAT);
     }
     else if (playcmdtype == 1)
@@ -5489,7 +5745,7 @@ static void print_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, PRINTCMDFORMAT);
     }
     else
@@ -5552,7 +5808,7 @@ static void reset_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, RESETCMDFORMAT);
         return;
     }
@@ -5786,12 +6042,7 @@ static void C_VerifyResetAll(const int key)
         gamepadweapon6 = GAMEPADWEAPON_DEFAULT;
         gamepadweapon7 = GAMEPADWEAPON_DEFAULT;
 
-        // clear all aliases
-        for (int i = 0; i < MAXALIASES; i++)
-        {
-            aliases[i].name[0] = '\0';
-            aliases[i].string[0] = '\0';
-        }
+        C_ClearAliases();
 
         M_SaveCVARs();
 
@@ -6013,7 +6264,7 @@ static void resurrect_cmd_func2(char *cmd, char *parms)
 
     if (!*parm)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, RESURRECTCMDFORMAT);
     }
     else
@@ -6175,7 +6426,7 @@ static void save_cmd_func2(char *cmd, char *parms)
 
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, SAVECMDFORMAT);
         return;
     }
@@ -6245,7 +6496,7 @@ static void spawn_cmd_func2(char *cmd, char *parms)
 
     if (!*parm)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, SPAWNCMDFORMAT);
     }
     else
@@ -6428,7 +6679,7 @@ static void take_cmd_func2(char *cmd, char *parms)
 
     if (!*parm)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, TAKECMDFORMAT);
     }
     else
@@ -6691,7 +6942,7 @@ static void teleport_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, TELEPORTCMDFORMAT);
         return;
     }
@@ -6790,7 +7041,7 @@ static void timer_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, TIMERCMDFORMAT);
         return;
     }
@@ -6826,7 +7077,7 @@ static void unbind_cmd_func2(char *cmd, char *parms)
 {
     if (!*parms)
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
         C_Output("<b>%s</b> %s", cmd, UNBINDCMDFORMAT);
         return;
     }
@@ -7292,7 +7543,7 @@ static void am_gridsize_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (M_StringCompare(am_gridsize, am_gridsize_default))
             C_Output(INTEGERCVARISDEFAULT, am_gridsize);
@@ -7325,7 +7576,7 @@ static void armortype_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (gamestate == GS_LEVEL)
         {
@@ -7377,7 +7628,7 @@ static void crosshair_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(crosshair, CROSSHAIRVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (crosshair == crosshair_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -7470,7 +7721,7 @@ static void gp_deadzone_cvars_func2(char *cmd, char *parms)
     {
         char    *temp1 = striptrailingzero(gp_deadzone_left, 1);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (gp_deadzone_left == gp_deadzone_left_default)
             C_Output(PERCENTCVARISDEFAULT, temp1);
@@ -7485,7 +7736,7 @@ static void gp_deadzone_cvars_func2(char *cmd, char *parms)
     {
         char    *temp1 = striptrailingzero(gp_deadzone_right, 1);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (gp_deadzone_right == gp_deadzone_right_default)
             C_Output(PERCENTCVARISDEFAULT, temp1);
@@ -7582,7 +7833,7 @@ static void player_cvars_func2(char *cmd, char *parms)
         }
         else
         {
-            C_ShowDescription(C_GetIndex(cmd));
+            C_ShowDescription(C_FindConsoleCmd(cmd));
 
             if (gamestate == GS_LEVEL)
             {
@@ -7619,7 +7870,7 @@ static void player_cvars_func2(char *cmd, char *parms)
         }
         else
         {
-            C_ShowDescription(C_GetIndex(cmd));
+            C_ShowDescription(C_FindConsoleCmd(cmd));
 
             if (gamestate == GS_LEVEL)
             {
@@ -7683,7 +7934,7 @@ static void player_cvars_func2(char *cmd, char *parms)
         }
         else
         {
-            C_ShowDescription(C_GetIndex(cmd));
+            C_ShowDescription(C_FindConsoleCmd(cmd));
 
             if (gamestate == GS_LEVEL)
             {
@@ -7728,7 +7979,7 @@ static void r_blood_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_blood, BLOODVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_blood == r_blood_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -7775,7 +8026,7 @@ static void r_bloodsplats_translucency_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_bloodsplats_translucency, BOOLVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_bloodsplats_translucency == r_bloodsplats_translucency_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -7832,7 +8083,7 @@ static void r_detail_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_detail, DETAILVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_detail == r_detail_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -7868,7 +8119,7 @@ static void r_dither_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_dither, BOOLVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_dither == r_dither_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -7906,7 +8157,7 @@ static void r_fixmaperrors_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_fixmaperrors, BOOLVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_fixmaperrors == r_fixmaperrors_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -7975,7 +8226,7 @@ static void r_gamma_cvar_func2(char *cmd, char *parms)
         if (len >= 2 && buffer1[len - 1] == '0' && buffer1[len - 2] == '0')
             buffer1[len - 1] = '\0';
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_gamma == r_gamma_default)
             C_Output(INTEGERCVARISDEFAULT, (r_gamma == 1.0f ? "off" : buffer1));
@@ -8023,7 +8274,7 @@ static void r_hud_translucency_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_hud_translucency, BOOLVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_hud_translucency == r_hud_translucency_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -8054,7 +8305,7 @@ static void r_lowpixelsize_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (M_StringCompare(r_lowpixelsize, r_lowpixelsize_default))
             C_Output(INTEGERCVARISDEFAULT, r_lowpixelsize);
@@ -8063,6 +8314,44 @@ static void r_lowpixelsize_cvar_func2(char *cmd, char *parms)
     }
 }
 
+//
+// r_pvs CVAR
+//
+static void r_pvs_cvar_func2(char *cmd, char *parms)
+{
+    if (*parms)
+    {
+        const int   value = C_LookupValueFromAlias(parms, BOOLVALUEALIAS);
+
+        if ((value == 0 || value == 1) && value != r_pvs)
+        {
+            r_pvs = value;
+            M_SaveCVARs();
+
+            if (gamestate == GS_LEVEL)
+                R_InitPVS(NULL, 0);
+        }
+    }
+    else
+    {
+        char    *temp1 = C_LookupAliasFromValue(r_pvs, BOOLVALUEALIAS);
+
+        C_ShowDescription(C_FindConsoleCmd(cmd));
+
+        if (r_pvs == r_pvs_default)
+            C_Output(INTEGERCVARISDEFAULT, temp1);
+        else
+        {
+            char    *temp2 = C_LookupAliasFromValue(r_pvs_default, BOOLVALUEALIAS);
+
+            C_Output(INTEGERCVARWITHDEFAULT, temp1, temp2);
+            free(temp2);
+        }
+
+        free(temp1);
+    }
+}
+
 //
 // r_screensize CVAR
 //
@@ -8086,7 +8375,7 @@ static void r_screensize_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = commify(r_screensize);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_screensize == r_screensize_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -8132,7 +8421,7 @@ static void r_shadows_translucency_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_shadows_translucency, BOOLVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_shadows_translucency == r_shadows_translucency_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -8219,7 +8508,7 @@ static void r_textures_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_textures, BOOLVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_textures == r_textures_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -8266,7 +8555,7 @@ static void r_translucency_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(r_translucency, BOOLVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (r_translucency == r_translucency_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -8328,7 +8617,7 @@ static void s_volume_cvars_func2(char *cmd, char *parms)
     {
         char    *temp1 = commify(s_musicvolume);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (s_musicvolume == s_musicvolume_default)
             C_Output(PERCENTCVARISDEFAULT, temp1);
@@ -8346,7 +8635,7 @@ static void s_volume_cvars_func2(char *cmd, char *parms)
     {
         char    *temp1 = commify(s_sfxvolume);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (s_sfxvolume == s_sfxvolume_default)
             C_Output(PERCENTCVARISDEFAULT, temp1);
@@ -8437,7 +8726,7 @@ static void turbo_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = commify(turbo);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (turbo == turbo_default)
             C_Output(PERCENTCVARISDEFAULT, temp1);
@@ -8477,7 +8766,7 @@ static void units_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(units, UNITSVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (units == units_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -8617,7 +8906,7 @@ static void vid_scaleapi_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (M_StringCompare(vid_scaleapi, vid_scaleapi_default))
             C_Output(STRINGCVARISDEFAULT, vid_scaleapi);
@@ -8649,7 +8938,7 @@ static void vid_scalefilter_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (M_StringCompare(vid_scalefilter, vid_scalefilter_default))
             C_Output(STRINGCVARISDEFAULT, vid_scalefilter);
@@ -8677,7 +8966,7 @@ static void vid_screenresolution_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (M_StringCompare(vid_screenresolution, vid_screenresolution_default))
             C_Output(INTEGERCVARISDEFAULT, vid_screenresolution);
@@ -8734,7 +9023,7 @@ static void vid_vsync_cvar_func2(char *cmd, char *parms)
     {
         char    *temp1 = C_LookupAliasFromValue(vid_vsync, VSYNCVALUEALIAS);
 
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (vid_vsync == vid_vsync_default)
             C_Output(INTEGERCVARISDEFAULT, temp1);
@@ -8792,7 +9081,7 @@ static void vid_windowpos_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (M_StringCompare(vid_windowpos, vid_windowpos_default))
             C_Output(INTEGERCVARISDEFAULT, vid_windowpos);
@@ -8820,7 +9109,7 @@ static void vid_windowsize_cvar_func2(char *cmd, char *parms)
     }
     else
     {
-        C_ShowDescription(C_GetIndex(cmd));
+        C_ShowDescription(C_FindConsoleCmd(cmd));
 
         if (M_StringCompare(vid_windowsize, vid_windowsize_default))
             C_Output(INTEGERCVARISDEFAULT, vid_windowsize);
@@ -129,7 +129,10 @@ extern dboolean         massacre;
 void alias_cmd_func2(char *cmd, char *parms);
 void bind_cmd_func2(char *cmd, char *parms);
 
+void C_ClearAliases(void);
 dboolean C_ExecuteAlias(const char *alias);
+int C_FindConsoleCmd(const char *name);
 void C_DumpConsoleStringToFile(int index);
+void C_ShutdownConsoleDump(void);
 
 #endif
@@ -104,6 +104,9 @@ static char             consoleinput[255];
 int                     consolestrings = 0;
 size_t                  consolestringsmax = 0;
 
+static char             *consolearena;
+static size_t           consolearenasize;
+
 static size_t           undolevels;
 static undohistory_t    *undohistory;
 
@@ -156,12 +159,103 @@ static int              consolecolors[STRINGTYPES];
 
 dboolean                scrollbardrawn;
 
-static void (*consoletextfunc)(int, int, patch_t *, int, int, int, dboolean, byte *);
+static void (*consoletextfunc)(const textglyph_t *, const int, int, int, const int *, int, byte *);
 
 extern int              framespersecond;
 extern int              refreshrate;
 extern dboolean         quitcmd;
 
+//
+// C_TrimConsoleStrings
+//  Discard the oldest lines once the scrollback is full, moving the lines that
+//  remain, along with their text in the arena, down to follow the first line,
+//  which is kept as it is always the banner, or the blank line left by clear.
+//
+static void C_TrimConsoleStrings(void)
+{
+    const int       count = CONSOLESCROLLBACKMAX / 8;
+    const char      *last = console[consolestrings - 1].string;
+    const size_t    start = console[1].string - consolearena;
+    const size_t    offset = console[count + 1].string - console[1].string;
+    const size_t    top = last + strlen(last) + 1 - consolearena;
+
+    consolestrings -= count;
+    memmove(console + 1, console + count + 1, (consolestrings - 1) * sizeof(*console));
+    memmove(consolearena + start, consolearena + start + offset, top - start - offset);
+
+    for (int i = 1; i < consolestrings; i++)
+    {
+        console[i].string -= offset;
+        console[i].laidout = false;
+    }
+
+    if (inputhistory != -1 && (inputhistory -= count) < 1)
+        inputhistory = -1;
+
+    // keep the console scrolled to the same lines, or to the oldest that remain
+    if (outputhistory != -1 && (outputhistory = MAX(0, outputhistory - count)) + CONSOLELINES >= consolestrings)
+        outputhistory = -1;
+}
+
+//
+// C_AddConsoleString
+//  Add a line to the end of the console with its text copied into the arena,
+//  and return it so the rest can be filled in before it is dumped.
+//
+static console_t *C_AddConsoleString(const char *string, const stringtype_t stringtype)
+{
+    const size_t    len = strlen(string) + 1;
+    size_t          top = 0;
+    console_t       *line;
+
+    if (consolestrings >= CONSOLESCROLLBACKMAX)
+        C_TrimConsoleStrings();
+
+    if (consolestrings >= (int)consolestringsmax)
+        console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
+
+    // the text of each line follows that of the line before it, so anything
+    // after the last line is free
+    if (consolestrings)
+    {
+        const char  *last = console[consolestrings - 1].string;
+
+        top = last + strlen(last) + 1 - consolearena;
+    }
+
+    if (top + len > consolearenasize)
+    {
+        char    *arena;
+
+        if (!consolearenasize)
+            consolearenasize = CONSOLESCROLLBACKMAX * 16;
+
+        while (top + len > consolearenasize)
+            consolearenasize *= 2;
+
+        arena = malloc(consolearenasize);
+
+        if (consolearena)
+        {
+            memcpy(arena, consolearena, top);
+
+            for (int i = 0; i < consolestrings; i++)
+                console[i].string = arena + (console[i].string - consolearena);
+
+            free(consolearena);
+        }
+
+        consolearena = arena;
+    }
+
+    line = &console[consolestrings];
+    memset(line, 0, sizeof(*line));
+    line->string = memcpy(consolearena + top, string, len);
+    line->stringtype = stringtype;
+
+    return line;
+}
+
 void C_Input(const char *string, ...)
 {
     va_list argptr;
@@ -174,13 +268,8 @@ void C_Input(const char *string, ...)
     M_vsnprintf(buffer, CONSOLETEXTMAXLENGTH - 1, string, argptr);
     va_end(argptr);
 
-    if (consolestrings >= (int)consolestringsmax)
-        console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-    M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-    C_DumpConsoleStringToFile(consolestrings);
-    console[consolestrings].truncate = 0;
-    console[consolestrings++].stringtype = inputstring;
+    C_AddConsoleString(buffer, inputstring);
+    C_DumpConsoleStringToFile(consolestrings++);
     inputhistory = -1;
     outputhistory = -1;
     consoleinput[0] = '\0';
@@ -203,13 +292,8 @@ void C_InputNoRepeat(const char *string, ...)
 
     if (!consolestrings || !M_StringStartsWith(console[consolestrings - 1].string, buffer))
     {
-        if (consolestrings >= (int)consolestringsmax)
-            console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-        M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-        C_DumpConsoleStringToFile(consolestrings);
-        console[consolestrings].truncate = 0;
-        console[consolestrings++].stringtype = inputstring;
+        C_AddConsoleString(buffer, inputstring);
+        C_DumpConsoleStringToFile(consolestrings++);
         inputhistory = -1;
         outputhistory = -1;
         consoleinput[0] = '\0';
@@ -261,13 +345,8 @@ void C_Output(const char *string, ...)
     M_vsnprintf(buffer, CONSOLETEXTMAXLENGTH - 1, string, argptr);
     va_end(argptr);
 
-    if (consolestrings >= (int)consolestringsmax)
-        console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-    M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-    C_DumpConsoleStringToFile(consolestrings);
-    console[consolestrings].truncate = 0;
-    console[consolestrings++].stringtype = outputstring;
+    C_AddConsoleString(buffer, outputstring);
+    C_DumpConsoleStringToFile(consolestrings++);
     outputhistory = -1;
 }
 
@@ -284,16 +363,10 @@ void C_OutputWrap(const char *string, ...)
     {
         int len = (int)strlen(buffer);
 
-        if (consolestrings >= (int)consolestringsmax)
-            console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
         if (len <= 100)
         {
-            M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-            console[consolestrings].line = 1;
-            console[consolestrings].truncate = 0;
-            C_DumpConsoleStringToFile(consolestrings);
-            console[consolestrings++].stringtype = outputstring;
+            C_AddConsoleString(buffer, outputstring)->line = 1;
+            C_DumpConsoleStringToFile(consolestrings++);
         }
         else
         {
@@ -316,27 +389,18 @@ void C_OutputWrap(const char *string, ...)
                 truncate--;
 
             temp = M_SubString(buffer, 0, truncate);
-            M_StringCopy(console[consolestrings].string, temp, sizeof(console[consolestrings].string));
+            C_AddConsoleString(temp, outputstring)->line = 1;
             free(temp);
-            console[consolestrings].line = 1;
-            C_DumpConsoleStringToFile(consolestrings);
-            console[consolestrings].truncate = 0;
-            console[consolestrings++].stringtype = outputstring;
-
-            if (consolestrings >= (int)consolestringsmax)
-                console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
+            C_DumpConsoleStringToFile(consolestrings++);
             temp = M_SubString(buffer, truncate, (size_t)len - truncate);
 
             if (*temp)
             {
-                M_StringCopy(console[consolestrings].string, trimwhitespace(temp), sizeof(console[consolestrings].string));
-                free(temp);
-                console[consolestrings].line = 2;
-                C_DumpConsoleStringToFile(consolestrings);
-                console[consolestrings].truncate = 0;
-                console[consolestrings++].stringtype = outputstring;
+                C_AddConsoleString(trimwhitespace(temp), outputstring)->line = 2;
+                C_DumpConsoleStringToFile(consolestrings++);
             }
+
+            free(temp);
         }
 
         outputhistory = -1;
@@ -354,50 +418,35 @@ void C_OutputNoRepeat(const char *string, ...)
 
     if (!consolestrings || !M_StringStartsWith(console[consolestrings - 1].string, buffer))
     {
-        if (consolestrings >= (int)consolestringsmax)
-            console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-        M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-        C_DumpConsoleStringToFile(consolestrings);
-        console[consolestrings].truncate = 0;
-        console[consolestrings++].stringtype = outputstring;
+        C_AddConsoleString(buffer, outputstring);
+        C_DumpConsoleStringToFile(consolestrings++);
         outputhistory = -1;
     }
 }
 
 void C_TabbedOutput(const int tabs[4], const char *string, ...)
 {
-    va_list argptr;
-    char    buffer[CONSOLETEXTMAXLENGTH];
+    va_list     argptr;
+    char        buffer[CONSOLETEXTMAXLENGTH];
+    console_t   *line;
 
     va_start(argptr, string);
     M_vsnprintf(buffer, CONSOLETEXTMAXLENGTH - 1, string, argptr);
     va_end(argptr);
 
-    if (consolestrings >= (int)consolestringsmax)
-        console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-    M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-    console[consolestrings].truncate = 0;
-    console[consolestrings].stringtype = outputstring;
-    memcpy(console[consolestrings].tabs, tabs, sizeof(console[consolestrings].tabs));
-    C_DumpConsoleStringToFile(consolestrings);
-    consolestrings++;
+    line = C_AddConsoleString(buffer, outputstring);
+    memcpy(line->tabs, tabs, sizeof(line->tabs));
+    C_DumpConsoleStringToFile(consolestrings++);
     outputhistory = -1;
 }
 
 void C_Header(const int tabs[4], patch_t *header, const char *string)
 {
-    if (consolestrings >= (int)consolestringsmax)
-        console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
+    console_t   *line = C_AddConsoleString(string, headerstring);
 
-    console[consolestrings].truncate = 0;
-    console[consolestrings].stringtype = headerstring;
-    memcpy(console[consolestrings].tabs, tabs, sizeof(console[consolestrings].tabs));
-    console[consolestrings].header = header;
-    M_StringCopy(console[consolestrings].string, string, sizeof(console[consolestrings].string));
-    C_DumpConsoleStringToFile(consolestrings);
-    consolestrings++;
+    memcpy(line->tabs, tabs, sizeof(line->tabs));
+    line->header = header;
+    C_DumpConsoleStringToFile(consolestrings++);
     outputhistory = -1;
 }
 
@@ -417,16 +466,10 @@ void C_Warning(const int minwarninglevel, const char *string, ...)
     {
         int len = (int)strlen(buffer);
 
-        if (consolestrings >= (int)consolestringsmax)
-            console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
         if (len <= 100 || !warningwidth)
         {
-            M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-            console[consolestrings].line = 1;
-            C_DumpConsoleStringToFile(consolestrings);
-            console[consolestrings].truncate = 0;
-            console[consolestrings++].stringtype = warningstring;
+            C_AddConsoleString(buffer, warningstring)->line = 1;
+            C_DumpConsoleStringToFile(consolestrings++);
         }
         else
         {
@@ -449,27 +492,18 @@ void C_Warning(const int minwarninglevel, const char *string, ...)
                 truncate--;
 
             temp = M_SubString(buffer, 0, truncate);
-            M_StringCopy(console[consolestrings].string, temp, sizeof(console[consolestrings].string));
+            C_AddConsoleString(temp, warningstring)->line = 1;
             free(temp);
-            console[consolestrings].line = 1;
-            C_DumpConsoleStringToFile(consolestrings);
-            console[consolestrings].truncate = 0;
-            console[consolestrings++].stringtype = warningstring;
-
-            if (consolestrings >= (int)consolestringsmax)
-                console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
+            C_DumpConsoleStringToFile(consolestrings++);
             temp = M_SubString(buffer, truncate, (size_t)len - truncate);
 
             if (*temp)
             {
-                M_StringCopy(console[consolestrings].string, trimwhitespace(temp), sizeof(console[consolestrings].string));
-                free(temp);
-                console[consolestrings].line = 2;
-                C_DumpConsoleStringToFile(consolestrings);
-                console[consolestrings].truncate = 0;
-                console[consolestrings++].stringtype = warningstring;
+                C_AddConsoleString(trimwhitespace(temp), warningstring)->line = 2;
+                C_DumpConsoleStringToFile(consolestrings++);
             }
+
+            free(temp);
         }
 
         outputhistory = -1;
@@ -494,16 +528,11 @@ void C_PlayerMessage(const char *string, ...)
     }
     else
     {
-        if (consolestrings >= (int)consolestringsmax)
-            console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-        M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-        console[consolestrings].truncate = 0;
-        console[consolestrings].stringtype = playermessagestring;
-        console[consolestrings].tics = gametime;
-        console[consolestrings].timestamp[0] = '\0';
-        C_DumpConsoleStringToFile(consolestrings);
-        console[consolestrings++].count = 1;
+        console_t   *line = C_AddConsoleString(buffer, playermessagestring);
+
+        line->tics = gametime;
+        line->count = 1;
+        C_DumpConsoleStringToFile(consolestrings++);
     }
 
     outputhistory = -1;
@@ -527,16 +556,11 @@ void C_Obituary(const char *string, ...)
     }
     else
     {
-        if (consolestrings >= (int)consolestringsmax)
-            console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-        M_StringCopy(console[consolestrings].string, buffer, sizeof(console[consolestrings].string));
-        console[consolestrings].truncate = 0;
-        console[consolestrings].stringtype = obituarystring;
-        console[consolestrings].tics = gametime;
-        console[consolestrings].timestamp[0] = '\0';
-        C_DumpConsoleStringToFile(consolestrings);
-        console[consolestrings++].count = 1;
+        console_t   *line = C_AddConsoleString(buffer, obituarystring);
+
+        line->tics = gametime;
+        line->count = 1;
+        C_DumpConsoleStringToFile(consolestrings++);
     }
 
     outputhistory = -1;
@@ -545,7 +569,7 @@ void C_Obituary(const char *string, ...)
 void C_ResetTruncatedLines(void)
 {
     for (int i = 0; i < consolestrings; i++)
-        console[i].truncate = 0;
+        console[i].laidout = false;
 }
 
 static void C_AddToUndoHistory(void)
@@ -562,12 +586,8 @@ void C_AddConsoleDivider(void)
 {
     if (!consolestrings || console[consolestrings - 1].stringtype != dividerstring)
     {
-        if (consolestrings >= (int)consolestringsmax)
-            console = I_Realloc(console, (consolestringsmax += CONSOLESTRINGSMAX) * sizeof(*console));
-
-        C_DumpConsoleStringToFile(consolestrings);
-        console[consolestrings].truncate = 0;
-        console[consolestrings++].stringtype = dividerstring;
+        C_AddConsoleString("", dividerstring);
+        C_DumpConsoleStringToFile(consolestrings++);
     }
 }
 
@@ -842,6 +862,8 @@ void C_Init(void)
     zerowidth = SHORT(consolefont['0' - CONSOLEFONTSTART]->width);
     warningwidth = SHORT(warning->width);
     dotwidth = SHORT(dot->width);
+
+    C_InitAutocomplete();
 }
 
 void C_ShowConsole(void)
@@ -908,43 +930,14 @@ void C_HideConsoleFast(void)
 static void C_DrawBackground(void)
 {
     static dboolean blurred;
-    static byte     blurscreen[MAXSCREENAREA];
+    static blur_t   blur;
+    const byte      *blurscreen = blur.blurscreen;
     int             consolebackcolor = nearestcolors[con_backcolor] << 8;
     int             height = (consoleheight + 5) * CONSOLEWIDTH;
 
-    if (!blurred || !forceconsoleblurredraw)
-    {
-        // blur background
-        memcpy(blurscreen, screens[0], height);
-
-        for (int y = 0; y <= height - CONSOLEWIDTH; y += CONSOLEWIDTH)
-            for (int x = y; x <= y + CONSOLEWIDTH - 2; x++)
-                blurscreen[x] = tinttab50[(blurscreen[x + 1] << 8) + blurscreen[x]];
-
-        for (int y = 0; y <= height - CONSOLEWIDTH; y += CONSOLEWIDTH)
-            for (int x = y + CONSOLEWIDTH - 2; x > y; x--)
-                blurscreen[x] = tinttab50[(blurscreen[x - 1] << 8) + blurscreen[x]];
-
-        for (int y = height - CONSOLEWIDTH; y >= CONSOLEWIDTH; y -= CONSOLEWIDTH)
-            for (int x = y + CONSOLEWIDTH - 1; x >= y + 1; x--)
-                blurscreen[x] = tinttab50[(blurscreen[x - CONSOLEWIDTH - 1] << 8) + blurscreen[x]];
-
-        for (int y = 0; y <= height - CONSOLEWIDTH * 2; y += CONSOLEWIDTH)
-            for (int x = y; x <= y + CONSOLEWIDTH - 1; x++)
-                blurscreen[x] = tinttab50[(blurscreen[x + CONSOLEWIDTH] << 8) + blurscreen[x]];
-
-        for (int y = height - CONSOLEWIDTH; y >= CONSOLEWIDTH; y -= CONSOLEWIDTH)
-            for (int x = y; x <= y + CONSOLEWIDTH - 1; x++)
-                blurscreen[x] = tinttab50[(blurscreen[x - CONSOLEWIDTH] << 8) + blurscreen[x]];
-
-        for (int y = 0; y <= height - CONSOLEWIDTH * 2; y += CONSOLEWIDTH)
-            for (int x = y + CONSOLEWIDTH - 1; x >= y + 1; x--)
-                blurscreen[x] = tinttab50[(blurscreen[x + CONSOLEWIDTH - 1] << 8) + blurscreen[x]];
-
-        for (int y = height - CONSOLEWIDTH; y >= CONSOLEWIDTH; y -= CONSOLEWIDTH)
-            for (int x = y; x <= y + CONSOLEWIDTH - 2; x++)
-                blurscreen[x] = tinttab50[(blurscreen[x - CONSOLEWIDTH + 1] << 8) + blurscreen[x]];
-    }
+    // blur background
+    if (!blurred || !forceconsoleblurredraw || blur.width != CONSOLEWIDTH || blur.height != consoleheight + 5)
+        blurscreen = V_BlurScreen(&blur, screens[0], CONSOLEWIDTH, consoleheight + 5, NULL, NULL, false);
 
     forceconsoleblurredraw = false;
     blurred = (consoleheight == CONSOLEHEIGHT && !dowipe);
@@ -1010,62 +1003,66 @@ static void C_DrawBackground(void)
                 screens[0][j] = colormaps[0][4 * 256 + screens[0][j]];
 }
 
-static int C_DrawConsoleText(int x, int y, char *text, const int color1, const int color2, const int boldcolor,
-    byte *translucency, const int tabs[4], const dboolean formatting, const dboolean kerning, const int index)
+//
+// Console text layout
+// Text is laid out into the glyphs to draw, with any markup parsed, kerning
+// applied and truncation found, so that drawing it is a single pass over its
+// glyphs. Each line of console output is laid out the first time it's
+// drawn, and then kept until it changes.
+//
+enum
 {
-    int             bold = 0;
-    dboolean        italics = false;
-    int             tab = -1;
-    int             len = (int)strlen(text);
-    int             truncate = len;
-    unsigned char   prevletter = '\0';
-    int             width = 0;
-    int             lastcolor1 = color1;
-    int             startx = x;
+    GLYPH_NORMAL,
+    GLYPH_BOLD,
+    GLYPH_ITALICS
+};
 
-    y -= CONSOLEHEIGHT - consoleheight;
+typedef struct
+{
+    textglyph_t     *glyphs;
+    int             numglyphs;
+    int             maxglyphs;
+    int             width;
+} consolelayout_t;
 
-    if (console[index].stringtype == warningstring)
-    {
-        if (console[index].line == 2)
-        {
-            if (text[0] == ' ')
-                width -= spacewidth;
-        }
-        else
-            V_DrawConsoleOutputTextPatch(x, y, warning, warningwidth, color1, color2, false, translucency);
+static consolelayout_t  *consolelayouts;
+static int              numconsolelayouts;
+static consolelayout_t  textlayout;
 
-        width += warningwidth + 1;
-        x += width;
-    }
+static void C_AddGlyph(consolelayout_t *layout, patch_t *patch, int x, int width, byte style, dboolean slanted)
+{
+    textglyph_t *glyph;
 
-    if (console[index].truncate)
-        truncate = console[index].truncate;
-    else if (len > 100)
+    if (layout->numglyphs == layout->maxglyphs)
     {
-        do
-        {
-            char    *temp = M_SubString(text, 0, truncate);
-            int     width2 = C_TextWidth(temp, formatting, kerning) + width + 6;
-
-            free(temp);
-
-            if (width2 <= CONSOLETEXTPIXELWIDTH)
-                break;
-        } while (truncate-- > 0);
-
-        if (truncate == len - 1 && text[truncate] == '.')
-            truncate++;
+        layout->maxglyphs = (layout->maxglyphs ? layout->maxglyphs * 2 : 64);
+        layout->glyphs = I_Realloc(layout->glyphs, layout->maxglyphs * sizeof(*layout->glyphs));
+    }
 
-        if (text[truncate - 1] == ' ')
-            truncate--;
+    glyph = &layout->glyphs[layout->numglyphs++];
+    glyph->patch = patch;
+    glyph->x = x;
+    glyph->width = width;
+    glyph->style = style;
+    glyph->slanted = slanted;
+}
 
-        console[index].truncate = truncate;
-    }
+// Lays out the first truncate characters of text, and returns the x
+// coordinate at the end. If xs isn't NULL, the x coordinate after each
+// character is also stored in it.
+static int C_LayOutConsoleChars(consolelayout_t *layout, int x, const char *text, const int len, const int truncate,
+    const int tabs[4], const dboolean formatting, const dboolean kerning, const dboolean warningcolor, int *xs,
+    unsigned char *lastletter, byte *laststyle)
+{
+    int             bold = 0;
+    dboolean        italics = false;
+    int             tab = -1;
+    unsigned char   prevletter = '\0';
 
     for (int i = 0; i < truncate; i++)
     {
         const unsigned char letter = text[i];
+        const int           start = i;
 
         if (letter == '<' && i < len - 2 && tolower(text[i + 1]) == 'b' && text[i + 2] == '>' && formatting)
         {
@@ -1166,18 +1163,82 @@ static int C_DrawConsoleText(int x, int y, char *text, const int color1, const i
 
             if (patch)
             {
-                int patchwidth = SHORT(patch->width);
+                const int   patchwidth = SHORT(patch->width);
 
-                consoletextfunc(x, y, patch, patchwidth, (lastcolor1 = (bold == 1 ? boldcolor : (bold == 2 ? color1 : (italics ?
-                    (color1 == consolewarningcolor ? color1 : consoleitalicscolor) : color1)))), color2,
-                    (italics && letter != '_' && letter != '-' && letter != '+' && letter != ',' && letter != '/'), translucency);
+                *laststyle = (bold == 1 ? GLYPH_BOLD : (bold == 2 ? GLYPH_NORMAL : (italics && !warningcolor ?
+                    GLYPH_ITALICS : GLYPH_NORMAL)));
+                C_AddGlyph(layout, patch, x, patchwidth, *laststyle,
+                    (italics && letter != '_' && letter != '-' && letter != '+' && letter != ',' && letter != '/'));
                 x += patchwidth;
             }
 
             prevletter = letter;
         }
+
+        if (xs)
+            for (int j = start; j <= MIN(i, len - 1); j++)
+                xs[j + 1] = x;
+    }
+
+    *lastletter = prevletter;
+
+    return x;
+}
+
+static void C_LayOutConsoleText(consolelayout_t *layout, const char *text, const int tabs[4],
+    const dboolean formatting, const dboolean kerning, const dboolean warningcolor, const int index)
+{
+    const int       len = (int)strlen(text);
+    int             truncate = len;
+    int             x = CONSOLETEXTX;
+    unsigned char   prevletter;
+    byte            laststyle = GLYPH_NORMAL;
+
+    layout->numglyphs = 0;
+
+    if (console[index].stringtype == warningstring)
+    {
+        int width = 0;
+
+        if (console[index].line == 2)
+        {
+            if (text[0] == ' ')
+                width -= spacewidth;
+        }
+        else
+            C_AddGlyph(layout, warning, x, warningwidth, GLYPH_NORMAL, false);
+
+        width += warningwidth + 1;
+        x += width;
     }
 
+    // find how much of a long line fits, from where each character ends
+    if (len > 100)
+    {
+        const int   numglyphs = layout->numglyphs;
+        int         *xs = malloc((len + 1) * sizeof(*xs));
+
+        xs[0] = x;
+        C_LayOutConsoleChars(layout, x, text, len, len, tabs, formatting, kerning, warningcolor, xs,
+            &prevletter, &laststyle);
+        layout->numglyphs = numglyphs;
+        laststyle = GLYPH_NORMAL;
+
+        while (truncate > 0 && xs[truncate] - CONSOLETEXTX + 6 > CONSOLETEXTPIXELWIDTH)
+            truncate--;
+
+        free(xs);
+
+        if (truncate == len - 1 && text[truncate] == '.')
+            truncate++;
+
+        if (truncate > 0 && text[truncate - 1] == ' ')
+            truncate--;
+    }
+
+    x = C_LayOutConsoleChars(layout, x, text, len, truncate, tabs, formatting, kerning, warningcolor, NULL,
+        &prevletter, &laststyle);
+
     if (truncate < len)
     {
         if (kerning)
@@ -1188,18 +1249,61 @@ static int C_DrawConsoleText(int x, int y, char *text, const int color1, const i
                     break;
                 }
 
-        consoletextfunc(x, y, dot, dotwidth, lastcolor1, color2, false, translucency);
+        C_AddGlyph(layout, dot, x, dotwidth, laststyle, false);
         x += dotwidth;
-        consoletextfunc(x, y, dot, dotwidth, lastcolor1, color2, false, translucency);
+        C_AddGlyph(layout, dot, x, dotwidth, laststyle, false);
 
-        if (text[truncate - 1] != '.')
+        if (truncate > 0 && text[truncate - 1] != '.')
         {
             x += dotwidth;
-            consoletextfunc(x, y, dot, dotwidth, lastcolor1, color2, false, translucency);
+            C_AddGlyph(layout, dot, x, dotwidth, laststyle, false);
         }
     }
 
-    return (x - startx);
+    layout->width = x - CONSOLETEXTX;
+}
+
+static int C_DrawConsoleLayout(const consolelayout_t *layout, int x, int y, const int color1, const int color2,
+    const int boldcolor, byte *translucency)
+{
+    const int   colors[] = { color1, boldcolor, consoleitalicscolor };
+
+    x -= CONSOLETEXTX;
+    y -= CONSOLEHEIGHT - consoleheight;
+
+    consoletextfunc(layout->glyphs, layout->numglyphs, x, y, colors, color2, translucency);
+
+    return layout->width;
+}
+
+static int C_DrawConsoleText(int x, int y, char *text, const int color1, const int color2, const int boldcolor,
+    byte *translucency, const int tabs[4], const dboolean formatting, const dboolean kerning, const int index)
+{
+    C_LayOutConsoleText(&textlayout, text, tabs, formatting, kerning, (color1 == consolewarningcolor), index);
+
+    return C_DrawConsoleLayout(&textlayout, x, y, color1, color2, boldcolor, translucency);
+}
+
+// Draws a line of console output, laying it out first if it hasn't been.
+static int C_DrawConsoleLine(int y, const int color1, const int boldcolor, const int tabs[4], const int index)
+{
+    if (index >= numconsolelayouts)
+    {
+        const int   count = MAX(index + 1, numconsolelayouts + CONSOLESTRINGSMAX);
+
+        consolelayouts = I_Realloc(consolelayouts, count * sizeof(*consolelayouts));
+        memset(consolelayouts + numconsolelayouts, 0, (count - numconsolelayouts) * sizeof(*consolelayouts));
+        numconsolelayouts = count;
+    }
+
+    if (!console[index].laidout)
+    {
+        C_LayOutConsoleText(&consolelayouts[index], console[index].string, tabs, true, true,
+            (color1 == consolewarningcolor), index);
+        console[index].laidout = true;
+    }
+
+    return C_DrawConsoleLayout(&consolelayouts[index], CONSOLETEXTX, y, color1, NOBACKGROUNDCOLOR, boldcolor, tinttab66);
 }
 
 int C_OverlayWidth(const char *text)
@@ -1421,7 +1525,7 @@ void C_Drawer(void)
         C_DrawScrollbar();
 
         // draw console text
-        consoletextfunc = &V_DrawConsoleOutputTextPatch;
+        consoletextfunc = &V_DrawConsoleOutputText;
 
         if (outputhistory == -1)
         {
@@ -1441,8 +1545,7 @@ void C_Drawer(void)
 
             if (stringtype == playermessagestring || stringtype == obituarystring)
             {
-                int width = C_DrawConsoleText(CONSOLETEXTX, y, console[i].string, consoleplayermessagecolor,
-                                NOBACKGROUNDCOLOR, consoleplayermessagecolor, tinttab66, notabs, true, true, i);
+                int width = C_DrawConsoleLine(y, consoleplayermessagecolor, consoleplayermessagecolor, notabs, i);
 
                 if (console[i].count > 1)
                 {
@@ -1458,8 +1561,7 @@ void C_Drawer(void)
                 C_DrawTimeStamp(CONSOLEWIDTH - CONSOLETEXTX * 2 - CONSOLESCROLLBARWIDTH + 3, y, i);
             }
             else if (stringtype == outputstring)
-                C_DrawConsoleText(CONSOLETEXTX, y, console[i].string, consolecolors[stringtype],
-                    NOBACKGROUNDCOLOR, consoleboldcolor, tinttab66, console[i].tabs, true, true, i);
+                C_DrawConsoleLine(y, consolecolors[stringtype], consoleboldcolor, console[i].tabs, i);
             else if (stringtype == dividerstring)
             {
                 if ((y += 5 - (CONSOLEHEIGHT - consoleheight)) >= CONSOLETOP)
@@ -1474,11 +1576,9 @@ void C_Drawer(void)
                 V_DrawConsolePatch(CONSOLETEXTX, y + 4 - (CONSOLEHEIGHT - consoleheight),
                     console[i].header, consoleedgecolor, CONSOLETEXTPIXELWIDTH + 2);
             else if (stringtype == warningstring)
-                C_DrawConsoleText(CONSOLETEXTX, y, console[i].string, consolecolors[stringtype], NOBACKGROUNDCOLOR,
-                    consolewarningboldcolor, tinttab66, notabs, true, true, i);
+                C_DrawConsoleLine(y, consolecolors[stringtype], consolewarningboldcolor, notabs, i);
             else
-                C_DrawConsoleText(CONSOLETEXTX, y, console[i].string, consolecolors[stringtype], NOBACKGROUNDCOLOR,
-                    consoleboldcolor, tinttab66, notabs, true, true, i);
+                C_DrawConsoleLine(y, consolecolors[stringtype], consoleboldcolor, notabs, i);
         }
 
         if (quitcmd)
@@ -1494,7 +1594,7 @@ void C_Drawer(void)
 
             if (partialinput[0] != '\0')
             {
-                consoletextfunc = &V_DrawConsoleOutputTextPatch;
+                consoletextfunc = &V_DrawConsoleOutputText;
                 x += C_DrawConsoleText(x, CONSOLEHEIGHT - 17, partialinput, consoleinputcolor,
                     NOBACKGROUNDCOLOR, NOBOLDCOLOR, NULL, notabs, false, true, 0);
             }
@@ -1517,7 +1617,7 @@ void C_Drawer(void)
                             screens[0][y * CONSOLEWIDTH + x - 1] = consoleselectedinputbackgroundcolor;
                     }
 
-                    consoletextfunc = &V_DrawConsoleInputTextPatch;
+                    consoletextfunc = &V_DrawConsoleInputText;
                     x += C_DrawConsoleText(x, CONSOLEHEIGHT - 17, partialinput, consoleselectedinputcolor,
                              consoleselectedinputbackgroundcolor, NOBOLDCOLOR, NULL, notabs, false, true, 0);
 
@@ -1578,7 +1678,7 @@ void C_Drawer(void)
                         screens[0][y * CONSOLEWIDTH + x - 1] = consoleselectedinputbackgroundcolor;
                 }
 
-                consoletextfunc = &V_DrawConsoleInputTextPatch;
+                consoletextfunc = &V_DrawConsoleInputText;
                 x += C_DrawConsoleText(x, CONSOLEHEIGHT - 17, partialinput, consoleselectedinputcolor,
                     consoleselectedinputbackgroundcolor, NOBOLDCOLOR, NULL, notabs, false, true, i);
 
@@ -1604,7 +1704,7 @@ void C_Drawer(void)
 
             if (partialinput[0] != '\0')
             {
-                consoletextfunc = &V_DrawConsoleOutputTextPatch;
+                consoletextfunc = &V_DrawConsoleOutputText;
                 C_DrawConsoleText(x, CONSOLEHEIGHT - 17, partialinput, consoleinputcolor,
                     NOBACKGROUNDCOLOR, NOBOLDCOLOR, NULL, notabs, false, true, i);
             }
@@ -1616,89 +1716,88 @@ void C_Drawer(void)
         consoleactive = false;
 }
 
-dboolean C_ExecuteInputString(const char *input)
+// Splits input into a command and its parameters, and finds the CCMD, CVAR or
+// cheat it refers to in consolecmds[], or -1 if there isn't one.
+static int C_ParseInput(const char *input, char *cmd, char *parms)
 {
-    char    *string = M_StringDuplicate(input);
-    char    *strings[255];
-    int     j = 0;
+    const int   length = (int)strlen(input);
+    int         i;
 
-    M_StripQuotes(string);
-    strings[0] = strtok(string, ";");
+    *cmd = '\0';
+    *parms = '\0';
 
-    while (strings[j])
+    // cheats that end in two digits, such as idclev
+    if (length > 2 && length < 128 && isdigit((int)input[length - 2]) && isdigit((int)input[length - 1]))
     {
-        if (!C_ValidateInput(trimwhitespace(strings[j])))
-            break;
+        M_StringCopy(cmd, input, 128);
+        cmd[length - 2] = '\0';
 
-        strings[++j] = strtok(NULL, ";");
+        if ((i = C_FindConsoleCmd(cmd)) >= 0 && consolecmds[i].type == CT_CHEAT && consolecmds[i].parameters)
+        {
+            M_StringCopy(parms, input + length - 2, 3);
+            return i;
+        }
     }
 
-    return true;
+    if ((i = C_FindConsoleCmd(input)) >= 0 && consolecmds[i].type == CT_CHEAT && !consolecmds[i].parameters)
+    {
+        M_StringCopy(cmd, input, 128);
+        return i;
+    }
+
+    *cmd = '\0';
+
+    if (sscanf(input, "%127s %127[^\n]", cmd, parms) > 0)
+    {
+        M_StripQuotes(parms);
+
+        if ((i = C_FindConsoleCmd(cmd)) >= 0 && consolecmds[i].type != CT_CHEAT)
+            return i;
+    }
+
+    return -1;
 }
 
-dboolean C_ValidateInput(char *input)
+static dboolean C_ExecuteParsedInput(const char *input, const char *cmd, char *parms, const int index)
 {
-    const int   length = (int)strlen(input);
-
-    for (int i = 0; *consolecmds[i].name; i++)
+    if (index >= 0)
     {
-        char    cmd[128] = "";
+        consolecmd_t    *consolecmd = &consolecmds[index];
 
-        if (consolecmds[i].type == CT_CHEAT)
+        if (consolecmd->type == CT_CHEAT)
         {
-            if (consolecmds[i].parameters)
+            if (consolecmd->parameters)
             {
-                if (isdigit((int)input[length - 2]) && isdigit((int)input[length - 1]))
-                {
-                    consolecheatparm[0] = input[length - 2];
-                    consolecheatparm[1] = input[length - 1];
-                    consolecheatparm[2] = '\0';
+                M_StringCopy(consolecheatparm, parms, sizeof(consolecheatparm));
 
-                    M_StringCopy(cmd, input, sizeof(cmd));
-                    cmd[length - 2] = '\0';
-
-                    if ((M_StringCompare(cmd, consolecmds[i].name) || M_StringCompare(cmd, consolecmds[i].alternate))
-                        && length == strlen(cmd) + 2
-                        && consolecmds[i].func1(consolecmds[i].name, consolecheatparm))
-                    {
-                        if (gamestate == GS_LEVEL)
-                            M_StringCopy(consolecheat, cmd, sizeof(consolecheat));
+                if (consolecmd->func1(consolecmd->name, consolecheatparm))
+                {
+                    if (gamestate == GS_LEVEL)
+                        M_StringCopy(consolecheat, cmd, sizeof(consolecheat));
 
-                        return true;
-                    }
+                    return true;
                 }
             }
-            else if ((M_StringCompare(input, consolecmds[i].name) || M_StringCompare(input, consolecmds[i].alternate))
-                && consolecmds[i].func1(consolecmds[i].name, ""))
+            else if (consolecmd->func1(consolecmd->name, ""))
             {
                 M_StringCopy(consolecheat, input, sizeof(consolecheat));
                 return true;
             }
         }
-        else
+        else if (consolecmd->func1(consolecmd->name, parms) && (consolecmd->parameters || !*parms))
         {
-            char    parms[128] = "";
-
-            if (sscanf(input, "%127s %127[^\n]", cmd, parms) > 0)
+            if (!executingalias && !resettingcvar)
             {
-                M_StripQuotes(parms);
-
-                if ((M_StringCompare(cmd, consolecmds[i].name) || M_StringCompare(cmd, consolecmds[i].alternate))
-                    && consolecmds[i].func1(consolecmds[i].name, parms)
-                    && (consolecmds[i].parameters || !*parms))
-                {
-                    if (!executingalias && !resettingcvar)
-                    {
-                        if (parms[0] != '\0')
-                            C_Input((input[length - 1] == '%' ? "%s %s%" : "%s %s"), cmd, parms);
-                        else
-                            C_Input("%s%s", cmd, (input[length - 1] == ' ' ? " " : ""));
-                    }
+                const int   length = (int)strlen(input);
 
-                    consolecmds[i].func2(consolecmds[i].name, parms);
-                    return true;
-                }
+                if (parms[0] != '\0')
+                    C_Input((input[length - 1] == '%' ? "%s %s%" : "%s %s"), cmd, parms);
+                else
+                    C_Input("%s%s", cmd, (input[length - 1] == ' ' ? " " : ""));
             }
+
+            consolecmd->func2(consolecmd->name, parms);
+            return true;
         }
     }
 
@@ -1725,6 +1824,165 @@ dboolean C_ValidateInput(char *input)
     return false;
 }
 
+dboolean C_ValidateInput(char *input)
+{
+    char    cmd[128];
+    char    parms[128];
+    int     index = C_ParseInput(input, cmd, parms);
+
+    return C_ExecuteParsedInput(input, cmd, parms, index);
+}
+
+// Strings of commands, such as aliases, bindings and exec files, are split and
+// parsed once into a list of statements, which are cached by their contents.
+#define SCRIPTCACHESIZE 64
+
+typedef struct
+{
+    char    *input;
+    char    *cmd;
+    char    *parms;
+    int     index;
+} consolestatement_t;
+
+typedef struct
+{
+    consolestatement_t  *statements;
+    int                 numstatements;
+    int                 refs;
+} consolescript_t;
+
+typedef struct
+{
+    uint64_t            hash;
+    char                *source;
+    dboolean            lines;
+    consolescript_t     *script;
+} cachedscript_t;
+
+static cachedscript_t   scriptcache[SCRIPTCACHESIZE];
+
+static void C_AddStatement(consolescript_t *script, char *input)
+{
+    char                cmd[128];
+    char                parms[128];
+    const int           index = C_ParseInput(input, cmd, parms);
+    const size_t        inputlen = strlen(input) + 1;
+    const size_t        cmdlen = strlen(cmd) + 1;
+    consolestatement_t  *statement;
+
+    script->statements = I_Realloc(script->statements, (script->numstatements + 1) * sizeof(*script->statements));
+    statement = &script->statements[script->numstatements++];
+
+    // keep all three strings together in one block
+    statement->input = malloc(inputlen + cmdlen + strlen(parms) + 1);
+    statement->cmd = statement->input + inputlen;
+    statement->parms = statement->cmd + cmdlen;
+    strcpy(statement->input, input);
+    strcpy(statement->cmd, cmd);
+    strcpy(statement->parms, parms);
+    statement->index = index;
+}
+
+// Commands are separated by semicolons, unless lines is set, in which case
+// there is one command per line, and lines starting with a semicolon are
+// comments.
+static consolescript_t *C_CompileScript(const char *string, const dboolean lines)
+{
+    consolescript_t *script = calloc(1, sizeof(*script));
+    char            *temp = M_StringDuplicate(string);
+    char            *token = strtok(temp, (lines ? "\r\n" : ";"));
+
+    while (token)
+    {
+        if (!lines || *token != ';')
+        {
+            char    *input = trimwhitespace(token);
+
+            if (!lines || *input)
+                C_AddStatement(script, input);
+        }
+
+        token = strtok(NULL, (lines ? "\r\n" : ";"));
+    }
+
+    free(temp);
+    return script;
+}
+
+static void C_ReleaseScript(consolescript_t *script)
+{
+    if (--script->refs)
+        return;
+
+    for (int i = 0; i < script->numstatements; i++)
+        free(script->statements[i].input);
+
+    free(script->statements);
+    free(script);
+}
+
+static consolescript_t *C_GetScript(const char *string, const dboolean lines)
+{
+    const uint64_t  hash = M_Hash(string, strlen(string), (lines ? ~HASHSEED : HASHSEED));
+    cachedscript_t  *cached = &scriptcache[hash % SCRIPTCACHESIZE];
+
+    // compare the scripts themselves too in case their hashes collide
+    if (!cached->script || cached->hash != hash || cached->lines != lines || strcmp(cached->source, string))
+    {
+        if (cached->script)
+        {
+            C_ReleaseScript(cached->script);
+            free(cached->source);
+        }
+
+        cached->hash = hash;
+        cached->source = M_StringDuplicate(string);
+        cached->lines = lines;
+        cached->script = C_CompileScript(string, lines);
+        cached->script->refs = 1;
+    }
+
+    return cached->script;
+}
+
+//
+// C_ExecuteScript
+//  Execute each command in string in turn. If lines isn't set, stop at the
+//  first command that fails.
+//
+void C_ExecuteScript(const char *string, const dboolean lines)
+{
+    consolescript_t *script = C_GetScript(string, lines);
+
+    // hold on to the script in case running it replaces it in the cache
+    script->refs++;
+
+    for (int i = 0; i < script->numstatements; i++)
+    {
+        consolestatement_t  *statement = &script->statements[i];
+        char                parms[128];
+
+        M_StringCopy(parms, statement->parms, sizeof(parms));
+
+        if (!C_ExecuteParsedInput(statement->input, statement->cmd, parms, statement->index) && !lines)
+            break;
+    }
+
+    C_ReleaseScript(script);
+}
+
+dboolean C_ExecuteInputString(const char *input)
+{
+    char    *string = M_StringDuplicate(input);
+
+    M_StripQuotes(string);
+    C_ExecuteScript(string, false);
+    free(string);
+
+    return true;
+}
+
 dboolean C_Responder(event_t *ev)
 {
     static int  autocomplete = -1;
@@ -1961,6 +2219,8 @@ dboolean C_Responder(event_t *ev)
                     const int   direction = ((modstate & KMOD_SHIFT) ? -1 : 1);
                     const int   start = autocomplete;
                     static char input[255];
+                    static int  first;
+                    static int  last;
                     char        prefix[255] = "";
                     int         spaces1;
                     dboolean    endspace1;
@@ -1995,28 +2255,37 @@ dboolean C_Responder(event_t *ev)
                         }
                     }
 
+                    // only the entries that start with the input need to be looked at
+                    if (autocomplete == -1)
+                    {
+                        first = C_FindAutocompletes(input, &last);
+                        autocomplete = first - 1;
+                    }
+
                     spaces1 = numspaces(input);
                     endspace1 = (input[strlen(input) - 1] == ' ');
 
-                    while ((direction == -1 && autocomplete > 0) || (direction == 1 && autocompletelist[autocomplete].game))
+                    while ((direction == -1 && autocomplete > first) || (direction == 1 && autocomplete < last - 1))
                     {
-                        static char output[255];
-                        int         spaces2;
-                        dboolean    endspace2;
-                        int         len2;
-                        int         game;
+                        static char             output[255];
+                        int                     spaces2;
+                        dboolean                endspace2;
+                        int                     len2;
+                        int                     game;
+                        const autocomplete_t    *entry;
 
                         autocomplete += direction;
+                        entry = C_GetAutocomplete(autocomplete);
 
                         if (GetCapsLockState())
                         {
-                            char    *temp = uppercase(autocompletelist[autocomplete].text);
+                            char    *temp = uppercase(entry->text);
 
                             M_StringCopy(output, temp, sizeof(output));
                             free(temp);
                         }
                         else
-                            M_StringCopy(output, autocompletelist[autocomplete].text, sizeof(output));
+                            M_StringCopy(output, entry->text, sizeof(output));
 
                         if (M_StringCompare(output, input))
                             continue;
@@ -2024,12 +2293,11 @@ dboolean C_Responder(event_t *ev)
                         len2 = (int)strlen(output);
                         spaces2 = numspaces(output);
                         endspace2 = (len2 > 0 && output[len2 - 1] == ' ');
-                        game = autocompletelist[autocomplete].game;
+                        game = entry->game;
 
                         if ((game == DOOM1AND2
                             || (gamemission == doom && game == DOOM1ONLY)
                             || (gamemission != doom && game == DOOM2ONLY))
-                            && M_StringStartsWith(output, input)
                             && input[strlen(input) - 1] != '+'
                             && ((!spaces1 && (!spaces2 || (spaces2 == 1 && endspace2)))
                                 || (spaces1 == 1 && !endspace1 && (spaces2 == 1 || (spaces2 == 2 && endspace2)))
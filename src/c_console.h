@@ -45,6 +45,7 @@
 #include "r_defs.h"
 
 #define CONSOLESTRINGSMAX       256
+#define CONSOLESCROLLBACKMAX    8192
 
 #define CONSOLEFONTSTART        ' '
 #define CONSOLEFONTEND          '~'
@@ -109,10 +110,10 @@ typedef enum
 
 typedef struct
 {
-    char                string[1024];
+    char                *string;
     unsigned int        count;
     unsigned int        line;
-    unsigned int        truncate;
+    dboolean            laidout;
     stringtype_t        stringtype;
     patch_t             *header;
     int                 tabs[4];
@@ -192,6 +193,7 @@ void C_HideConsole(void);
 void C_HideConsoleFast(void);
 void C_Drawer(void);
 dboolean C_ExecuteInputString(const char *input);
+void C_ExecuteScript(const char *string, const dboolean lines);
 dboolean C_ValidateInput(char *input);
 dboolean C_Responder(event_t *ev);
 void C_PrintCompileDate(void);
@@ -201,4 +203,10 @@ void C_UpdateTimer(void);
 char *C_CreateTimeStamp(int index);
 void C_ResetTruncatedLines(void);
 
+void C_InitAutocomplete(void);
+int C_FindAutocompletes(const char *text, int *end);
+const autocomplete_t *C_GetAutocomplete(const int index);
+void C_AddAutocomplete(const char *text, const int game);
+void C_RemoveAutocomplete(const char *text);
+
 #endif
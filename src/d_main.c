@@ -417,6 +417,7 @@ void D_Display(void)
         // normal update
         blitfunc();
         mapblitfunc();
+        V_DumpFrame();
 
 #if defined(_WIN32)
         if (CapFPSEvent)
@@ -446,6 +447,8 @@ void D_Display(void)
         wipestart = nowtime;
         done = wipe_ScreenWipe();
 
+        S_UpdateMusic();
+
         blitfunc();
         mapblitfunc();
 
@@ -480,6 +483,7 @@ static void D_DoomLoop(void)
         TryRunTics();       // will run at least one tic
 
         S_UpdateSounds();   // move positional sounds
+        S_UpdateMusic();    // play music once it has loaded
 
         // Update display, next frame, with current state.
         D_Display();
@@ -43,9 +43,34 @@
 #include "c_console.h"
 #include "i_midirpc.h"
 #include "m_config.h"
+#include "m_misc.h"
 #include "mmus2mid.h"
 #include "s_sound.h"
 
+// MUS lumps that have already been converted to MIDI, keyed by a hash of
+// the lump, so each is only converted once
+typedef struct musiccache_s
+{
+    uint64_t                hash;
+    int                     size;
+    uint8_t                 *mid;
+    int                     midlen;
+    struct musiccache_s     *next;
+} musiccache_t;
+
+// A song being converted in the background
+typedef struct
+{
+    void                    *data;
+    int                     size;
+    void                    *mid;
+    int                     midlen;
+    dboolean                midi;
+    dboolean                mus;
+    dboolean                pending;
+    dboolean                done;
+} songload_t;
+
 dboolean        midimusictype;
 dboolean        musmusictype;
 
@@ -54,6 +79,17 @@ static dboolean music_initialized;
 static int      current_music_volume;
 static int      paused_midi_volume;
 
+static musiccache_t *musiccache;
+static SDL_mutex    *convertmutex;
+
+static songload_t   songload;
+static SDL_Thread   *songloadthread;
+static SDL_mutex    *songloadmutex;
+static SDL_cond     *songloadcond;
+static dboolean     songloadshutdown;
+
+static int SDLCALL I_SongLoadThread(void *data);
+
 #if defined(_WIN32)
 static dboolean midirpc;
 dboolean        serverMidiPlaying;
@@ -67,6 +103,24 @@ void I_ShutdownMusic(void)
 
     Mix_FadeOutMusic(500);
     while (Mix_PlayingMusic());
+
+    I_CancelSong();
+
+    SDL_LockMutex(songloadmutex);
+    songloadshutdown = true;
+    SDL_CondBroadcast(songloadcond);
+    SDL_UnlockMutex(songloadmutex);
+    SDL_WaitThread(songloadthread, NULL);
+
+    while (musiccache)
+    {
+        musiccache_t    *next = musiccache->next;
+
+        free(musiccache->mid);
+        free(musiccache);
+        musiccache = next;
+    }
+
     music_initialized = false;
 
     if (mus_playing)
@@ -104,6 +158,11 @@ dboolean I_InitMusic(void)
 
     SDL_PauseAudio(0);
 
+    convertmutex = SDL_CreateMutex();
+    songloadmutex = SDL_CreateMutex();
+    songloadcond = SDL_CreateCond();
+    songloadthread = SDL_CreateThread(I_SongLoadThread, "I_SongLoadThread", NULL);
+
     music_initialized = true;
 
 #if defined(_WIN32)
@@ -228,60 +287,222 @@ void I_UnRegisterSong(void *handle)
         Mix_FreeMusic(handle);
 }
 
-void *I_RegisterSong(void *data, int size)
+//
+// I_ConvertSong
+//  Convert a MUS lump to MIDI, or use the MIDI it was previously converted to.
+//  The MIDI data returned is owned by the cache, and must not be freed.
+//
+static dboolean I_ConvertSong(void *data, int size, uint8_t **mid, int *midlen)
 {
-    if (!music_initialized)
-        return NULL;
-    else
-    {
-        Mix_Music   *music = NULL;
-        SDL_RWops   *rwops = NULL;
+    const uint64_t  hash = M_Hash(data, size, HASHSEED);
+    musiccache_t    *cache;
+    MIDI            mididata;
+    dboolean        result = false;
 
-        midimusictype = false;
-        musmusictype = false;
+    SDL_LockMutex(convertmutex);
 
-        // Check for MIDI or MUS format first:
-        if (size >= 14)
+    for (cache = musiccache; cache; cache = cache->next)
+        if (cache->hash == hash && cache->size == size)
         {
-            if (!memcmp(data, "MThd", 4))                       // is it a MIDI?
-                midimusictype = true;
-            else if (mmuscheckformat((uint8_t *)data, size))    // is it a MUS?
-            {
-                MIDI    mididata;
-                uint8_t *mid;
-                int     midlen;
+            *mid = cache->mid;
+            *midlen = cache->midlen;
+            SDL_UnlockMutex(convertmutex);
+            return true;
+        }
 
-                musmusictype = true;
+    memset(&mididata, 0, sizeof(MIDI));
 
-                memset(&mididata, 0, sizeof(MIDI));
+    if (mmus2mid((uint8_t *)data, (size_t)size, &mididata))
+    {
+        MIDIToMidi(&mididata, mid, midlen);
 
-                if (!mmus2mid((uint8_t *)data, (size_t)size, &mididata))
-                    return NULL;
+        if (*mid)
+        {
+            cache = malloc(sizeof(*cache));
+            cache->hash = hash;
+            cache->size = size;
+            cache->mid = *mid;
+            cache->midlen = *midlen;
+            cache->next = musiccache;
+            musiccache = cache;
+            result = true;
+        }
+    }
+
+    FreeMIDIData(&mididata);
+    SDL_UnlockMutex(convertmutex);
 
-                // Hurrah! Let's make it a mid and give it to SDL_mixer
-                MIDIToMidi(&mididata, &mid, &midlen);
+    return result;
+}
 
-                FreeMIDIData(&mididata);
+//
+// I_LoadSongData
+//  Identify the format of a song, converting it from MUS to MIDI if needed.
+//  This is called from the song loading thread, so mustn't call SDL_mixer.
+//
+static void I_LoadSongData(songload_t *load)
+{
+    load->mid = load->data;
+    load->midlen = load->size;
+    load->midi = false;
+    load->mus = false;
 
-                data = mid;
-                size = midlen;
-                midimusictype = true;                           // now it's a MIDI
+    // Check for MIDI or MUS format first:
+    if (load->size >= 14)
+    {
+        if (!memcmp(load->data, "MThd", 4))                         // is it a MIDI?
+            load->midi = true;
+        else if (mmuscheckformat((uint8_t *)load->data, load->size)) // is it a MUS?
+        {
+            uint8_t *mid;
+            int     midlen;
+
+            load->mus = true;
+
+            if (!I_ConvertSong(load->data, load->size, &mid, &midlen))
+            {
+                load->mid = NULL;
+                return;
             }
+
+            // Hurrah! Let's make it a mid and give it to SDL_mixer
+            load->mid = mid;
+            load->midlen = midlen;
+            load->midi = true;                                      // now it's a MIDI
         }
+    }
+}
+
+//
+// I_FinishSong
+//  Register a song once its data has been converted, loading it using
+//  SDL_mixer unless the MIDI RPC server will play it. Must be called from the
+//  main thread.
+//
+static void *I_FinishSong(songload_t *load)
+{
+    SDL_RWops   *rwops;
+
+    midimusictype = load->midi;
+    musmusictype = load->mus;
+
+    if (!load->mid)
+        return NULL;
 
 #if defined(_WIN32)
-        // Check for option to invoke RPC server if is MIDI
-        if (midimusictype && midirpc)
-            if (I_MidiRPCRegisterSong(data, size))
-            {
-                serverMidiPlaying = true;
-                return NULL;        // server will play this song
-            }
+    // Check for option to invoke RPC server if is MIDI
+    if (midimusictype && midirpc && I_MidiRPCRegisterSong(load->mid, load->midlen))
+    {
+        serverMidiPlaying = true;
+        return NULL;            // server will play this song
+    }
 #endif
 
-        if ((rwops = SDL_RWFromMem(data, size)))
-            music = Mix_LoadMUS_RW(rwops, SDL_FALSE);
+    if (!(rwops = SDL_RWFromMem(load->mid, load->midlen)))
+        return NULL;
+
+    return Mix_LoadMUS_RW(rwops, SDL_FALSE);
+}
+
+static int SDLCALL I_SongLoadThread(void *data)
+{
+    SDL_LockMutex(songloadmutex);
+
+    while (true)
+    {
+        while (!songloadshutdown && !(songload.pending && !songload.done))
+            SDL_CondWait(songloadcond, songloadmutex);
+
+        if (songloadshutdown)
+            break;
+
+        SDL_UnlockMutex(songloadmutex);
+        I_LoadSongData(&songload);
+        SDL_LockMutex(songloadmutex);
+
+        songload.done = true;
+        SDL_CondBroadcast(songloadcond);
+    }
+
+    SDL_UnlockMutex(songloadmutex);
+    return 0;
+}
 
-        return music;
+//
+// I_RegisterSongAsync
+//  Start converting a song on the song loading thread, or convert it straight
+//  away if there isn't one. The data must remain valid until I_SongLoaded()
+//  returns true or I_CancelSong() is called.
+//
+void I_RegisterSongAsync(void *data, int size)
+{
+    if (!music_initialized)
+        return;
+
+    I_CancelSong();
+
+    SDL_LockMutex(songloadmutex);
+    songload.data = data;
+    songload.size = size;
+    songload.pending = true;
+
+    // convert the song now if the song loading thread couldn't be created
+    if (!songloadthread)
+    {
+        I_LoadSongData(&songload);
+        songload.done = true;
     }
+    else
+    {
+        songload.done = false;
+        SDL_CondBroadcast(songloadcond);
+    }
+
+    SDL_UnlockMutex(songloadmutex);
+}
+
+//
+// I_SongLoaded
+//  Returns true, and the song's handle, once a song started by
+//  I_RegisterSongAsync() has been loaded.
+//
+dboolean I_SongLoaded(void **handle)
+{
+    dboolean    done;
+
+    if (!music_initialized)
+    {
+        *handle = NULL;
+        return true;
+    }
+
+    SDL_LockMutex(songloadmutex);
+    done = (songload.pending && songload.done);
+    SDL_UnlockMutex(songloadmutex);
+
+    if (!done)
+        return false;
+
+    songload.pending = false;
+    *handle = I_FinishSong(&songload);
+
+    return true;
+}
+
+//
+// I_CancelSong
+//  Wait for any song still being converted, and discard it.
+//
+void I_CancelSong(void)
+{
+    if (!songloadmutex)
+        return;
+
+    SDL_LockMutex(songloadmutex);
+
+    while (songload.pending && !songload.done)
+        SDL_CondWait(songloadcond, songloadmutex);
+
+    songload.pending = false;
+    SDL_UnlockMutex(songloadmutex);
 }
@@ -48,6 +48,7 @@
 #define PC  "PC"
 #endif
 
+#include "c_cmds.h"
 #include "c_console.h"
 #include "d_main.h"
 #include "i_gamepad.h"
@@ -55,6 +56,7 @@
 #include "m_config.h"
 #include "m_misc.h"
 #include "s_sound.h"
+#include "v_video.h"
 #include "version.h"
 
 #if defined(_WIN32)
@@ -225,6 +227,7 @@ void I_Quit(dboolean shutdown)
     {
         D_FadeScreenToBlack();
 
+        V_ShutdownCapture();
         S_Shutdown();
 
         M_SaveCVARs();
@@ -235,6 +238,8 @@ void I_Quit(dboolean shutdown)
         I_ShutdownTimer();
     }
 
+    C_ShutdownConsoleDump();
+
 #if defined(_WIN32)
     I_ShutdownWindows32();
 #endif
@@ -257,7 +262,9 @@ void I_Error(const char *error, ...)
         already_quitting = true;
 
     // Shutdown. Here might be other errors.
+    V_ShutdownCapture();
     S_Shutdown();
+    C_ShutdownConsoleDump();
 
 #if defined(_WIN32)
     if (previouswad)
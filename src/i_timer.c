@@ -39,6 +39,8 @@
 #include "SDL.h"
 
 #include "doomdef.h"
+#include "i_timer.h"
+#include "z_zone.h"
 
 //
 // I_GetTime
@@ -75,3 +77,99 @@ void I_ShutdownTimer(void)
 {
     SDL_QuitSubSystem(SDL_INIT_TIMER);
 }
+
+//
+// Profiling
+//
+// Scopes between I_StartProfile() and I_EndProfile() are timed using the
+// high-resolution counter, and may be nested. Each scope is recorded once for
+// each scope it is nested in, along with the number of times it was entered,
+// the total time spent in it and the number of bytes allocated by Z_Malloc()
+// while it was open. Only scopes entered on the thread that called
+// I_StartProfiling() are recorded.
+//
+profile_t           profiles[MAXPROFILES];
+int                 numprofiles;
+
+static dboolean     profiling;
+static SDL_threadID profilingthread;
+static int          profilestack[MAXPROFILEDEPTH];
+static uint64_t     profilecounter[MAXPROFILEDEPTH];
+static uint64_t     profilebytes[MAXPROFILEDEPTH];
+static int          profiledepth;
+
+void I_StartProfiling(void)
+{
+    numprofiles = 0;
+    profiledepth = 0;
+    profilingthread = SDL_ThreadID();
+    profiling = true;
+}
+
+void I_StopProfiling(void)
+{
+    profiling = false;
+}
+
+void I_StartProfile(const char *name)
+{
+    int parent = -1;
+    int i;
+
+    if (!profiling || SDL_ThreadID() != profilingthread)
+        return;
+
+    if (profiledepth++ >= MAXPROFILEDEPTH)
+        return;
+
+    for (i = profiledepth - 2; i >= 0 && parent == -1; i--)
+        parent = profilestack[i];
+
+    for (i = 0; i < numprofiles; i++)
+        if (profiles[i].parent == parent && profiles[i].name == name)
+            break;
+
+    if (i == numprofiles)
+    {
+        if (numprofiles == MAXPROFILES)
+        {
+            // no room, so count this scope as part of its parent
+            profilestack[profiledepth - 1] = -1;
+            return;
+        }
+
+        profiles[i].name = name;
+        profiles[i].namelength = (int)strcspn(name, "(");
+        profiles[i].parent = parent;
+        profiles[i].depth = profiledepth - 1;
+        profiles[i].calls = 0;
+        profiles[i].counter = 0;
+        profiles[i].bytes = 0;
+        numprofiles++;
+    }
+
+    profiles[i].calls++;
+    profilestack[profiledepth - 1] = i;
+    profilecounter[profiledepth - 1] = SDL_GetPerformanceCounter();
+    profilebytes[profiledepth - 1] = zonebytes;
+}
+
+void I_EndProfile(void)
+{
+    int i;
+
+    if (!profiling || SDL_ThreadID() != profilingthread || !profiledepth)
+        return;
+
+    if (--profiledepth >= MAXPROFILEDEPTH || (i = profilestack[profiledepth]) == -1)
+        return;
+
+    profiles[i].counter += SDL_GetPerformanceCounter() - profilecounter[profiledepth];
+    profiles[i].bytes += zonebytes - profilebytes[profiledepth];
+}
+
+// Returns the total time spent in a scope in milliseconds.
+double I_ProfileTime(const profile_t *profile)
+{
+    return (profile->counter * 1000.0 / SDL_GetPerformanceFrequency());
+}
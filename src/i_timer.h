@@ -39,6 +39,8 @@
 #if !defined(__I_TIMER_H__)
 #define __I_TIMER_H__
 
+#include "doomtype.h"
+
 // Called by D_DoomLoop,
 // returns current time in tics.
 int I_GetTime(void);
@@ -54,4 +56,27 @@ void I_InitTimer(void);
 
 void I_ShutdownTimer(void);
 
+#define MAXPROFILES     64
+#define MAXPROFILEDEPTH 8
+
+typedef struct
+{
+    const char  *name;
+    int         namelength;
+    int         parent;
+    int         depth;
+    int         calls;
+    uint64_t    counter;
+    uint64_t    bytes;
+} profile_t;
+
+extern profile_t    profiles[MAXPROFILES];
+extern int          numprofiles;
+
+void I_StartProfiling(void);
+void I_StopProfiling(void);
+void I_StartProfile(const char *name);
+void I_EndProfile(void);
+double I_ProfileTime(const profile_t *profile);
+
 #endif
@@ -85,6 +85,9 @@ int WIDEFOVDELTA;
 #define MAXUPSCALEWIDTH         (2160 / VANILLAWIDTH)
 #define MAXUPSCALEHEIGHT        (1200 / VANILLAHEIGHT)
 
+#define NUMPLAYPALS             14
+#define NUMFADESTEPS            10
+
 #define SHAKEANGLE              ((double)M_BigRandomInt(-1000, 1000) * r_shake_damage / 100000.0)
 
 #if !defined(SDL_VIDEO_RENDER_D3D11)
@@ -126,9 +129,23 @@ static SDL_Surface  *buffer;
 static byte         *pixels;
 static int          pitch;
 static SDL_Palette  *palette;
-static SDL_Color    colors[256];
+static SDL_Color    *colors;
+static uint32_t     *rgba;
+static dboolean     rgbabuffer;
+static dboolean     palettechanged;
+static dboolean     blending;
+static int          blendalpha;
 byte                *PLAYPAL;
 
+static SDL_Color    palettecolors[NUMPLAYPALS + NUMFADESTEPS][256];
+static uint32_t     palettergba[NUMPLAYPALS + NUMFADESTEPS][256];
+static SDL_Color    scratchcolors[256];
+static uint32_t     scratchrgba[256];
+static int          numplaypals;
+static int          bakedgammaindex = -1;
+static int          bakedcolor = -1;
+static uint32_t     bakedformat;
+
 static byte         *oscreen;
 byte                *mapscreen;
 SDL_Window          *mapwindow = NULL;
@@ -853,10 +870,71 @@ static void CalculateFPS(void)
         C_UpdateFPS();
 }
 
+//
+// UpdateBuffer
+//  Convert the 8-bit screen into the buffer surface using the packed colors
+//  of the current palette, only falling back to SDL's blitter if the buffer
+//  isn't 32-bit. For motion blur, each converted pixel is blended with what
+//  was left in the buffer by the previous frame, two channels at a time.
+//
+static void UpdateBuffer(void)
+{
+    if (rgbabuffer)
+    {
+        byte    *src = surface->pixels;
+        byte    *dest = pixels;
+
+        if (blending)
+        {
+            const uint32_t  alpha = blendalpha;
+            const uint32_t  invalpha = 256 - blendalpha;
+
+            for (int y = 0; y < SCREENHEIGHT; y++)
+            {
+                uint32_t    *row = (uint32_t *)dest;
+
+                for (int x = 0; x < SCREENWIDTH; x++)
+                {
+                    const uint32_t  color = rgba[src[x]];
+                    const uint32_t  prev = row[x];
+                    const uint32_t  rb = ((color & 0x00FF00FF) * alpha + (prev & 0x00FF00FF) * invalpha) >> 8;
+                    const uint32_t  ag = ((color >> 8) & 0x00FF00FF) * alpha + ((prev >> 8) & 0x00FF00FF) * invalpha;
+
+                    row[x] = (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+                }
+
+                src += surface->pitch;
+                dest += pitch;
+            }
+        }
+        else
+            for (int y = 0; y < SCREENHEIGHT; y++)
+            {
+                uint32_t    *row = (uint32_t *)dest;
+
+                for (int x = 0; x < SCREENWIDTH; x++)
+                    row[x] = rgba[src[x]];
+
+                src += surface->pitch;
+                dest += pitch;
+            }
+    }
+    else
+    {
+        if (palettechanged)
+        {
+            SDL_SetPaletteColors(palette, colors, 0, 256);
+            palettechanged = false;
+        }
+
+        SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    }
+}
+
 #if defined(_WIN32)
 void I_WindowResizeBlit(void)
 {
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
 
@@ -878,7 +956,7 @@ static void I_Blit(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
@@ -889,7 +967,7 @@ static void I_Blit_NearestLinear(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
@@ -904,7 +982,7 @@ static void I_Blit_ShowFPS(void)
     UpdateGrab();
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
@@ -916,7 +994,7 @@ static void I_Blit_NearestLinear_ShowFPS(void)
     UpdateGrab();
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
@@ -930,7 +1008,7 @@ static void I_Blit_Shake(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
@@ -942,7 +1020,7 @@ static void I_Blit_NearestLinear_Shake(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
@@ -958,7 +1036,7 @@ static void I_Blit_ShowFPS_Shake(void)
     UpdateGrab();
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
@@ -971,7 +1049,7 @@ static void I_Blit_NearestLinear_ShowFPS_Shake(void)
     UpdateGrab();
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+    UpdateBuffer();
     SDL_UpdateTexture(texture, &src_rect, pixels, pitch);
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
@@ -984,6 +1062,10 @@ static void I_Blit_NearestLinear_ShowFPS_Shake(void)
 
 static void I_Blit_Automap(void)
 {
+    if (!mapwindowredraw)
+        return;
+
+    mapwindowredraw = false;
     SDL_LowerBlit(mapsurface, &map_rect, mapbuffer, &map_rect);
     SDL_UpdateTexture(maptexture, &map_rect, mappixels, mappitch);
     SDL_RenderClear(maprenderer);
@@ -993,6 +1075,10 @@ static void I_Blit_Automap(void)
 
 static void I_Blit_Automap_NearestLinear(void)
 {
+    if (!mapwindowredraw)
+        return;
+
+    mapwindowredraw = false;
     SDL_LowerBlit(mapsurface, &map_rect, mapbuffer, &map_rect);
     SDL_UpdateTexture(maptexture, &map_rect, mappixels, mappitch);
     SDL_RenderClear(maprenderer);
@@ -1018,17 +1104,24 @@ void I_UpdateBlitFunc(dboolean shake)
 }
 
 //
-// I_SetPalette
+// Palette LUTs
 //
-void I_SetPalette(byte *playpal)
+// All PLAYPAL palettes, and the steps used to fade PLAYPAL to black, are baked
+// for the current gamma correction level and r_color CVAR into SDL_Colors and
+// colors packed in the format of the 32-bit buffer surface. Switching palettes
+// is then just a matter of changing pointers, and the packed colors are used
+// directly when converting the 8-bit screen.
+//
+static void BakePalette(byte *playpal, double brightness, SDL_Color *dest, uint32_t *destrgba)
 {
     if (r_color == r_color_max)
     {
         for (int i = 0; i < 256; i++)
         {
-            colors[i].r = gammatable[gammaindex][*playpal++];
-            colors[i].g = gammatable[gammaindex][*playpal++];
-            colors[i].b = gammatable[gammaindex][*playpal++];
+            dest[i].r = (byte)(gammatable[gammaindex][*playpal++] * brightness);
+            dest[i].g = (byte)(gammatable[gammaindex][*playpal++] * brightness);
+            dest[i].b = (byte)(gammatable[gammaindex][*playpal++] * brightness);
+            dest[i].a = SDL_ALPHA_OPAQUE;
         }
     }
     else
@@ -1037,28 +1130,73 @@ void I_SetPalette(byte *playpal)
 
         for (int i = 0; i < 256; i++)
         {
-            byte    r = gammatable[gammaindex][*playpal++];
-            byte    g = gammatable[gammaindex][*playpal++];
-            byte    b = gammatable[gammaindex][*playpal++];
-            double  p = sqrt((double)r * r * 0.299 + (double)g * g * 0.587 + (double)b * b * 0.114);
-
-            colors[i].r = (byte)(p + (r - p) * color);
-            colors[i].g = (byte)(p + (g - p) * color);
-            colors[i].b = (byte)(p + (b - p) * color);
+            double  r = gammatable[gammaindex][*playpal++] * brightness;
+            double  g = gammatable[gammaindex][*playpal++] * brightness;
+            double  b = gammatable[gammaindex][*playpal++] * brightness;
+            double  p = sqrt(r * r * 0.299 + g * g * 0.587 + b * b * 0.114);
+
+            dest[i].r = (byte)(p + (r - p) * color);
+            dest[i].g = (byte)(p + (g - p) * color);
+            dest[i].b = (byte)(p + (b - p) * color);
+            dest[i].a = SDL_ALPHA_OPAQUE;
         }
     }
 
-    SDL_SetPaletteColors(palette, colors, 0, 256);
+    if (rgbabuffer)
+        for (int i = 0; i < 256; i++)
+            destrgba[i] = SDL_MapRGB(buffer->format, dest[i].r, dest[i].g, dest[i].b);
+}
+
+static void BakePaletteLUTs(void)
+{
+    numplaypals = MIN(W_LumpLength(W_GetNumForName("PLAYPAL")) / 768, NUMPLAYPALS);
+
+    for (int i = 0; i < numplaypals; i++)
+        BakePalette(&PLAYPAL[i * 768], 1.0, palettecolors[i], palettergba[i]);
+
+    for (int i = 0; i < NUMFADESTEPS; i++)
+        BakePalette(PLAYPAL, (double)i / NUMFADESTEPS, palettecolors[NUMPLAYPALS + i], palettergba[NUMPLAYPALS + i]);
+
+    bakedgammaindex = gammaindex;
+    bakedcolor = r_color;
+    bakedformat = buffer->format->format;
+}
+
+static void ApplyPalette(SDL_Color *newcolors, uint32_t *newrgba)
+{
+    colors = newcolors;
+    rgba = newrgba;
+    palettechanged = true;
 
     if (vid_pillarboxes)
         SDL_SetRenderDrawColor(renderer, colors[0].r, colors[0].g, colors[0].b, SDL_ALPHA_OPAQUE);
 }
 
+//
+// I_SetPalette
+//
+void I_SetPalette(byte *playpal)
+{
+    const int   index = (int)(playpal - PLAYPAL) / 768;
+
+    if (gammaindex != bakedgammaindex || r_color != bakedcolor || buffer->format->format != bakedformat)
+        BakePaletteLUTs();
+
+    if (playpal >= PLAYPAL && index < numplaypals && playpal == &PLAYPAL[index * 768])
+        ApplyPalette(palettecolors[index], palettergba[index]);
+    else
+    {
+        BakePalette(playpal, 1.0, scratchcolors, scratchrgba);
+        ApplyPalette(scratchcolors, scratchrgba);
+    }
+}
+
 void I_SetExternalAutomapPalette(void)
 {
     if (mappalette)
     {
         SDL_SetPaletteColors(mappalette, colors, 0, 256);
+        mapwindowredraw = true;
         mapblitfunc();
     }
 }
@@ -1067,46 +1205,40 @@ void I_SetSimplePalette(byte *playpal)
 {
     for (int i = 0; i < 256; i++)
     {
-        colors[i].r = *playpal++;
-        colors[i].g = *playpal++;
-        colors[i].b = *playpal++;
+        scratchcolors[i].r = *playpal++;
+        scratchcolors[i].g = *playpal++;
+        scratchcolors[i].b = *playpal++;
+        scratchcolors[i].a = SDL_ALPHA_OPAQUE;
     }
 
-    SDL_SetPaletteColors(palette, colors, 0, 256);
+    if (rgbabuffer)
+        for (int i = 0; i < 256; i++)
+            scratchrgba[i] = SDL_MapRGB(buffer->format, scratchcolors[i].r, scratchcolors[i].g, scratchcolors[i].b);
+
+    colors = scratchcolors;
+    rgba = scratchrgba;
+    palettechanged = true;
 }
 
 void I_SetPaletteWithBrightness(byte *playpal, double brightness)
 {
-    if (r_color == r_color_max)
-    {
-        for (int i = 0; i < 256; i++)
-        {
-            colors[i].r = (byte)(gammatable[gammaindex][*playpal++] * brightness);
-            colors[i].g = (byte)(gammatable[gammaindex][*playpal++] * brightness);
-            colors[i].b = (byte)(gammatable[gammaindex][*playpal++] * brightness);
-        }
-    }
-    else
-    {
-        double  color = r_color / 100.0;
+    const int   step = (int)(brightness * NUMFADESTEPS + 0.5);
 
-        for (int i = 0; i < 256; i++)
-        {
-            double  r = gammatable[gammaindex][*playpal++] * brightness;
-            double  g = gammatable[gammaindex][*playpal++] * brightness;
-            double  b = gammatable[gammaindex][*playpal++] * brightness;
-            double  p = sqrt(r * r * 0.299 + g * g * 0.587 + b * b * 0.114);
+    if (gammaindex != bakedgammaindex || r_color != bakedcolor || buffer->format->format != bakedformat)
+        BakePaletteLUTs();
 
-            colors[i].r = (byte)(p + (r - p) * color);
-            colors[i].g = (byte)(p + (g - p) * color);
-            colors[i].b = (byte)(p + (b - p) * color);
-        }
+    if (playpal == PLAYPAL && step >= 0 && step < NUMFADESTEPS && fabs(brightness - (double)step / NUMFADESTEPS) < 0.001)
+        ApplyPalette(palettecolors[NUMPLAYPALS + step], palettergba[NUMPLAYPALS + step]);
+    else
+    {
+        BakePalette(playpal, brightness, scratchcolors, scratchrgba);
+        ApplyPalette(scratchcolors, scratchrgba);
     }
+}
 
-    SDL_SetPaletteColors(palette, colors, 0, 256);
-
-    if (vid_pillarboxes)
-        SDL_SetRenderDrawColor(renderer, colors[0].r, colors[0].g, colors[0].b, SDL_ALPHA_OPAQUE);
+SDL_Color *I_GetPaletteColors(void)
+{
+    return colors;
 }
 
 static void I_RestoreFocus(void)
@@ -1390,13 +1522,18 @@ void I_SetMotionBlur(int percent)
 {
     if (percent)
     {
-        SDL_SetSurfaceAlphaMod(surface, SDL_ALPHA_OPAQUE - 128 * percent / 100);
+        const int   alpha = SDL_ALPHA_OPAQUE - 128 * percent / 100;
+
+        SDL_SetSurfaceAlphaMod(surface, alpha);
         SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_BLEND);
+        blendalpha = alpha + (alpha >> 7);
+        blending = true;
     }
     else
     {
         SDL_SetSurfaceAlphaMod(surface, SDL_ALPHA_OPAQUE);
         SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+        blending = false;
     }
 }
 
@@ -1830,6 +1967,7 @@ static void SetVideoMode(dboolean createwindow, dboolean output)
 
     pitch = buffer->pitch;
     pixels = buffer->pixels;
+    rgbabuffer = (buffer->format->BytesPerPixel == 4);
 
     SDL_FillRect(buffer, NULL, 0);
 
@@ -71,6 +71,7 @@ void I_SetPalette(byte *playpal);
 void I_SetExternalAutomapPalette(void);
 void I_SetSimplePalette(byte *playpal);
 void I_SetPaletteWithBrightness(byte *playpal, double brightness);
+SDL_Color *I_GetPaletteColors(void);
 
 void I_UpdateBlitFunc(dboolean shake);
 void I_CreateExternalAutomap(int outputlevel);
@@ -53,7 +53,7 @@
 
 static dboolean cvarsloaded;
 
-#define NUMCVARS                                                197
+#define NUMCVARS                                                198
 
 #define CONFIG_VARIABLE_INT(name, oldname, cvar, set)           { #name, #oldname, &cvar, DEFAULT_INT32,         set          }
 #define CONFIG_VARIABLE_INT_UNSIGNED(name, oldname, cvar, set)  { #name, #oldname, &cvar, DEFAULT_UINT64,        set          }
@@ -163,6 +163,7 @@ static default_t cvars[NUMCVARS] =
     CONFIG_VARIABLE_OTHER        (r_lowpixelsize,                   r_lowpixelsize,                        r_lowpixelsize,                        NOVALUEALIAS       ),
     CONFIG_VARIABLE_INT          (r_mirroredweapons,                r_mirroredweapons,                     r_mirroredweapons,                     BOOLVALUEALIAS     ),
     CONFIG_VARIABLE_INT          (r_playersprites,                  r_playersprites,                       r_playersprites,                       BOOLVALUEALIAS     ),
+    CONFIG_VARIABLE_INT          (r_pvs,                            r_pvs,                                 r_pvs,                                 BOOLVALUEALIAS     ),
     CONFIG_VARIABLE_INT          (r_rockettrails,                   r_rockettrails,                        r_rockettrails,                        BOOLVALUEALIAS     ),
     CONFIG_VARIABLE_INT          (r_screensize,                     r_screensize,                          r_screensize,                          NOVALUEALIAS       ),
     CONFIG_VARIABLE_INT          (r_shadows,                        r_shadows,                             r_shadows,                             BOOLVALUEALIAS     ),
@@ -818,6 +819,9 @@ static void M_CheckCVARs(void)
     if (r_playersprites != false && r_playersprites != true)
         r_playersprites = r_playersprites_default;
 
+    if (r_pvs != false && r_pvs != true)
+        r_pvs = r_pvs_default;
+
     if (r_rockettrails != false && r_rockettrails != true)
         r_rockettrails = r_rockettrails_default;
 
@@ -956,11 +960,7 @@ void M_LoadCVARs(char *filename)
         return;
     }
 
-    for (int i = 0; i < MAXALIASES; i++)
-    {
-        aliases[i].name[0] = '\0';
-        aliases[i].string[0] = '\0';
-    }
+    C_ClearAliases();
 
     // Clear all default controls before reading them from config file
     if (!togglingvanilla && M_StringEndsWith(filename, PACKAGE_CONFIG))
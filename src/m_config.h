@@ -135,6 +135,7 @@ extern dboolean     r_liquid_swirl;
 extern char         *r_lowpixelsize;
 extern dboolean     r_mirroredweapons;
 extern dboolean     r_playersprites;
+extern dboolean     r_pvs;
 extern dboolean     r_rockettrails;
 extern int          r_screensize;
 extern dboolean     r_shadows;
@@ -565,6 +566,8 @@ enum
 
 #define r_playersprites_default                 true
 
+#define r_pvs_default                           false
+
 #define r_rockettrails_default                  true
 
 #define r_screensize_min                        0
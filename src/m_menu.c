@@ -448,45 +448,6 @@ menu_t SaveDef =
     load1
 };
 
-static void BlurScreen(byte *screen, byte *blurscreen, int height)
-{
-    for (int i = 0; i < height; i++)
-        blurscreen[i] = grays[screen[i]];
-
-    for (int y = 0; y <= height - SCREENWIDTH; y += SCREENWIDTH)
-        for (int x = y; x <= y + SCREENWIDTH - 2; x++)
-            blurscreen[x] = tinttab50[(blurscreen[x + 1] << 8) + blurscreen[x]];
-
-    for (int y = 0; y <= height - SCREENWIDTH; y += SCREENWIDTH)
-        for (int x = y + SCREENWIDTH - 2; x > y; x--)
-            blurscreen[x] = tinttab50[(blurscreen[x - 1] << 8) + blurscreen[x]];
-
-    for (int y = SCREENWIDTH; y <= height - SCREENWIDTH * 2; y += SCREENWIDTH)
-        for (int x = y; x <= y + SCREENWIDTH - 2; x++)
-            blurscreen[x] = tinttab50[(blurscreen[x + (M_BigRandom() & 3 - 1) * SCREENWIDTH
-                + (M_BigRandom() & 3 - 1)] << 8) + blurscreen[x]];
-
-    for (int y = height - SCREENWIDTH; y >= SCREENWIDTH; y -= SCREENWIDTH)
-        for (int x = y + SCREENWIDTH - 1; x >= y + 1; x--)
-            blurscreen[x] = tinttab50[(blurscreen[x - SCREENWIDTH - 1] << 8) + blurscreen[x]];
-
-    for (int y = 0; y <= height - SCREENWIDTH * 2; y += SCREENWIDTH)
-        for (int x = y; x <= y + SCREENWIDTH - 1; x++)
-            blurscreen[x] = tinttab50[(blurscreen[x + SCREENWIDTH] << 8) + blurscreen[x]];
-
-    for (int y = height - SCREENWIDTH; y >= SCREENWIDTH; y -= SCREENWIDTH)
-        for (int x = y; x <= y + SCREENWIDTH - 1; x++)
-            blurscreen[x] = tinttab50[(blurscreen[x - SCREENWIDTH] << 8) + blurscreen[x]];
-
-    for (int y = 0; y <= height - SCREENWIDTH * 2; y += SCREENWIDTH)
-        for (int x = y + SCREENWIDTH - 1; x >= y + 1; x--)
-            blurscreen[x] = tinttab50[(blurscreen[x + SCREENWIDTH - 1] << 8) + blurscreen[x]];
-
-    for (int y = height - SCREENWIDTH; y >= SCREENWIDTH; y -= SCREENWIDTH)
-        for (int x = y; x <= y + SCREENWIDTH - 2; x++)
-            blurscreen[x] = tinttab50[(blurscreen[x - SCREENWIDTH + 1] << 8) + blurscreen[x]];
-}
-
 static int  blurtic = -1;
 
 //
@@ -495,11 +456,12 @@ static int  blurtic = -1;
 //
 void M_DarkBackground(void)
 {
-    static byte blurscreen1[MAXSCREENAREA];
-    static byte blurscreen2[(MAXHEIGHT - SBARHEIGHT) * MAXWIDTH];
-    const int   blurheight = SCREENHEIGHT * SCREENWIDTH;
+    static blur_t   blur1;
+    static blur_t   blur2;
+    const int       blurheight = SCREENHEIGHT * SCREENWIDTH;
 
-    if (gametime != blurtic && (!(gametime % 3) || blurtic == -1 || vid_capfps == TICRATE))
+    if ((gametime != blurtic && (!(gametime % 3) || blurtic == -1 || vid_capfps == TICRATE))
+        || blur1.width != SCREENWIDTH || blur1.height != SCREENHEIGHT)
     {
         for (int i = 0; i < blurheight; i += SCREENWIDTH)
         {
@@ -517,14 +479,7 @@ void M_DarkBackground(void)
                 *dot = white25[*dot];
             }
 
-        BlurScreen(screens[0], blurscreen1, blurheight);
-
-        for (int i = 0; i < blurheight; i++)
-        {
-            byte    *dot = blurscreen1 + i;
-
-            *dot = black40[*dot];
-        }
+        V_BlurScreen(&blur1, screens[0], SCREENWIDTH, SCREENHEIGHT, grays, black40, true);
 
         if (mapwindow && gamestate == GS_LEVEL)
         {
@@ -544,23 +499,16 @@ void M_DarkBackground(void)
                     *dot = white25[*dot];
                 }
 
-            BlurScreen(mapscreen, blurscreen2, (SCREENHEIGHT - SBARHEIGHT) * SCREENWIDTH);
-
-            for (int i = 0; i < (SCREENHEIGHT - SBARHEIGHT) * SCREENWIDTH; i++)
-            {
-                byte    *dot = blurscreen2 + i;
-
-                *dot = black40[*dot];
-            }
+            V_BlurScreen(&blur2, mapscreen, SCREENWIDTH, SCREENHEIGHT - SBARHEIGHT, grays, black40, true);
         }
 
         blurtic = gametime;
     }
 
-    memcpy(screens[0], blurscreen1, blurheight);
+    memcpy(screens[0], blur1.blurscreen, blurheight);
 
-    if (mapwindow)
-        memcpy(mapscreen, blurscreen2, ((size_t)SCREENHEIGHT - SBARHEIGHT) * SCREENWIDTH);
+    if (mapwindow && blur2.width == SCREENWIDTH && blur2.height == SCREENHEIGHT - SBARHEIGHT)
+        memcpy(mapscreen, blur2.blurscreen, ((size_t)SCREENHEIGHT - SBARHEIGHT) * SCREENWIDTH);
 
     if (r_detail == r_detail_low && !automapactive)
         V_LowGraphicDetail(0, 0, SCREENWIDTH, blurheight, 2, 2 * SCREENWIDTH);
@@ -951,3 +951,21 @@ void M_StripQuotes(char *string)
         string[len] = '\0';
     }
 }
+
+//
+// M_Hash
+//  64-bit FNV-1a hash of a block of data. Pass the result of a previous call
+//  as hash to hash several blocks together, or HASHSEED to start a new hash.
+//
+uint64_t M_Hash(const void *data, size_t size, uint64_t hash)
+{
+    const byte  *p = data;
+
+    while (size--)
+    {
+        hash ^= *p++;
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
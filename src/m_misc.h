@@ -48,6 +48,8 @@
 
 #include "doomtype.h"
 
+#define HASHSEED    0xCBF29CE484222325ULL
+
 void M_MakeDirectory(const char *path);
 dboolean M_FileExists(const char *filename);
 dboolean M_FolderExists(const char *folder);
@@ -105,5 +107,6 @@ char *striptrailingzero(float value, int precision);
 void strreplace(char *target, char *needle, const char *replacement);
 int hextodec(char *hex);
 void M_StripQuotes(char *string);
+uint64_t M_Hash(const void *data, size_t size, uint64_t hash);
 
 #endif
@@ -283,6 +283,70 @@ dboolean mmuscheckformat(uint8_t *mus, int size)
     return false;
 }
 
+//
+// SizeTracks()
+//
+// Make a first pass over the MUS events, counting the events that will be
+// written to each MIDI track, so each track's buffer can be allocated once
+// rather than being grown by TWriteByte().
+//
+// Each event takes at most 8 bytes in a MIDI track: a delta time of up to 5
+// bytes, an event code and 2 bytes of data. Each track also starts with an
+// "all notes off" event and ends with an "end of track" event, 4 bytes each.
+//
+static void SizeTracks(MIDI *mididata, uint8_t *musptr, uint8_t *musend)
+{
+    int MUSchan2track[16];
+    int events[MIDI_TRACKS] = { 0 };
+    int TrackCnt = 1;
+
+    for (int i = 0; i < 16; i++)
+        MUSchan2track[i] = -1;
+
+    while (musptr < musend)
+    {
+        int     event = *musptr++;
+        uint8_t MUSchannel = channel(event);
+
+        switch (event_type(event))
+        {
+            case RELEASE_NOTE:
+            case BEND_NOTE:
+            case SYS_EVENT:
+                musptr++;
+                break;
+
+            case PLAY_NOTE:
+                if (musptr < musend && (*musptr++ & 0x80))
+                    musptr++;
+
+                break;
+
+            case CNTL_CHANGE:
+                musptr += 2;
+                break;
+
+            default:
+                musend = musptr;
+                continue;
+        }
+
+        if (MUSchan2track[MUSchannel] == -1)
+            MUSchan2track[MUSchannel] = TrackCnt++;
+
+        events[MUSchan2track[MUSchannel]]++;
+
+        if (last(event))
+            while (musptr < musend && (*musptr++ & 0x80));
+    }
+
+    for (int i = 1; i < TrackCnt; i++)
+    {
+        track[i].alloced = 8 + events[i] * 8;
+        mididata->track[i].data = (unsigned char *)I_Realloc(mididata->track[i].data, track[i].alloced);
+    }
+}
+
 //
 // mmus2mid()
 //
@@ -303,6 +367,7 @@ dboolean mmus2mid(uint8_t *mus, size_t size, MIDI *mididata)
     int                 data;
     uint8_t             *musptr;
     uint8_t             *hptr;
+    uint8_t             *musend = mus + size;
     size_t              muslen;
     static MUSheader    MUSh;
     uint8_t             MIDIchan2track[MIDI_TRACKS];
@@ -367,6 +432,8 @@ dboolean mmus2mid(uint8_t *mus, size_t size, MIDI *mididata)
 
     TrackCnt++;   // music tracks start at 1
 
+    SizeTracks(mididata, musptr, (mus + muslen < musend ? mus + muslen : musend));
+
     // process the MUS events in the MUS buffer
     do
     {
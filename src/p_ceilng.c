@@ -36,6 +36,7 @@
 ========================================================================
 */
 
+#include "am_map.h"
 #include "doomstat.h"
 #include "m_config.h"
 #include "p_fix.h"
@@ -330,6 +331,8 @@ manual_ceiling:
         for (int i = 0; i < sec->linecount; i++)
             sec->lines[i]->flags &= ~ML_SECRET;
 
+        mapwindowchanged = true;
+
         if (zerotag_manual)
             return rtn; //e6y
     }
@@ -36,6 +36,7 @@
 ========================================================================
 */
 
+#include "am_map.h"
 #include "d_deh.h"
 #include "doomstat.h"
 #include "hu_stuff.h"
@@ -466,6 +467,8 @@ manual_door:
         for (int i = 0; i < sec->linecount; i++)
             sec->lines[i]->flags &= ~ML_SECRET;
 
+        mapwindowchanged = true;
+
         if (zerotag_manual)
             return rtn; //e6y
     }
@@ -730,6 +733,8 @@ void EV_VerticalDoor(line_t *line, mobj_t *thing)
     // [BH] door is no longer secret
     for (int i = 0; i < sec->linecount; i++)
         sec->lines[i]->flags &= ~ML_SECRET;
+
+    mapwindowchanged = true;
 }
 
 //
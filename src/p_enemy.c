@@ -1344,10 +1344,10 @@ void A_VileChase(mobj_t *actor, player_t *player, pspdef_t *psp)
         viletryx = actor->x + speed * xspeed[movedir];
         viletryy = actor->y + speed * yspeed[movedir];
 
-        xl = P_GetSafeBlockX(viletryx - bmaporgx - MAXRADIUS * 2);
-        xh = P_GetSafeBlockX(viletryx - bmaporgx + MAXRADIUS * 2);
-        yl = P_GetSafeBlockY(viletryy - bmaporgy - MAXRADIUS * 2);
-        yh = P_GetSafeBlockY(viletryy - bmaporgy + MAXRADIUS * 2);
+        xl = P_GetThingGridX(viletryx - bmaporgx - MAXRADIUS * 2);
+        xh = P_GetThingGridX(viletryx - bmaporgx + MAXRADIUS * 2);
+        yl = P_GetThingGridY(viletryy - bmaporgy - MAXRADIUS * 2);
+        yh = P_GetThingGridY(viletryy - bmaporgy + MAXRADIUS * 2);
 
         for (int bx = xl; bx <= xh; bx++)
             for (int by = yl; by <= yh; by++)
@@ -36,6 +36,7 @@
 ========================================================================
 */
 
+#include "am_map.h"
 #include "doomstat.h"
 #include "m_config.h"
 #include "p_fix.h"
@@ -61,6 +62,7 @@
 result_e T_MovePlane(sector_t *sector, fixed_t speed, fixed_t dest, dboolean crush, int floororceiling, int direction)
 {
     sector->oldgametime = gametime;
+    mapwindowchanged = true;
 
     switch (floororceiling)
     {
@@ -566,6 +568,8 @@ manual_floor:
         for (int i = 0; i < sec->linecount; i++)
             sec->lines[i]->flags &= ~ML_SECRET;
 
+        mapwindowchanged = true;
+
         if (zerotag_manual)
             return rtn; //e6y
     }
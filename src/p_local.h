@@ -193,6 +193,9 @@ fixed_t P_InterceptVector(divline_t *v2, divline_t *v1);
 int P_GetSafeBlockX(int coord);
 int P_GetSafeBlockY(int coord);
 
+int P_GetThingGridX(int coord);
+int P_GetThingGridY(int coord);
+
 extern fixed_t  opentop;
 extern fixed_t  openbottom;
 extern fixed_t  openrange;
@@ -203,6 +206,23 @@ void P_LineOpening(line_t *line);
 dboolean P_BlockLinesIterator(int x, int y, dboolean func(line_t *));
 dboolean P_BlockThingsIterator(int x, int y, dboolean func(mobj_t *));
 
+//
+// Things are linked into a grid with cells that are a half or a quarter the
+// size of those in the blockmap, each with an array of the things in it.
+//
+typedef struct thinggridcell_s
+{
+    mobj_t          **things;
+    int             numthings;
+    int             maxthings;
+} thinggridcell_t;
+
+extern thinggridcell_t  *thinggrid;
+extern int          thinggridwidth;
+extern int          thinggridheight;    // in thing grid cells
+
+void P_InitThingGrid(void);
+
 #define PT_ADDLINES     1
 #define PT_ADDTHINGS    2
 
@@ -273,7 +293,6 @@ extern int          bmapwidth;
 extern int          bmapheight;     // in mapblocks
 extern fixed_t      bmaporgx;
 extern fixed_t      bmaporgy;       // origin of block map
-extern mobj_t       **blocklinks;   // for thing chains
 
 // MAES: extensions to support 512x512 blockmaps.
 extern int          blockmapxneg;
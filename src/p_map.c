@@ -247,10 +247,10 @@ dboolean P_TeleportMove(mobj_t *thing, fixed_t x, fixed_t y, fixed_t z, dboolean
     numspechit = 0;
 
     // stomp on any things contacted
-    xl = P_GetSafeBlockX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
-    xh = P_GetSafeBlockX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
-    yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
-    yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
+    xl = P_GetThingGridX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
+    xh = P_GetThingGridX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
+    yl = P_GetThingGridY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
+    yh = P_GetThingGridY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
 
     for (int bx = xl; bx <= xh; bx++)
         for (int by = yl; by <= yh; by++)
@@ -788,13 +788,13 @@ dboolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y)
 
     // Check things first, possibly picking things up.
     // The bounding box is extended by MAXRADIUS
-    // because mobj_ts are grouped into mapblocks
+    // because mobj_ts are grouped into thing grid cells
     // based on their origin point, and can overlap
-    // into adjacent blocks by up to MAXRADIUS units.
-    xl = P_GetSafeBlockX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
-    xh = P_GetSafeBlockX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
-    yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
-    yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
+    // into adjacent cells by up to MAXRADIUS units.
+    xl = P_GetThingGridX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
+    xh = P_GetThingGridX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
+    yl = P_GetThingGridY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
+    yh = P_GetThingGridY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
 
     for (int bx = xl; bx <= xh; bx++)
         for (int by = yl; by <= yh; by++)
@@ -920,12 +920,12 @@ mobj_t *P_CheckOnMobj(mobj_t *thing)
 
     // check things first, possibly picking things up
     // the bounding box is extended by MAXRADIUS because mobj_ts are grouped
-    // into mapblocks based on their origin point, and can overlap into adjacent
-    // blocks by up to MAXRADIUS units
-    xl = P_GetSafeBlockX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
-    xh = P_GetSafeBlockX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
-    yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
-    yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
+    // into thing grid cells based on their origin point, and can overlap into
+    // adjacent cells by up to MAXRADIUS units
+    xl = P_GetThingGridX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
+    xh = P_GetThingGridX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
+    yl = P_GetThingGridY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
+    yh = P_GetThingGridY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
 
     for (int bx = xl; bx <= xh; bx++)
         for (int by = yl; by <= yh; by++)
@@ -1975,10 +1975,10 @@ static dboolean PIT_RadiusAttack(mobj_t *thing)
 void P_RadiusAttack(mobj_t *spot, mobj_t *source, int damage, dboolean verticality)
 {
     fixed_t dist = (damage << FRACBITS) + MAXRADIUS;
-    int     xh = P_GetSafeBlockX(spot->x + dist - bmaporgx);
-    int     xl = P_GetSafeBlockX(spot->x - dist - bmaporgx);
-    int     yh = P_GetSafeBlockY(spot->y + dist - bmaporgy);
-    int     yl = P_GetSafeBlockY(spot->y - dist - bmaporgy);
+    int     xh = P_GetThingGridX(spot->x + dist - bmaporgx);
+    int     xl = P_GetThingGridX(spot->x - dist - bmaporgx);
+    int     yh = P_GetThingGridY(spot->y + dist - bmaporgy);
+    int     yl = P_GetThingGridY(spot->y - dist - bmaporgy);
 
     bombspot = spot;
     bombsource = source;
@@ -2270,6 +2270,85 @@ void P_DelSeclist(msecnode_t *node)
         node = P_DelSecnode(node);
 }
 
+// how far the object whose sector list is being built can move before any
+// line in the blocks it's in could be found to cross it differently
+static fixed_t  secnodemargin;
+
+//
+// P_LineCrossingMargin
+// Returns how far tmbbox can move in any direction before whether PIT_GetSectors()
+// finds that a line crosses it may change.
+//
+static fixed_t P_LineCrossingMargin(line_t *ld)
+{
+    const int64_t   slack[4] =
+    {
+        (int64_t)tmbbox[BOXRIGHT] - ld->bbox[BOXLEFT], (int64_t)ld->bbox[BOXRIGHT] - tmbbox[BOXLEFT],
+        (int64_t)tmbbox[BOXTOP] - ld->bbox[BOXBOTTOM], (int64_t)ld->bbox[BOXTOP] - tmbbox[BOXBOTTOM]
+    };
+    const fixed_t   corners[4][2] =
+    {
+        { tmbbox[BOXLEFT], tmbbox[BOXBOTTOM] }, { tmbbox[BOXRIGHT], tmbbox[BOXBOTTOM] },
+        { tmbbox[BOXLEFT], tmbbox[BOXTOP] }, { tmbbox[BOXRIGHT], tmbbox[BOXTOP] }
+    };
+    const int64_t   length = (int64_t)ABS(ld->dx) + ABS(ld->dy);
+    int64_t         overlapmargin = INT64_MAX;
+    int64_t         sidemargin[2] = { 0, 0 };
+    int64_t         allsidesmargin = INT64_MAX;
+    int64_t         margin;
+    dboolean        overlap = true;
+
+    if (!length)
+        return 0;
+
+    // how far until the bounding boxes start or stop overlapping
+    for (int i = 0; i < 4; i++)
+        if (slack[i] <= 0)
+        {
+            if (overlap)
+            {
+                overlap = false;
+                overlapmargin = 0;
+            }
+
+            if (-slack[i] > overlapmargin)
+                overlapmargin = -slack[i];
+        }
+        else if (overlap && slack[i] < overlapmargin)
+            overlapmargin = slack[i];
+
+    // how far each corner is from the line
+    for (int i = 0; i < 4; i++)
+    {
+        const int64_t   cross = ((int64_t)corners[i][1] - ld->v1->y) * ld->dx
+                            - (int64_t)ld->dy * ((int64_t)corners[i][0] - ld->v1->x);
+        const int64_t   distance = (cross < 0 ? -cross : cross) / length;
+        const int       side = (cross >= 0);
+
+        if (distance > sidemargin[side])
+            sidemargin[side] = distance;
+
+        if (distance < allsidesmargin)
+            allsidesmargin = distance;
+    }
+
+    if (sidemargin[0] && sidemargin[1])
+    {
+        // the line crosses the box, so it must stay crossing it and overlapping it
+        margin = (sidemargin[0] < sidemargin[1] ? sidemargin[0] : sidemargin[1]);
+
+        if (!overlap)
+            margin = overlapmargin;
+        else if (overlapmargin < margin)
+            margin = overlapmargin;
+    }
+    else
+        // the line doesn't cross the box, so it's enough for either to stay that way
+        margin = (overlap || allsidesmargin > overlapmargin ? allsidesmargin : overlapmargin);
+
+    return (fixed_t)(margin > FIXED_MAX ? FIXED_MAX : margin);
+}
+
 // phares 03/14/98
 //
 // PIT_GetSectors
@@ -2279,6 +2358,9 @@ void P_DelSeclist(msecnode_t *node)
 // blocking lines.
 static dboolean PIT_GetSectors(line_t *ld)
 {
+    if (secnodemargin)
+        secnodemargin = MIN(secnodemargin, P_LineCrossingMargin(ld));
+
     if (tmbbox[BOXRIGHT] <= ld->bbox[BOXLEFT] || tmbbox[BOXLEFT] >= ld->bbox[BOXRIGHT]
         || tmbbox[BOXTOP] <= ld->bbox[BOXBOTTOM] || tmbbox[BOXBOTTOM] >= ld->bbox[BOXTOP])
         return true;
@@ -2325,6 +2407,24 @@ void P_CreateSecNodeList(mobj_t *thing, fixed_t x, fixed_t y)
     fixed_t     saved_tmy = tmy;
     fixed_t     radius = thing->info->pickupradius;
 
+    // If the object hasn't moved far enough since its sector list was last
+    // built for any line to cross it differently, and it's still in a sector
+    // in that list, then the list hasn't changed.
+    if (node && thing->secnodemargin
+        && (int64_t)x - thing->secnodex < thing->secnodemargin && (int64_t)thing->secnodex - x < thing->secnodemargin
+        && (int64_t)y - thing->secnodey < thing->secnodemargin && (int64_t)thing->secnodey - y < thing->secnodemargin)
+    {
+        sector_t    *sector = thing->subsector->sector;
+
+        while (node && node->m_sector != sector)
+            node = node->m_tnext;
+
+        if (node)
+            return;
+
+        node = sector_list;
+    }
+
     // First, clear out the existing m_thing fields. As each node is
     // added or verified as needed, m_thing will be set properly. When
     // finished, delete all nodes where m_thing is still NULL. These
@@ -2352,10 +2452,27 @@ void P_CreateSecNodeList(mobj_t *thing, fixed_t x, fixed_t y)
     yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy);
     yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy);
 
+    // the object's bounding box must also stay within the same blocks
+    if (xl >= 0 && xh < bmapwidth && yl >= 0 && yh < bmapheight)
+    {
+        const fixed_t   left = tmbbox[BOXLEFT] - bmaporgx - (xl << MAPBLOCKSHIFT);
+        const fixed_t   right = (xh << MAPBLOCKSHIFT) + MAPBLOCKSIZE - (tmbbox[BOXRIGHT] - bmaporgx);
+        const fixed_t   bottom = tmbbox[BOXBOTTOM] - bmaporgy - (yl << MAPBLOCKSHIFT);
+        const fixed_t   top = (yh << MAPBLOCKSHIFT) + MAPBLOCKSIZE - (tmbbox[BOXTOP] - bmaporgy);
+
+        secnodemargin = MIN(MIN(left, right), MIN(bottom, top));
+    }
+    else
+        secnodemargin = 0;
+
     for (int bx = xl; bx <= xh; bx++)
         for (int by = yl; by <= yh; by++)
             P_BlockLinesIterator(bx, by, &PIT_GetSectors);
 
+    thing->secnodex = x;
+    thing->secnodey = y;
+    thing->secnodemargin = secnodemargin;
+
     // Add the sector of the (x,y) point to sector_list.
     sector_list = P_AddSecnode(thing->subsector->sector, thing, sector_list);
 
@@ -214,20 +214,27 @@ void P_UnsetThingPosition(mobj_t *thing)
 
     if (!(thing->flags & MF_NOBLOCKMAP))
     {
-        // inert things don't need to be in blockmap
+        // inert things don't need to be in thing grid
         //
-        // killough 08/11/98: simpler scheme using pointers-to-pointers for prev
-        // pointers, allows head node pointers to be treated like everything else
-        //
-        // Also more robust, since it doesn't depend on current position for
-        // unlinking. Old method required computing head node based on position
-        // at time of unlinking, assuming it was the same position as during
-        // linking.
-        mobj_t  *bnext;
-        mobj_t  **bprev = thing->bprev;
-
-        if (bprev && (*bprev = bnext = thing->bnext))   // unlink from block map
-            bnext->bprev = bprev;
+        // The cell is remembered rather than worked out from the thing's
+        // current position, so this doesn't depend on it being the same as
+        // when the thing was linked.
+        thinggridcell_t *cell = thing->thinggridcell;
+
+        if (cell)
+        {
+            // things that have just moved are at the end of the cell
+            int i = cell->numthings - 1;
+
+            while (i >= 0 && cell->things[i] != thing)
+                i--;
+
+            // keep the rest of the things in the same order
+            if (i >= 0)
+                memmove(cell->things + i, cell->things + i + 1, (--cell->numthings - i) * sizeof(*cell->things));
+
+            thing->thinggridcell = NULL;
+        }
     }
 }
 
@@ -288,32 +295,29 @@ void P_SetThingPosition(mobj_t *thing)
         sector_list = NULL;                             // clear for next time
     }
 
-    // link into blockmap
+    // link into thing grid
     if (!(thing->flags & MF_NOBLOCKMAP))
     {
-        // inert things don't need to be in blockmap
-        int blockx = P_GetSafeBlockX(thing->x - bmaporgx);
-        int blocky = P_GetSafeBlockY(thing->y - bmaporgy);
+        // inert things don't need to be in thing grid
+        int gridx = P_GetThingGridX(thing->x - bmaporgx);
+        int gridy = P_GetThingGridY(thing->y - bmaporgy);
 
-        if (blockx >= 0 && blockx < bmapwidth && blocky >= 0 && blocky < bmapheight)
+        if (gridx >= 0 && gridx < thinggridwidth && gridy >= 0 && gridy < thinggridheight)
         {
-            // killough 08/11/98: simpler scheme using pointer-to-pointer prev
-            // pointers, allows head nodes to be treated like everything else
-            mobj_t  **link = &blocklinks[blocky * bmapwidth + blockx];
-            mobj_t  *bnext = *link;
+            thinggridcell_t *cell = &thinggrid[gridy * thinggridwidth + gridx];
 
-            if ((thing->bnext = bnext))
-                bnext->bprev = &thing->bnext;
+            if (cell->numthings == cell->maxthings)
+            {
+                cell->maxthings = (cell->maxthings ? cell->maxthings * 2 : 4);
+                cell->things = I_Realloc(cell->things, cell->maxthings * sizeof(*cell->things));
+            }
 
-            thing->bprev = link;
-            *link = thing;
+            cell->things[cell->numthings++] = thing;
+            thing->thinggridcell = cell;
         }
         else
-        {
             // thing is off the map
-            thing->bnext = NULL;
-            thing->bprev = NULL;
-        }
+            thing->thinggridcell = NULL;
     }
 }
 
@@ -376,14 +380,118 @@ dboolean P_BlockLinesIterator(int x, int y, dboolean func(line_t *))
     }
 }
 
+//
+// THING GRID
+// Things are linked into a grid with cells smaller than the blockmap's, so
+// that checking for things near a small thing doesn't have to go through
+// every thing in a 3x3 area of mapblocks.
+//
+thinggridcell_t     *thinggrid;
+int                 thinggridwidth;
+int                 thinggridheight;
+
+// each mapblock is split into (1 << thinggridbits) cells across
+static int          thinggridbits;
+
+// the things in each cell being iterated through, so that things being
+// linked and unlinked by func can't change which things are iterated through
+static mobj_t       **thingstack;
+static int          thingstacksize;
+static int          thingstacktop;
+
+//
+// P_InitThingGrid
+// Empties the thing grid, reallocating it if the blockmap has changed size.
+//
+void P_InitThingGrid(void)
+{
+    // use larger cells in huge maps so the grid doesn't use too much memory
+    const int   bits = ((int64_t)bmapwidth * bmapheight <= 256 * 256 ? 2 : 1);
+    const int   width = bmapwidth << bits;
+    const int   height = bmapheight << bits;
+
+    if (thinggrid && bits == thinggridbits && width == thinggridwidth && height == thinggridheight)
+    {
+        for (int i = 0; i < width * height; i++)
+            thinggrid[i].numthings = 0;
+
+        return;
+    }
+
+    if (thinggrid)
+    {
+        for (int i = 0; i < thinggridwidth * thinggridheight; i++)
+            free(thinggrid[i].things);
+
+        free(thinggrid);
+    }
+
+    thinggridbits = bits;
+    thinggridwidth = width;
+    thinggridheight = height;
+    thinggrid = calloc((size_t)width * height, sizeof(*thinggrid));
+}
+
 //
 // P_BlockThingsIterator
+// Iterates through the things in the given cell of the thing grid, most
+// recently linked first.
 //
 dboolean P_BlockThingsIterator(int x, int y, dboolean func(mobj_t *))
 {
-    if (!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
-        for (mobj_t *mobj = blocklinks[y * bmapwidth + x]; mobj; mobj = mobj->bnext)
-            if (!func(mobj))
+    if (x < 0 || y < 0 || x >= thinggridwidth || y >= thinggridheight)
+        return true;
+    else
+    {
+        const thinggridcell_t   *cell = &thinggrid[y * thinggridwidth + x];
+        const int               numthings = cell->numthings;
+        const int               base = thingstacktop;
+        dboolean                result = true;
+
+        if (!numthings)
+            return true;
+
+        if (base + numthings > thingstacksize)
+        {
+            thingstacksize = MAX(thingstacksize * 2, base + numthings);
+            thingstack = I_Realloc(thingstack, thingstacksize * sizeof(*thingstack));
+        }
+
+        for (int i = 0; i < numthings; i++)
+            thingstack[base + i] = cell->things[numthings - i - 1];
+
+        thingstacktop += numthings;
+
+        for (int i = base; i < base + numthings; i++)
+        {
+            mobj_t  *mobj = thingstack[i];
+
+            // skip anything that was removed by an earlier call to func
+            if (mobj->thinggridcell && !func(mobj))
+            {
+                result = false;
+                break;
+            }
+        }
+
+        thingstacktop = base;
+
+        return result;
+    }
+}
+
+//
+// P_MapBlockThingsIterator
+// Iterates through the things in every cell of the thing grid within the
+// given mapblock.
+//
+static dboolean P_MapBlockThingsIterator(int x, int y, dboolean func(mobj_t *))
+{
+    const int   cells = 1 << thinggridbits;
+
+    for (int gridx = x * cells; gridx < (x + 1) * cells; gridx++)
+        for (int gridy = y * cells; gridy < (y + 1) * cells; gridy++)
+            if (!P_BlockThingsIterator(gridx, gridy, func))
                 return false;
 
     return true;
@@ -681,7 +789,7 @@ dboolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2, int flag
                 return false;   // early out
 
         if (flags & PT_ADDTHINGS)
-            if (!P_BlockThingsIterator(mapx, mapy, &PIT_AddThingIntercepts))
+            if (!P_MapBlockThingsIterator(mapx, mapy, &PIT_AddThingIntercepts))
                 return false;   // early out
 
         if (mapx == xt2 && mapy == yt2)
@@ -720,8 +828,8 @@ dboolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2, int flag
 
                 if (flags & PT_ADDTHINGS)
                 {
-                    P_BlockThingsIterator(mapx + mapxstep, mapy, &PIT_AddThingIntercepts);
-                    P_BlockThingsIterator(mapx, mapy + mapystep, &PIT_AddThingIntercepts);
+                    P_MapBlockThingsIterator(mapx + mapxstep, mapy, &PIT_AddThingIntercepts);
+                    P_MapBlockThingsIterator(mapx, mapy + mapystep, &PIT_AddThingIntercepts);
                 }
 
                 xintercept += xstep;
@@ -757,3 +865,25 @@ int P_GetSafeBlockY(int coord)
 
     return coord;
 }
+
+//
+// P_GetThingGridX
+// Returns the column of the thing grid that a coordinate relative to the
+// blockmap's origin is in.
+//
+int P_GetThingGridX(int coord)
+{
+    return ((P_GetSafeBlockX(coord) << thinggridbits)
+        | ((coord >> (MAPBLOCKSHIFT - thinggridbits)) & ((1 << thinggridbits) - 1)));
+}
+
+//
+// P_GetThingGridY
+// Returns the row of the thing grid that a coordinate relative to the
+// blockmap's origin is in.
+//
+int P_GetThingGridY(int coord)
+{
+    return ((P_GetSafeBlockY(coord) << thinggridbits)
+        | ((coord >> (MAPBLOCKSHIFT - thinggridbits)) & ((1 << thinggridbits) - 1)));
+}
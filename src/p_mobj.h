@@ -86,7 +86,7 @@
 // The sound code uses the x,y, and subsector fields
 // to do stereo positioning of any sound emitted by the mobj_t.
 //
-// The play simulation uses the blocklinks, x,y,z, radius, height
+// The play simulation uses the thing grid, x,y,z, radius, height
 // to determine when mobj_ts are touching each other,
 // touching lines in the map, or hit by trace lines (gunshots,
 // lines of sight, etc).
@@ -137,7 +137,7 @@ enum
     MF_SHOOTABLE        = 0x00000004,
     // Don't use the sector links (invisible but touchable).
     MF_NOSECTOR         = 0x00000008,
-    // Don't use the blocklinks (inert but displayable)
+    // Don't use the thing grid (inert but displayable)
     MF_NOBLOCKMAP       = 0x00000010,
 
     // Not to be activated by sound, deaf monster.
@@ -353,10 +353,9 @@ typedef struct mobj_s
     spritenum_t         sprite;                 // used to find patch_t and flip value
     int                 frame;                  // might be ORed with FF_FULLBRIGHT
 
-    // Interaction info, by BLOCKMAP.
-    // Links in blocks (if needed).
-    struct mobj_s       *bnext;
-    struct mobj_s       **bprev;                // killough 08/11/98: change to ptr-to-ptr
+    // Interaction info, by thing grid.
+    // Cell it is in (if needed).
+    struct thinggridcell_s  *thinggridcell;
 
     struct subsector_s  *subsector;
 
@@ -426,6 +425,11 @@ typedef struct mobj_s
     // a linked list of sectors where this object appears
     struct msecnode_s   *touching_sectorlist;   // phares 03/14/98
 
+    // position touching_sectorlist was last built at, and how far the object
+    // can move from there before it needs to be built again
+    fixed_t             secnodex, secnodey;
+    fixed_t             secnodemargin;
+
     short               gear;                   // killough 11/98: used in torque simulation
 
     short               pursuecount;
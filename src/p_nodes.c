@@ -0,0 +1,1121 @@
+/*
+========================================================================
+
+                           D O O M  R e t r o
+         The classic, refined DOOM source port. For Windows PC.
+
+========================================================================
+
+  Copyright © 1993-2012 by id Software LLC, a ZeniMax Media company.
+  Copyright © 2013-2020 by Brad Harding.
+
+  DOOM Retro is a fork of Chocolate DOOM. For a list of credits, see
+  <https://github.com/bradharding/doomretro/wiki/CREDITS>.
+
+  This file is a part of DOOM Retro.
+
+  DOOM Retro is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  DOOM Retro is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with DOOM Retro. If not, see <https://www.gnu.org/licenses/>.
+
+  DOOM is a registered trademark of id Software LLC, a ZeniMax Media
+  company, in the US and/or other countries, and is used without
+  permission. All other trademarks are the property of their respective
+  holders. DOOM Retro is in no way affiliated with nor endorsed by
+  id Software.
+
+========================================================================
+*/
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#include "doomstat.h"
+#include "i_system.h"
+#include "m_bbox.h"
+#include "p_local.h"
+#include "p_nodes.h"
+#include "p_setup.h"
+
+//
+// Inflate
+//
+// A small decoder for the zlib streams that compressed ZDBSP nodes are stored
+// in. The output is written into a buffer that grows as it is decoded.
+//
+#define MAXBITS     15
+#define MAXLCODES   286
+#define MAXDCODES   30
+#define FIXLCODES   288
+
+typedef struct
+{
+    const byte      *in;
+    int             insize;
+    int             inpos;
+    unsigned int    bitbuf;
+    int             bitcnt;
+    byte            *out;
+    int             outsize;
+    int             outpos;
+    dboolean        error;
+} inflate_t;
+
+typedef struct
+{
+    short           count[MAXBITS + 1];
+    short           symbol[FIXLCODES];
+} huffman_t;
+
+static int P_InflateBits(inflate_t *s, int need)
+{
+    unsigned int    val = s->bitbuf;
+
+    while (s->bitcnt < need)
+    {
+        if (s->inpos >= s->insize)
+        {
+            s->error = true;
+            return 0;
+        }
+
+        val |= (unsigned int)s->in[s->inpos++] << s->bitcnt;
+        s->bitcnt += 8;
+    }
+
+    s->bitbuf = val >> need;
+    s->bitcnt -= need;
+
+    return (int)(val & ((1u << need) - 1));
+}
+
+static dboolean P_InflateReserve(inflate_t *s, int len)
+{
+    if (s->outpos > INT_MAX / 2 - len)
+    {
+        s->error = true;
+        return false;
+    }
+
+    if (s->outpos + len > s->outsize)
+    {
+        while (s->outpos + len > s->outsize)
+            s->outsize *= 2;
+
+        s->out = I_Realloc(s->out, s->outsize);
+    }
+
+    return true;
+}
+
+static void P_InflateStored(inflate_t *s)
+{
+    int len;
+
+    // discard any leftover bits and read the length of the block
+    s->bitbuf = 0;
+    s->bitcnt = 0;
+
+    if (s->inpos + 4 > s->insize)
+    {
+        s->error = true;
+        return;
+    }
+
+    len = (s->in[s->inpos] | (s->in[s->inpos + 1] << 8));
+
+    if (s->in[s->inpos + 2] != (~len & 0xFF) || s->in[s->inpos + 3] != ((~len >> 8) & 0xFF))
+    {
+        s->error = true;
+        return;
+    }
+
+    s->inpos += 4;
+
+    if (s->inpos + len > s->insize || !P_InflateReserve(s, len))
+    {
+        s->error = true;
+        return;
+    }
+
+    memcpy(s->out + s->outpos, s->in + s->inpos, len);
+    s->outpos += len;
+    s->inpos += len;
+}
+
+static int P_InflateDecode(inflate_t *s, const huffman_t *h)
+{
+    int code = 0;
+    int first = 0;
+    int index = 0;
+
+    for (int len = 1; len <= MAXBITS; len++)
+    {
+        int count;
+
+        code |= P_InflateBits(s, 1);
+
+        if (s->error)
+            return -1;
+
+        count = h->count[len];
+
+        if (code - count < first)
+            return h->symbol[index + (code - first)];
+
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+
+    s->error = true;
+    return -1;
+}
+
+// Returns 0 for a complete code, a positive number for an incomplete code and
+// a negative number for an over-subscribed code.
+static int P_InflateConstruct(huffman_t *h, const short *length, int n)
+{
+    short   offs[MAXBITS + 1];
+    int     left = 1;
+
+    memset(h->count, 0, sizeof(h->count));
+
+    for (int symbol = 0; symbol < n; symbol++)
+        h->count[length[symbol]]++;
+
+    if (h->count[0] == n)
+        return 0;
+
+    for (int len = 1; len <= MAXBITS; len++)
+    {
+        left <<= 1;
+        left -= h->count[len];
+
+        if (left < 0)
+            return left;
+    }
+
+    offs[1] = 0;
+
+    for (int len = 1; len < MAXBITS; len++)
+        offs[len + 1] = offs[len] + h->count[len];
+
+    for (int symbol = 0; symbol < n; symbol++)
+        if (length[symbol])
+            h->symbol[offs[length[symbol]]++] = symbol;
+
+    return left;
+}
+
+static void P_InflateCodes(inflate_t *s, const huffman_t *lencode, const huffman_t *distcode)
+{
+    static const short  lbase[29] =
+    {
+          3,   4,   5,   6,   7,   8,   9,  10,  11,  13,  15,  17,  19,  23,  27,
+         31,  35,  43,  51,  59,  67,  83,  99, 115, 131, 163, 195, 227, 258
+    };
+
+    static const short  lext[29] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+
+    static const short  dbase[30] =
+    {
+           1,    2,    3,    4,    5,    7,    9,   13,   17,   25,   33,   49,   65,   97,  129,
+         193,  257,  385,  513,  769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+
+    static const short  dext[30] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    while (true)
+    {
+        int symbol = P_InflateDecode(s, lencode);
+
+        if (s->error || symbol == 256)
+            return;
+
+        if (symbol < 256)
+        {
+            if (!P_InflateReserve(s, 1))
+                return;
+
+            s->out[s->outpos++] = (byte)symbol;
+        }
+        else
+        {
+            int len;
+            int dist;
+
+            if ((symbol -= 257) >= 29)
+            {
+                s->error = true;
+                return;
+            }
+
+            len = lbase[symbol] + P_InflateBits(s, lext[symbol]);
+            symbol = P_InflateDecode(s, distcode);
+
+            if (s->error || symbol < 0 || symbol >= 30)
+            {
+                s->error = true;
+                return;
+            }
+
+            dist = dbase[symbol] + P_InflateBits(s, dext[symbol]);
+
+            if (s->error || dist > s->outpos || !P_InflateReserve(s, len))
+            {
+                s->error = true;
+                return;
+            }
+
+            // the source and destination may overlap
+            for (int i = 0; i < len; i++, s->outpos++)
+                s->out[s->outpos] = s->out[s->outpos - dist];
+        }
+    }
+}
+
+static void P_InflateFixed(inflate_t *s)
+{
+    short       lengths[FIXLCODES];
+    huffman_t   lencode;
+    huffman_t   distcode;
+    int         symbol = 0;
+
+    for (; symbol < 144; symbol++)
+        lengths[symbol] = 8;
+
+    for (; symbol < 256; symbol++)
+        lengths[symbol] = 9;
+
+    for (; symbol < 280; symbol++)
+        lengths[symbol] = 7;
+
+    for (; symbol < FIXLCODES; symbol++)
+        lengths[symbol] = 8;
+
+    P_InflateConstruct(&lencode, lengths, FIXLCODES);
+
+    for (symbol = 0; symbol < MAXDCODES; symbol++)
+        lengths[symbol] = 5;
+
+    P_InflateConstruct(&distcode, lengths, MAXDCODES);
+
+    P_InflateCodes(s, &lencode, &distcode);
+}
+
+static void P_InflateDynamic(inflate_t *s)
+{
+    static const short  order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    short       lengths[MAXLCODES + MAXDCODES];
+    huffman_t   lencode;
+    huffman_t   distcode;
+    const int   nlen = P_InflateBits(s, 5) + 257;
+    const int   ndist = P_InflateBits(s, 5) + 1;
+    const int   ncode = P_InflateBits(s, 4) + 4;
+    int         index;
+    int         err;
+
+    if (s->error || nlen > MAXLCODES || ndist > MAXDCODES)
+    {
+        s->error = true;
+        return;
+    }
+
+    // read the code length code lengths
+    for (index = 0; index < ncode; index++)
+        lengths[order[index]] = P_InflateBits(s, 3);
+
+    for (; index < 19; index++)
+        lengths[order[index]] = 0;
+
+    if (s->error || P_InflateConstruct(&lencode, lengths, 19))
+    {
+        s->error = true;
+        return;
+    }
+
+    // read the literal/length and distance code lengths
+    index = 0;
+
+    while (index < nlen + ndist)
+    {
+        const int   symbol = P_InflateDecode(s, &lencode);
+
+        if (s->error)
+            return;
+
+        if (symbol < 16)
+            lengths[index++] = symbol;
+        else
+        {
+            short   value = 0;
+            int     len;
+
+            if (symbol == 16)
+            {
+                if (!index)
+                {
+                    s->error = true;
+                    return;
+                }
+
+                value = lengths[index - 1];
+                len = 3 + P_InflateBits(s, 2);
+            }
+            else if (symbol == 17)
+                len = 3 + P_InflateBits(s, 3);
+            else
+                len = 11 + P_InflateBits(s, 7);
+
+            if (s->error || index + len > nlen + ndist)
+            {
+                s->error = true;
+                return;
+            }
+
+            while (len--)
+                lengths[index++] = value;
+        }
+    }
+
+    // there must be an end-of-block code
+    if (!lengths[256])
+    {
+        s->error = true;
+        return;
+    }
+
+    if ((err = P_InflateConstruct(&lencode, lengths, nlen)) < 0 || (err > 0 && nlen - lencode.count[0] != 1))
+    {
+        s->error = true;
+        return;
+    }
+
+    if ((err = P_InflateConstruct(&distcode, lengths + nlen, ndist)) < 0 || (err > 0 && ndist - distcode.count[0] != 1))
+    {
+        s->error = true;
+        return;
+    }
+
+    P_InflateCodes(s, &lencode, &distcode);
+}
+
+//
+// P_InflateNodes
+//  Decompress the zlib stream that follows the ZNOD signature of a compressed
+//  ZDBSP nodes lump. Returns a buffer that must be freed, or NULL if the stream
+//  is corrupt.
+//
+byte *P_InflateNodes(const byte *data, int size, int *outsize)
+{
+    inflate_t   s;
+    int         last;
+
+    // check the zlib header
+    if (size < 2 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 || (data[1] & 0x20))
+        return NULL;
+
+    s.in = data + 2;
+    s.insize = size - 2;
+    s.inpos = 0;
+    s.bitbuf = 0;
+    s.bitcnt = 0;
+    s.outsize = MAX(size * 4, 1024);
+    s.out = malloc(s.outsize);
+    s.outpos = 0;
+    s.error = false;
+
+    do
+    {
+        int type;
+
+        last = P_InflateBits(&s, 1);
+        type = P_InflateBits(&s, 2);
+
+        if (s.error)
+            break;
+
+        if (type == 0)
+            P_InflateStored(&s);
+        else if (type == 1)
+            P_InflateFixed(&s);
+        else if (type == 2)
+            P_InflateDynamic(&s);
+        else
+            s.error = true;
+    } while (!last && !s.error);
+
+    if (s.error)
+    {
+        free(s.out);
+        return NULL;
+    }
+
+    *outsize = s.outpos;
+    return s.out;
+}
+
+//
+// Node builder
+//
+// Builds the nodes, subsectors and segs of a map from its linedefs, for maps
+// that have no nodes or whose nodes can't be used. Each partition line is
+// chosen to split as few segs as possible while keeping the tree balanced, and
+// lines along either axis are preferred since R_PointOnSide() can decide those
+// without multiplying. Once the top few levels of the tree have been built,
+// the subtrees below them are built in parallel, each into its own arrays, and
+// everything is then copied into the level's arrays with the root node last.
+//
+#define SPLITCOST       8
+#define DIAGONALCOST    2
+#define MAXCANDIDATES   128
+#define MINTASKSEGS     64
+#define ONLINE          (1.0 / 256.0)
+
+// a child that is a subtree being built separately
+#define NF_TASK         0x40000000
+
+typedef struct
+{
+    fixed_t         x1, y1;
+    fixed_t         x2, y2;
+
+    // original vertexes are 0 to numvertexes - 1, vertexes added by the top
+    // of the tree follow them, and vertexes added by a subtree are -1 down
+    int             v1, v2;
+
+    int             linedef;
+    int             side;
+    fixed_t         offset;
+} bseg_t;
+
+typedef struct
+{
+    int             firstseg;
+    int             numsegs;
+} bsubsector_t;
+
+typedef struct
+{
+    double          x, y;
+    double          dx, dy;
+    double          length;
+} partition_t;
+
+typedef struct
+{
+    dboolean        top;
+
+    node_t          *nodes;
+    int             numnodes;
+    int             maxnodes;
+
+    bsubsector_t    *subsectors;
+    int             numsubsectors;
+    int             maxsubsectors;
+
+    bseg_t          *segs;
+    int             numsegs;
+    int             maxsegs;
+
+    vertex_t        *vertices;
+    int             numvertices;
+    int             maxvertices;
+
+    int             *linestamps;
+    int             stamp;
+
+    int             root;
+} nodebuilder_t;
+
+typedef struct
+{
+    bseg_t          *segs;
+    int             numsegs;
+    nodebuilder_t   builder;
+    int             root;
+} nodetask_t;
+
+static nodetask_t   *nodetasks;
+static int          numnodetasks;
+static int          maxnodetasks;
+static SDL_atomic_t nextnodetask;
+static int          nodetaskdepth;
+
+static int          originalnumvertexes;
+static int          topvertexbase;
+
+static void *P_GrowArray(void *array, int *max, int num, size_t size)
+{
+    if (num >= *max)
+    {
+        *max = (*max ? *max * 2 : 64);
+        array = I_Realloc(array, *max * size);
+    }
+
+    return array;
+}
+
+static void P_InitNodeBuilder(nodebuilder_t *nb, dboolean top)
+{
+    memset(nb, 0, sizeof(*nb));
+    nb->top = top;
+    nb->linestamps = calloc(numlines, sizeof(*nb->linestamps));
+}
+
+static void P_FreeNodeBuilder(nodebuilder_t *nb)
+{
+    free(nb->nodes);
+    free(nb->subsectors);
+    free(nb->segs);
+    free(nb->vertices);
+    free(nb->linestamps);
+}
+
+static int P_NewVertex(nodebuilder_t *nb, fixed_t x, fixed_t y)
+{
+    const int   i = nb->numvertices++;
+
+    nb->vertices = P_GrowArray(nb->vertices, &nb->maxvertices, i, sizeof(*nb->vertices));
+    nb->vertices[i].x = x;
+    nb->vertices[i].y = y;
+
+    return (nb->top ? originalnumvertexes + i : -(i + 1));
+}
+
+static void P_SetPartition(partition_t *p, const bseg_t *seg)
+{
+    p->x = seg->x1;
+    p->y = seg->y1;
+    p->dx = (double)seg->x2 - seg->x1;
+    p->dy = (double)seg->y2 - seg->y1;
+    p->length = sqrt(p->dx * p->dx + p->dy * p->dy) * FRACUNIT;
+}
+
+// Distance in map units of a point in front of the partition line, or behind
+// it if negative.
+static double P_PartitionDistance(const partition_t *p, fixed_t x, fixed_t y)
+{
+    const double    d = ((x - p->x) * p->dy - (y - p->y) * p->dx) / p->length;
+
+    return (fabs(d) < ONLINE ? 0.0 : d);
+}
+
+// Returns 0 if the seg is in front of the partition line, 1 if it is behind
+// it, or 2 if it crosses it.
+static int P_ClassifySeg(const partition_t *p, const bseg_t *seg, double *d1, double *d2)
+{
+    *d1 = P_PartitionDistance(p, seg->x1, seg->y1);
+    *d2 = P_PartitionDistance(p, seg->x2, seg->y2);
+
+    if (*d1 == 0.0 && *d2 == 0.0)
+        return (((double)seg->x2 - seg->x1) * p->dx + ((double)seg->y2 - seg->y1) * p->dy > 0.0 ? 0 : 1);
+    else if (*d1 >= 0.0 && *d2 >= 0.0)
+        return 0;
+    else if (*d1 <= 0.0 && *d2 <= 0.0)
+        return 1;
+    else
+        return 2;
+}
+
+static int P_PartitionCost(const bseg_t *part, const bseg_t *segs, int numsegs, int bestcost)
+{
+    partition_t p;
+    int         front = 0;
+    int         back = 0;
+    int         splits = 0;
+    int         cost = (part->x1 != part->x2 && part->y1 != part->y2 ? DIAGONALCOST : 0);
+
+    P_SetPartition(&p, part);
+
+    for (int i = 0; i < numsegs; i++)
+    {
+        double  d1, d2;
+
+        switch (P_ClassifySeg(&p, segs + i, &d1, &d2))
+        {
+            case 0:
+                front++;
+                break;
+
+            case 1:
+                back++;
+                break;
+
+            default:
+                splits++;
+
+                if ((cost += SPLITCOST) >= bestcost)
+                    return INT_MAX;
+
+                break;
+        }
+    }
+
+    // a partition line must divide the segs
+    if (!splits && (!front || !back))
+        return INT_MAX;
+
+    return (cost + ABS(front - back));
+}
+
+// Returns the seg to use as the partition line, or -1 if the segs already
+// form a convex subsector.
+static int P_ChoosePartition(nodebuilder_t *nb, const bseg_t *segs, int numsegs)
+{
+    int best = -1;
+    int bestcost = INT_MAX;
+
+    // try a spread of candidates first, and only all of them if none divide the segs
+    for (int step = MAX(1, numsegs / MAXCANDIDATES); best == -1; step = 1)
+    {
+        nb->stamp++;
+
+        for (int i = 0; i < numsegs; i += step)
+        {
+            const bseg_t    *part = segs + i;
+            int             cost;
+
+            // the segs of a linedef all lie along the same line
+            if (nb->linestamps[part->linedef] == nb->stamp)
+                continue;
+
+            nb->linestamps[part->linedef] = nb->stamp;
+
+            if ((cost = P_PartitionCost(part, segs, numsegs, bestcost)) < bestcost)
+            {
+                bestcost = cost;
+                best = i;
+            }
+        }
+
+        if (step == 1)
+            break;
+    }
+
+    return best;
+}
+
+static void P_SplitSeg(nodebuilder_t *nb, const bseg_t *seg, double d1, double d2, bseg_t *front, bseg_t *back)
+{
+    bseg_t  a = *seg;
+    bseg_t  b = *seg;
+    double  x, y;
+    int     v;
+
+    // interpolate from the same end regardless of the seg's direction so both
+    // segs of a two-sided linedef are split at exactly the same point
+    if (seg->x1 < seg->x2 || (seg->x1 == seg->x2 && seg->y1 < seg->y2))
+    {
+        const double    t = d1 / (d1 - d2);
+
+        x = seg->x1 + t * ((double)seg->x2 - seg->x1);
+        y = seg->y1 + t * ((double)seg->y2 - seg->y1);
+    }
+    else
+    {
+        const double    t = d2 / (d2 - d1);
+
+        x = seg->x2 + t * ((double)seg->x1 - seg->x2);
+        y = seg->y2 + t * ((double)seg->y1 - seg->y2);
+    }
+
+    x = floor(x + 0.5);
+    y = floor(y + 0.5);
+    v = P_NewVertex(nb, (fixed_t)x, (fixed_t)y);
+
+    a.x2 = (fixed_t)x;
+    a.y2 = (fixed_t)y;
+    a.v2 = v;
+
+    b.x1 = (fixed_t)x;
+    b.y1 = (fixed_t)y;
+    b.v1 = v;
+    b.offset = seg->offset + (fixed_t)sqrt((x - seg->x1) * (x - seg->x1) + (y - seg->y1) * (y - seg->y1));
+
+    if (d1 > 0.0)
+    {
+        *front = a;
+        *back = b;
+    }
+    else
+    {
+        *front = b;
+        *back = a;
+    }
+}
+
+static int P_AddSubsector(nodebuilder_t *nb, const bseg_t *segs, int numsegs)
+{
+    const int       i = nb->numsubsectors++;
+    bsubsector_t    *subsector;
+
+    nb->subsectors = P_GrowArray(nb->subsectors, &nb->maxsubsectors, i, sizeof(*nb->subsectors));
+    subsector = nb->subsectors + i;
+    subsector->firstseg = nb->numsegs;
+    subsector->numsegs = numsegs;
+
+    for (int j = 0; j < numsegs; j++)
+    {
+        nb->segs = P_GrowArray(nb->segs, &nb->maxsegs, nb->numsegs, sizeof(*nb->segs));
+        nb->segs[nb->numsegs++] = segs[j];
+    }
+
+    return (i | NF_SUBSECTOR);
+}
+
+static int P_AddNode(nodebuilder_t *nb, const node_t *node)
+{
+    const int   i = nb->numnodes++;
+
+    nb->nodes = P_GrowArray(nb->nodes, &nb->maxnodes, i, sizeof(*nb->nodes));
+    nb->nodes[i] = *node;
+
+    return i;
+}
+
+static int P_AddNodeTask(const bseg_t *segs, int numsegs)
+{
+    const int   i = numnodetasks++;
+    nodetask_t  *task;
+
+    nodetasks = P_GrowArray(nodetasks, &maxnodetasks, i, sizeof(*nodetasks));
+    task = nodetasks + i;
+    task->segs = malloc(numsegs * sizeof(*segs));
+    memcpy(task->segs, segs, numsegs * sizeof(*segs));
+    task->numsegs = numsegs;
+
+    return (i | NF_TASK);
+}
+
+static int P_BuildSubtree(nodebuilder_t *nb, const bseg_t *segs, int numsegs, int depth)
+{
+    int         partition;
+    partition_t p;
+    node_t      node;
+    bseg_t      *front;
+    bseg_t      *back;
+    int         numfront = 0;
+    int         numback = 0;
+
+    // leave large enough subtrees below the top of the tree to be built in parallel
+    if (nb->top && depth >= nodetaskdepth && numsegs >= MINTASKSEGS)
+        return P_AddNodeTask(segs, numsegs);
+
+    if ((partition = P_ChoosePartition(nb, segs, numsegs)) == -1)
+        return P_AddSubsector(nb, segs, numsegs);
+
+    P_SetPartition(&p, segs + partition);
+    node.x = segs[partition].x1;
+    node.y = segs[partition].y1;
+    node.dx = segs[partition].x2 - segs[partition].x1;
+    node.dy = segs[partition].y2 - segs[partition].y1;
+
+    front = malloc(numsegs * sizeof(*front));
+    back = malloc(numsegs * sizeof(*back));
+
+    for (int i = 0; i < numsegs; i++)
+    {
+        double  d1, d2;
+
+        switch (P_ClassifySeg(&p, segs + i, &d1, &d2))
+        {
+            case 0:
+                front[numfront++] = segs[i];
+                break;
+
+            case 1:
+                back[numback++] = segs[i];
+                break;
+
+            default:
+                P_SplitSeg(nb, segs + i, d1, d2, front + numfront++, back + numback++);
+                break;
+        }
+    }
+
+    M_ClearBox(node.bbox[0]);
+    M_ClearBox(node.bbox[1]);
+
+    for (int i = 0; i < numfront; i++)
+    {
+        M_AddToBox(node.bbox[0], front[i].x1, front[i].y1);
+        M_AddToBox(node.bbox[0], front[i].x2, front[i].y2);
+    }
+
+    for (int i = 0; i < numback; i++)
+    {
+        M_AddToBox(node.bbox[1], back[i].x1, back[i].y1);
+        M_AddToBox(node.bbox[1], back[i].x2, back[i].y2);
+    }
+
+    node.children[0] = P_BuildSubtree(nb, front, numfront, depth + 1);
+    free(front);
+
+    node.children[1] = P_BuildSubtree(nb, back, numback, depth + 1);
+    free(back);
+
+    // children are always added before their parent, so the root is last
+    return P_AddNode(nb, &node);
+}
+
+static int SDLCALL P_NodeBuilderThread(void *data)
+{
+    int i;
+
+    while ((i = SDL_AtomicAdd(&nextnodetask, 1)) < numnodetasks)
+    {
+        nodetask_t  *task = nodetasks + i;
+
+        P_InitNodeBuilder(&task->builder, false);
+        task->builder.root = P_BuildSubtree(&task->builder, task->segs, task->numsegs, 0);
+        free(task->segs);
+    }
+
+    return 0;
+}
+
+static vertex_t *P_NodeVertex(int v, int vertexbase)
+{
+    if (v < 0)
+        return (vertexes + vertexbase - v - 1);
+    else if (v >= originalnumvertexes)
+        return (vertexes + topvertexbase + v - originalnumvertexes);
+    else
+        return (vertexes + v);
+}
+
+static int P_NodeChild(const nodebuilder_t *nb, int child, int nodebase, int subsectorbase)
+{
+    if (child & NF_SUBSECTOR)
+        return ((subsectorbase + (child & ~NF_SUBSECTOR)) | NF_SUBSECTOR);
+    else if (child & NF_TASK)
+        return nodetasks[child & ~NF_TASK].root;
+    else
+        return (nodebase + child);
+}
+
+// Copy what a builder built into the level's arrays, and return its root.
+static int P_CopyNodeBuilder(const nodebuilder_t *nb, int nodebase, int subsectorbase, int segbase, int vertexbase)
+{
+    for (int i = 0; i < nb->numvertices; i++)
+        vertexes[vertexbase + i] = nb->vertices[i];
+
+    for (int i = 0; i < nb->numsegs; i++)
+    {
+        const bseg_t    *bseg = nb->segs + i;
+        seg_t           *seg = segs + segbase + i;
+        line_t          *ldef = lines + bseg->linedef;
+        const int       side = bseg->side;
+
+        seg->v1 = P_NodeVertex(bseg->v1, vertexbase);
+        seg->v2 = P_NodeVertex(bseg->v2, vertexbase);
+        seg->offset = bseg->offset;
+        seg->linedef = ldef;
+        seg->sidedef = sides + ldef->sidenum[side];
+        seg->frontsector = seg->sidedef->sector;
+
+        if ((ldef->flags & ML_TWOSIDED) && ldef->sidenum[side ^ 1] != NO_INDEX)
+            seg->backsector = sides[ldef->sidenum[side ^ 1]].sector;
+        else
+        {
+            seg->backsector = NULL;
+            ldef->flags &= ~ML_TWOSIDED;
+        }
+
+        if (ldef->special >= MBFLINESPECIALS)
+            mbfcompatible = true;
+        else if (ldef->special >= BOOMLINESPECIALS)
+            boomcompatible = true;
+    }
+
+    for (int i = 0; i < nb->numsubsectors; i++)
+    {
+        subsectors[subsectorbase + i].firstline = segbase + nb->subsectors[i].firstseg;
+        subsectors[subsectorbase + i].numlines = nb->subsectors[i].numsegs;
+    }
+
+    for (int i = 0; i < nb->numnodes; i++)
+    {
+        node_t  *node = nodes + nodebase + i;
+
+        *node = nb->nodes[i];
+        node->children[0] = P_NodeChild(nb, node->children[0], nodebase, subsectorbase);
+        node->children[1] = P_NodeChild(nb, node->children[1], nodebase, subsectorbase);
+    }
+
+    return P_NodeChild(nb, nb->root, nodebase, subsectorbase);
+}
+
+//
+// P_BuildNodes
+//
+void P_BuildNodes(void)
+{
+    nodebuilder_t   nb;
+    bseg_t          *bsegs = malloc((size_t)numlines * 2 * sizeof(*bsegs));
+    int             numbsegs = 0;
+    const int       cpus = SDL_GetCPUCount();
+    int             totalvertices;
+    int             totalsubsectors;
+    int             totalsegs;
+    int             totalnodes;
+    int             nodebase = 0;
+    int             subsectorbase = 0;
+    int             segbase = 0;
+    int             vertexbase;
+    vertex_t        *newvertexes;
+
+    // create a seg for each side of each linedef
+    for (int i = 0; i < numlines; i++)
+    {
+        line_t  *line = lines + i;
+
+        if (line->v1->x == line->v2->x && line->v1->y == line->v2->y)
+            continue;
+
+        for (int side = 0; side < 2; side++)
+            if (line->sidenum[side] != NO_INDEX)
+            {
+                bseg_t          *seg = bsegs + numbsegs++;
+                const vertex_t  *v1 = (side ? line->v2 : line->v1);
+                const vertex_t  *v2 = (side ? line->v1 : line->v2);
+
+                seg->x1 = v1->x;
+                seg->y1 = v1->y;
+                seg->x2 = v2->x;
+                seg->y2 = v2->y;
+                seg->v1 = (int)(v1 - vertexes);
+                seg->v2 = (int)(v2 - vertexes);
+                seg->linedef = i;
+                seg->side = side;
+                seg->offset = 0;
+            }
+    }
+
+    if (!numbsegs)
+        I_Error("There are no segs in this map.");
+
+    // split the tree into enough subtrees to keep every core busy
+    nodetaskdepth = INT_MAX;
+
+    if (cpus > 1)
+        for (nodetaskdepth = 0; (1 << nodetaskdepth) < cpus * 4; nodetaskdepth++);
+
+    nodetasks = NULL;
+    numnodetasks = 0;
+    maxnodetasks = 0;
+    SDL_AtomicSet(&nextnodetask, 0);
+
+    originalnumvertexes = numvertexes;
+
+    P_InitNodeBuilder(&nb, true);
+    nb.root = P_BuildSubtree(&nb, bsegs, numbsegs, 0);
+    free(bsegs);
+
+    if (numnodetasks)
+    {
+        const int   numthreads = MIN(cpus, numnodetasks) - 1;
+        SDL_Thread  **threads = malloc(MAX(1, numthreads) * sizeof(*threads));
+
+        for (int i = 0; i < numthreads; i++)
+            threads[i] = SDL_CreateThread(P_NodeBuilderThread, "P_NodeBuilderThread", NULL);
+
+        // build subtrees on this thread too, which also ensures they are all
+        // built even if no threads could be created
+        P_NodeBuilderThread(NULL);
+
+        for (int i = 0; i < numthreads; i++)
+            if (threads[i])
+                SDL_WaitThread(threads[i], NULL);
+
+        free(threads);
+    }
+
+    totalvertices = nb.numvertices;
+    totalsubsectors = nb.numsubsectors;
+    totalsegs = nb.numsegs;
+    totalnodes = nb.numnodes;
+
+    for (int i = 0; i < numnodetasks; i++)
+    {
+        totalvertices += nodetasks[i].builder.numvertices;
+        totalsubsectors += nodetasks[i].builder.numsubsectors;
+        totalsegs += nodetasks[i].builder.numsegs;
+        totalnodes += nodetasks[i].builder.numnodes;
+    }
+
+    // add the new vertexes
+    newvertexes = calloc((size_t)numvertexes + totalvertices, sizeof(*newvertexes));
+    memcpy(newvertexes, vertexes, numvertexes * sizeof(*newvertexes));
+
+    for (int i = 0; i < numlines; i++)
+    {
+        lines[i].v1 = lines[i].v1 - vertexes + newvertexes;
+        lines[i].v2 = lines[i].v2 - vertexes + newvertexes;
+    }
+
+    free(vertexes);
+    vertexes = newvertexes;
+    numvertexes += totalvertices;
+
+    // the arrays are only kept between loads of the same map
+    if (samelevel)
+    {
+        free(segs);
+        free(subsectors);
+        free(nodes);
+    }
+
+    numsegs = totalsegs;
+    segs = calloc(numsegs, sizeof(*segs));
+    numsubsectors = totalsubsectors;
+    subsectors = calloc(numsubsectors, sizeof(*subsectors));
+    numnodes = totalnodes;
+    nodes = calloc(MAX(1, numnodes), sizeof(*nodes));
+
+    // copy the subtrees, then the top of the tree so its root is the last node
+    topvertexbase = originalnumvertexes;
+    vertexbase = topvertexbase + nb.numvertices;
+
+    for (int i = 0; i < numnodetasks; i++)
+    {
+        nodetask_t  *task = nodetasks + i;
+
+        task->root = P_CopyNodeBuilder(&task->builder, nodebase, subsectorbase, segbase, vertexbase);
+        nodebase += task->builder.numnodes;
+        subsectorbase += task->builder.numsubsectors;
+        segbase += task->builder.numsegs;
+        vertexbase += task->builder.numvertices;
+        P_FreeNodeBuilder(&task->builder);
+    }
+
+    P_CopyNodeBuilder(&nb, nodebase, subsectorbase, segbase, topvertexbase);
+    P_FreeNodeBuilder(&nb);
+
+    free(nodetasks);
+    nodetasks = NULL;
+    numnodetasks = 0;
+    maxnodetasks = 0;
+}
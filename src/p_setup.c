@@ -45,6 +45,7 @@
 #include "doomstat.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_argv.h"
 #include "m_bbox.h"
 #include "m_config.h"
@@ -53,11 +54,14 @@
 #include "m_random.h"
 #include "p_fix.h"
 #include "p_local.h"
+#include "p_nodes.h"
 #include "p_setup.h"
 #include "p_tick.h"
+#include "r_pvs.h"
 #include "s_sound.h"
 #include "sc_man.h"
 #include "st_stuff.h"
+#include "version.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
@@ -69,6 +73,9 @@
 
 #define NUMLIQUIDS              256
 
+// time a phase of loading a map for the loadstats CCMD
+#define PROFILE(call)           do { I_StartProfile(#call); call; I_EndProfile(); } while (false)
+
 #define MCMD_AUTHOR             1
 #define MCMD_CLUSTER            2
 #define MCMD_ENDBUNNY           3
@@ -191,9 +198,6 @@ int                 *blockmaplump;
 fixed_t             bmaporgx;
 fixed_t             bmaporgy;
 
-// for thing chains
-mobj_t              **blocklinks;
-
 // MAES: extensions to support 512x512 blockmaps.
 // They represent the maximum negative number which represents
 // a positive offset, otherwise they are left at -257, which
@@ -310,7 +314,9 @@ const char *mapformats[] =
 {
     "Regular",
     "<i>DeeP</i>",
-    "<i>ZDoom</i> extended (uncompressed)"
+    "<i>ZDoom</i> extended (uncompressed)",
+    "<i>ZDoom</i> extended (compressed)",
+    "Rebuilt when loaded"
 };
 
 dboolean        boomcompatible;
@@ -1482,6 +1488,16 @@ static void P_LoadNodes_V4(int lump)
     W_ReleaseLumpNum(lump);
 }
 
+// the decompressed nodes of a map with compressed ZDBSP nodes
+static byte *inflatednodes;
+static int  inflatednodessize;
+
+static void P_FreeInflatedNodes(void)
+{
+    free(inflatednodes);
+    inflatednodes = NULL;
+}
+
 // MB 2020-03-01: Fix endianness for 32-bit ZDoom nodes
 static void P_LoadZSegs(const byte *data)
 {
@@ -1577,9 +1593,8 @@ static void P_LoadZSegs(const byte *data)
 
 // MB 2020-03-01: Fix endianness for 32-bit ZDoom nodes
 // <https://zdoom.org/wiki/Node#ZDoom_extended_nodes>
-static void P_LoadZNodes(int lump)
+static void P_ReadZNodes(const byte *data)
 {
-    byte            *data = W_CacheLumpNum(lump);
     unsigned int    orgVerts;
     unsigned int    newVerts;
     unsigned int    numSubs;
@@ -1588,9 +1603,6 @@ static void P_LoadZNodes(int lump)
     unsigned int    numNodes;
     vertex_t        *newvertarray = NULL;
 
-    // skip header
-    data += 4;
-
     // Read extra vertexes added during node building
     orgVerts = LONG(*((const unsigned int *)data));
     data += sizeof(orgVerts);
@@ -1697,8 +1709,22 @@ static void P_LoadZNodes(int lump)
                 no->bbox[j][k] = SHORT(mn->bbox[j][k]) << FRACBITS;
         }
     }
+}
 
-    W_ReleaseLumpNum(lump);
+static void P_LoadZNodes(int lump)
+{
+    // compressed nodes were already decompressed by P_CheckMapFormat()
+    if (mapformat == ZDBSPZ)
+    {
+        P_ReadZNodes(inflatednodes);
+        P_FreeInflatedNodes();
+    }
+    else
+    {
+        // skip header
+        P_ReadZNodes((const byte *)W_CacheLumpNum(lump) + 4);
+        W_ReleaseLumpNum(lump);
+    }
 
     P_CheckLinedefs();
 }
@@ -2309,12 +2335,12 @@ static void P_LoadBlockMap(int lump)
 
     if (lump >= numlumps || (lumplen = W_LumpLength(lump)) < 8 || (count = lumplen / 2) >= 0x10000)
     {
-        P_CreateBlockMap();
+        PROFILE(P_CreateBlockMap());
         C_Warning(2, "The <b>BLOCKMAP</b> lump was rebuilt.");
     }
     else if (M_CheckParm("-blockmap"))
     {
-        P_CreateBlockMap();
+        PROFILE(P_CreateBlockMap());
         C_Warning(2, "A <b>-blockmap</b> parameter was found on the command-line. The <b>BLOCKMAP</b> lump was rebuilt.");
     }
     else
@@ -2348,13 +2374,13 @@ static void P_LoadBlockMap(int lump)
 
         if (!P_VerifyBlockMap(count))
         {
-            P_CreateBlockMap();
+            PROFILE(P_CreateBlockMap());
             C_Warning(2, "The <b>BLOCKMAP</b> lump was rebuilt.");
         }
     }
 
     // Clear out mobj chains
-    blocklinks = calloc_IfSameLevel(blocklinks, (size_t)bmapwidth * bmapheight, sizeof(*blocklinks));
+    P_InitThingGrid();
     blockmap = blockmaplump + 4;
 
     // MAES: set blockmapxneg and blockmapyneg
@@ -2781,6 +2807,234 @@ void P_MapName(int ep, int map)
     }
 }
 
+// Check that the sidedef a seg is on exists, since P_LoadSegs() can't continue
+// if it doesn't. A side other than 0 or 1 is changed to 1 there.
+static dboolean P_CheckSegSide(const maplinedef_t *linedefs, int linedef, int side, int mapsides)
+{
+    return ((unsigned short)SHORT(linedefs[linedef].sidenum[(side == 0 ? 0 : 1)]) < mapsides);
+}
+
+// Check that the nodes, subsectors and segs of a map in the regular format are
+// all there and only reference each other, so they can be used as they are.
+// Any bytes left over at the end of a lump are ignored, as they are when it's
+// loaded, and segs with invalid vertexes are left for P_LoadSegs() to fix.
+static dboolean P_CheckNodes(int lumpnum)
+{
+    const int   maplines = W_LumpLength(lumpnum + ML_LINEDEFS) / sizeof(maplinedef_t);
+    const int   mapsides = W_LumpLength(lumpnum + ML_SIDEDEFS) / sizeof(mapsidedef_t);
+    const int   mapsegs = W_LumpLength(lumpnum + ML_SEGS) / sizeof(mapseg_t);
+    const int   mapsubsectors = W_LumpLength(lumpnum + ML_SSECTORS) / sizeof(mapsubsector_t);
+    const int   mapnodes = W_LumpLength(lumpnum + ML_NODES) / sizeof(mapnode_t);
+    dboolean    result = true;
+
+    if (!mapsegs || !mapsubsectors || (!mapnodes && mapsubsectors > 1))
+        return false;
+
+    if (mapnodes)
+    {
+        const mapnode_t *data = W_CacheLumpNum(lumpnum + ML_NODES);
+
+        for (int i = 0; i < mapnodes && result; i++)
+            for (int j = 0; j < 2; j++)
+            {
+                const int   child = (unsigned short)SHORT(data[i].children[j]);
+
+                if (child != 0xFFFF && ((child & 0x8000) ? (child & ~0x8000) >= mapsubsectors : child >= mapnodes))
+                    result = false;
+            }
+
+        W_ReleaseLumpNum(lumpnum + ML_NODES);
+    }
+
+    if (result)
+    {
+        const mapsubsector_t    *data = W_CacheLumpNum(lumpnum + ML_SSECTORS);
+
+        for (int i = 0; i < mapsubsectors && result; i++)
+        {
+            const int   firstseg = (unsigned short)SHORT(data[i].firstseg);
+            const int   numsegs = (unsigned short)SHORT(data[i].numsegs);
+
+            if (!numsegs || firstseg + numsegs > mapsegs)
+                result = false;
+        }
+
+        W_ReleaseLumpNum(lumpnum + ML_SSECTORS);
+    }
+
+    if (result)
+    {
+        const mapseg_t      *data = W_CacheLumpNum(lumpnum + ML_SEGS);
+        const maplinedef_t  *linedefs = W_CacheLumpNum(lumpnum + ML_LINEDEFS);
+
+        for (int i = 0; i < mapsegs && result; i++)
+        {
+            const int   linedef = (unsigned short)SHORT(data[i].linedef);
+
+            if (linedef >= maplines || !P_CheckSegSide(linedefs, linedef, SHORT(data[i].side), mapsides))
+                result = false;
+        }
+
+        W_ReleaseLumpNum(lumpnum + ML_LINEDEFS);
+        W_ReleaseLumpNum(lumpnum + ML_SEGS);
+    }
+
+    return result;
+}
+
+static dboolean P_CheckNodeChild(int child, int mapnodes, int mapsubsectors)
+{
+    if (child & NF_SUBSECTOR)
+        return ((child & ~NF_SUBSECTOR) < mapsubsectors);
+    else
+        return (child < mapnodes);
+}
+
+// Check the nodes, subsectors and segs of a map in DeePBSP's extended format
+// the same way.
+static dboolean P_CheckNodes_V4(int lumpnum)
+{
+    const int   maplines = W_LumpLength(lumpnum + ML_LINEDEFS) / sizeof(maplinedef_t);
+    const int   mapsides = W_LumpLength(lumpnum + ML_SIDEDEFS) / sizeof(mapsidedef_t);
+    const int   mapsegs = W_LumpLength(lumpnum + ML_SEGS) / sizeof(mapseg_v4_t);
+    const int   mapsubsectors = W_LumpLength(lumpnum + ML_SSECTORS) / sizeof(mapsubsector_v4_t);
+    const int   mapnodes = ((size_t)W_LumpLength(lumpnum + ML_NODES) - 8) / sizeof(mapnode_v4_t);
+    dboolean    result = true;
+
+    if (!mapsegs || !mapsubsectors || (!mapnodes && mapsubsectors > 1))
+        return false;
+
+    if (mapnodes)
+    {
+        const mapnode_v4_t  *data = (const mapnode_v4_t *)((const byte *)W_CacheLumpNum(lumpnum + ML_NODES) + 8);
+
+        for (int i = 0; i < mapnodes && result; i++)
+            for (int j = 0; j < 2; j++)
+                if (!P_CheckNodeChild(data[i].children[j], mapnodes, mapsubsectors))
+                    result = false;
+
+        W_ReleaseLumpNum(lumpnum + ML_NODES);
+    }
+
+    if (result)
+    {
+        const mapsubsector_v4_t *data = W_CacheLumpNum(lumpnum + ML_SSECTORS);
+
+        for (int i = 0; i < mapsubsectors && result; i++)
+        {
+            const int   firstseg = data[i].firstseg;
+            const int   numsegs = data[i].numsegs;
+
+            if (!numsegs || firstseg < 0 || firstseg > mapsegs - numsegs)
+                result = false;
+        }
+
+        W_ReleaseLumpNum(lumpnum + ML_SSECTORS);
+    }
+
+    if (result)
+    {
+        const mapseg_v4_t   *data = W_CacheLumpNum(lumpnum + ML_SEGS);
+        const maplinedef_t  *linedefs = W_CacheLumpNum(lumpnum + ML_LINEDEFS);
+
+        // vertexes past the end are fixed by P_LoadSegs_V4(), but not negative ones
+        for (int i = 0; i < mapsegs && result; i++)
+        {
+            const int   linedef = (unsigned short)SHORT(data[i].linedef);
+
+            if (linedef >= maplines || !P_CheckSegSide(linedefs, linedef, SHORT(data[i].side), mapsides)
+                || data[i].v1 < 0 || data[i].v2 < 0)
+                result = false;
+        }
+
+        W_ReleaseLumpNum(lumpnum + ML_LINEDEFS);
+        W_ReleaseLumpNum(lumpnum + ML_SEGS);
+    }
+
+    return result;
+}
+
+static dboolean P_ReadZNodesCount(const byte **data, const byte *end, unsigned int *count)
+{
+    if (end - *data < (ptrdiff_t)sizeof(*count))
+        return false;
+
+    *count = LONG(*((const unsigned int *)*data));
+    *data += sizeof(*count);
+
+    return true;
+}
+
+// Check that a ZDBSP extended nodes lump, after its signature and once it has
+// been decompressed, has all the vertexes, subsectors, segs and nodes it says
+// it has, and that they only reference each other and the map's linedefs.
+static dboolean P_CheckZNodes(const byte *data, int size, int lumpnum)
+{
+    const byte          *end = data + size;
+    const int           maplines = W_LumpLength(lumpnum + ML_LINEDEFS) / sizeof(maplinedef_t);
+    const int           mapsides = W_LumpLength(lumpnum + ML_SIDEDEFS) / sizeof(mapsidedef_t);
+    const int           mapvertexes = W_LumpLength(lumpnum + ML_VERTEXES) / sizeof(mapvertex_t);
+    const maplinedef_t  *linedefs;
+    dboolean            result = true;
+    unsigned int        orgverts;
+    unsigned int        newverts;
+    unsigned int        numverts;
+    unsigned int        numsubs;
+    unsigned int        numsegs;
+    unsigned int        numnodes;
+    uint64_t            subsegs = 0;
+
+    if (!P_ReadZNodesCount(&data, end, &orgverts) || orgverts > (unsigned int)mapvertexes
+        || !P_ReadZNodesCount(&data, end, &newverts) || (size_t)(end - data) / (2 * sizeof(fixed_t)) < newverts)
+        return false;
+
+    numverts = orgverts + newverts;
+    data += newverts * 2 * sizeof(fixed_t);
+
+    if (!P_ReadZNodesCount(&data, end, &numsubs) || !numsubs || numsubs > INT_MAX
+        || (size_t)(end - data) / sizeof(mapsubsector_znod_t) < numsubs)
+        return false;
+
+    for (unsigned int i = 0; i < numsubs; i++)
+        subsegs += LONG(((const mapsubsector_znod_t *)data)[i].numsegs);
+
+    data += numsubs * sizeof(mapsubsector_znod_t);
+
+    if (!P_ReadZNodesCount(&data, end, &numsegs) || numsegs != subsegs
+        || (size_t)(end - data) / sizeof(mapseg_znod_t) < numsegs)
+        return false;
+
+    linedefs = W_CacheLumpNum(lumpnum + ML_LINEDEFS);
+
+    for (unsigned int i = 0; i < numsegs && result; i++)
+    {
+        const mapseg_znod_t *seg = (const mapseg_znod_t *)data + i;
+        const int           linedef = (unsigned short)SHORT(seg->linedef);
+
+        if (LONG(seg->v1) >= numverts || LONG(seg->v2) >= numverts || linedef >= maplines
+            || !P_CheckSegSide(linedefs, linedef, seg->side, mapsides))
+            result = false;
+    }
+
+    W_ReleaseLumpNum(lumpnum + ML_LINEDEFS);
+
+    if (!result)
+        return false;
+
+    data += numsegs * sizeof(mapseg_znod_t);
+
+    if (!P_ReadZNodesCount(&data, end, &numnodes) || numnodes > INT_MAX
+        || (size_t)(end - data) / sizeof(mapnode_znod_t) < numnodes || (!numnodes && numsubs > 1))
+        return false;
+
+    for (unsigned int i = 0; i < numnodes; i++)
+        for (int j = 0; j < 2; j++)
+            if (!P_CheckNodeChild(LONG(((const mapnode_znod_t *)data)[i].children[j]), numnodes, numsubs))
+                return false;
+
+    return true;
+}
+
 static mapformat_t P_CheckMapFormat(int lumpnum)
 {
     mapformat_t format = DOOMBSP;
@@ -2796,16 +3050,555 @@ static mapformat_t P_CheckMapFormat(int lumpnum)
             format = DEEPBSP;
         else if (!memcmp(n, "XNOD", 4) && !W_LumpLength(lumpnum + ML_SEGS) && W_LumpLength(lumpnum + ML_NODES) >= 12)
             format = ZDBSPX;
-        else if (!memcmp(n, "ZNOD", 4))
-            I_Error("Compressed ZDBSP nodes are not supported.");
+        else if (!memcmp(n, "ZNOD", 4) && !W_LumpLength(lumpnum + ML_SEGS) && W_LumpLength(lumpnum + ML_NODES) >= 6)
+            format = ZDBSPZ;
+
+        // build new nodes if those in the map are broken
+        if (format == DEEPBSP && !P_CheckNodes_V4(lumpnum))
+            format = REBUILTBSP;
+        else if (format == ZDBSPX && !P_CheckZNodes(n + 4, W_LumpLength(b) - 4, lumpnum))
+            format = REBUILTBSP;
+        else if (format == ZDBSPZ)
+        {
+            // keep the decompressed nodes for P_LoadZNodes()
+            if (!(inflatednodes = P_InflateNodes(n + 4, W_LumpLength(b) - 4, &inflatednodessize))
+                || !P_CheckZNodes(inflatednodes, inflatednodessize, lumpnum))
+            {
+                P_FreeInflatedNodes();
+                format = REBUILTBSP;
+            }
+        }
     }
 
     if (n)
         W_ReleaseLumpNum(b);
 
+    // build new nodes if those in the map are missing or broken
+    if (format == DOOMBSP && !P_CheckNodes(lumpnum))
+        format = REBUILTBSP;
+
     return format;
 }
 
+dboolean        levelcacheloaded;
+
+//
+// Level cache
+//
+// The fully processed geometry of each map is saved to a cache file after it
+// is loaded, so that the next time the map is loaded it can be read back in
+// instead of being rebuilt from the map's lumps. Pointers between the arrays
+// are saved as indexes, and the cache is keyed by a hash of the map's lumps,
+// the names of all lumps and textures, and anything else that changes how a
+// map is loaded.
+//
+#define LEVELCACHEID        "DRLC"
+#define LEVELCACHEVERSION   1
+
+typedef struct
+{
+    char        id[4];
+    int         version;
+    uint64_t    key;
+
+    int         numvertexes;
+    int         numsectors;
+    int         numsides;
+    int         numlines;
+    int         numsegs;
+    int         numsubsectors;
+    int         numnodes;
+    int         numlinebuffer;
+    int         numblockmap;
+
+    fixed_t     bmaporgx;
+    fixed_t     bmaporgy;
+    int         bmapwidth;
+    int         bmapheight;
+
+    int         numdamaging;
+    dboolean    transferredsky;
+    dboolean    boomcompatible;
+    dboolean    mbfcompatible;
+    dboolean    blockmaprebuilt;
+} levelcacheheader_t;
+
+#define PTRTOINDEX(p, base)         ((p) ? (void *)((intptr_t)((p) - (base)) + 1) : NULL)
+#define INDEXTOPTR(p, base)         ((p) ? (base) + ((intptr_t)(p) - 1) : NULL)
+#define VALIDINDEX(p, count)        (!(p) || ((intptr_t)(p) >= 1 && (intptr_t)(p) <= (count)))
+
+static uint64_t P_LevelCacheKey(int lumpnum)
+{
+    const int   parms[] =
+    {
+        LEVELCACHEVERSION, gamemission, gameepisode, gamemap, canmodify, r_fixmaperrors, mapformat,
+        (M_CheckParm("-blockmap") > 0), numlumps, numtextures, (int)sizeof(vertex_t), (int)sizeof(sector_t),
+        (int)sizeof(side_t), (int)sizeof(line_t), (int)sizeof(seg_t), (int)sizeof(subsector_t), (int)sizeof(node_t)
+    };
+    uint64_t    hash = M_Hash(PACKAGE_NAMEANDVERSIONSTRING, strlen(PACKAGE_NAMEANDVERSIONSTRING), HASHSEED);
+
+    hash = M_Hash(parms, sizeof(parms), hash);
+
+    for (int i = ML_THINGS; i <= ML_BLOCKMAP && lumpnum + i < numlumps; i++)
+    {
+        const int   lump = lumpnum + i;
+        const int   size = W_LumpLength(lump);
+
+        hash = M_Hash(&size, sizeof(size), hash);
+
+        if (size)
+        {
+            hash = M_Hash(W_CacheLumpNum(lump), size, hash);
+            W_ReleaseLumpNum(lump);
+        }
+    }
+
+    // texture, flat, colormap and translucency map numbers are all saved
+    for (int i = 0; i < numlumps; i++)
+        hash = M_Hash(lumpinfo[i]->name, 8, hash);
+
+    for (int i = 0; i < numtextures; i++)
+        hash = M_Hash(textures[i]->name, 8, hash);
+
+    return hash;
+}
+
+static char *P_LevelCachePath(const char *lumpname, int lumpnum)
+{
+    char        *appdatafolder = M_GetAppDataFolder();
+    char        *folder = M_StringJoin(appdatafolder, DIR_SEPARATOR_S, "levelcache", NULL);
+    const char  *wadpath = lumpinfo[lumpnum]->wadfile->path;
+    char        filename[64];
+    char        *path;
+
+    M_MakeDirectory(folder);
+    M_snprintf(filename, sizeof(filename), "%s-%08x.cache", lumpname,
+        (unsigned int)M_Hash(wadpath, strlen(wadpath), HASHSEED));
+    path = M_StringJoin(folder, DIR_SEPARATOR_S, filename, NULL);
+
+    free(appdatafolder);
+    free(folder);
+
+    return path;
+}
+
+// The size of the blockmap isn't kept, so find the end of its last blocklist
+static int P_BlockMapSize(void)
+{
+    int size = 4 + bmapwidth * bmapheight;
+
+    for (int i = 0; i < bmapwidth * bmapheight; i++)
+    {
+        int offset = blockmaplump[4 + i];
+
+        while (blockmaplump[offset] != -1)
+            offset++;
+
+        size = MAX(size, offset + 1);
+    }
+
+    return size;
+}
+
+static void P_SaveLevelCache(const char *path, uint64_t key)
+{
+    levelcacheheader_t  header;
+    FILE                *file;
+    line_t              **linebuffer = NULL;
+    int                 *lineindexes;
+    vertex_t            *v;
+    sector_t            *sec;
+    side_t              *sd;
+    line_t              *ld;
+    seg_t               *sg;
+    subsector_t         *ss;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.id, LEVELCACHEID, sizeof(header.id));
+    header.version = LEVELCACHEVERSION;
+    header.key = key;
+    header.numvertexes = numvertexes;
+    header.numsectors = numsectors;
+    header.numsides = numsides;
+    header.numlines = numlines;
+    header.numsegs = numsegs;
+    header.numsubsectors = numsubsectors;
+    header.numnodes = numnodes;
+    header.numblockmap = P_BlockMapSize();
+    header.bmaporgx = bmaporgx;
+    header.bmaporgy = bmaporgy;
+    header.bmapwidth = bmapwidth;
+    header.bmapheight = bmapheight;
+    header.numdamaging = numdamaging;
+    header.transferredsky = transferredsky;
+    header.boomcompatible = boomcompatible;
+    header.mbfcompatible = mbfcompatible;
+    header.blockmaprebuilt = blockmaprebuilt;
+
+    for (int i = 0; i < numsectors; i++)
+    {
+        header.numlinebuffer += sectors[i].linecount;
+
+        if (!linebuffer || (sectors[i].lines && sectors[i].lines < linebuffer))
+            linebuffer = sectors[i].lines;
+    }
+
+    v = malloc(numvertexes * sizeof(*v));
+    sec = malloc(numsectors * sizeof(*sec));
+    sd = malloc(numsides * sizeof(*sd));
+    ld = malloc(numlines * sizeof(*ld));
+    sg = malloc(numsegs * sizeof(*sg));
+    ss = malloc(numsubsectors * sizeof(*ss));
+    lineindexes = malloc(header.numlinebuffer * sizeof(*lineindexes));
+
+    memcpy(v, vertexes, numvertexes * sizeof(*v));
+    memcpy(sec, sectors, numsectors * sizeof(*sec));
+    memcpy(sd, sides, numsides * sizeof(*sd));
+    memcpy(ld, lines, numlines * sizeof(*ld));
+    memcpy(sg, segs, numsegs * sizeof(*sg));
+    memcpy(ss, subsectors, numsubsectors * sizeof(*ss));
+
+    for (int i = 0; i < header.numlinebuffer; i++)
+        lineindexes[i] = linebuffer[i] - lines;
+
+    for (int i = 0; i < numsectors; i++)
+    {
+        sec[i].lines = (void *)(intptr_t)(sectors[i].lines - linebuffer);
+        sec[i].soundtarget = NULL;
+        sec[i].thinglist = NULL;
+        sec[i].splatlist = NULL;
+        sec[i].floordata = NULL;
+        sec[i].ceilingdata = NULL;
+        sec[i].touching_thinglist = NULL;
+        sec[i].floorlightsec = PTRTOINDEX(sec[i].floorlightsec, sectors);
+        sec[i].ceilinglightsec = PTRTOINDEX(sec[i].ceilinglightsec, sectors);
+        sec[i].heightsec = PTRTOINDEX(sec[i].heightsec, sectors);
+        memset(&sec[i].soundorg.thinker, 0, sizeof(sec[i].soundorg.thinker));
+    }
+
+    for (int i = 0; i < numsides; i++)
+        sd[i].sector = PTRTOINDEX(sd[i].sector, sectors);
+
+    for (int i = 0; i < numlines; i++)
+    {
+        ld[i].v1 = PTRTOINDEX(ld[i].v1, vertexes);
+        ld[i].v2 = PTRTOINDEX(ld[i].v2, vertexes);
+        ld[i].frontsector = PTRTOINDEX(ld[i].frontsector, sectors);
+        ld[i].backsector = PTRTOINDEX(ld[i].backsector, sectors);
+        memset(&ld[i].soundorg.thinker, 0, sizeof(ld[i].soundorg.thinker));
+    }
+
+    for (int i = 0; i < numsegs; i++)
+    {
+        sg[i].v1 = PTRTOINDEX(sg[i].v1, vertexes);
+        sg[i].v2 = PTRTOINDEX(sg[i].v2, vertexes);
+        sg[i].sidedef = PTRTOINDEX(sg[i].sidedef, sides);
+        sg[i].linedef = PTRTOINDEX(sg[i].linedef, lines);
+        sg[i].frontsector = PTRTOINDEX(sg[i].frontsector, sectors);
+        sg[i].backsector = PTRTOINDEX(sg[i].backsector, sectors);
+    }
+
+    for (int i = 0; i < numsubsectors; i++)
+        ss[i].sector = PTRTOINDEX(ss[i].sector, sectors);
+
+    if ((file = fopen(path, "wb")))
+    {
+        const dboolean  result = (fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(v, sizeof(*v), numvertexes, file) == (size_t)numvertexes
+            && fwrite(sec, sizeof(*sec), numsectors, file) == (size_t)numsectors
+            && fwrite(sd, sizeof(*sd), numsides, file) == (size_t)numsides
+            && fwrite(ld, sizeof(*ld), numlines, file) == (size_t)numlines
+            && fwrite(sg, sizeof(*sg), numsegs, file) == (size_t)numsegs
+            && fwrite(ss, sizeof(*ss), numsubsectors, file) == (size_t)numsubsectors
+            && fwrite(nodes, sizeof(*nodes), numnodes, file) == (size_t)numnodes
+            && fwrite(lineindexes, sizeof(*lineindexes), header.numlinebuffer, file) == (size_t)header.numlinebuffer
+            && fwrite(blockmaplump, sizeof(*blockmaplump), header.numblockmap, file) == (size_t)header.numblockmap);
+
+        fclose(file);
+
+        if (!result)
+            remove(path);
+    }
+
+    free(v);
+    free(sec);
+    free(sd);
+    free(ld);
+    free(sg);
+    free(ss);
+    free(lineindexes);
+}
+
+static dboolean P_LoadLevelCache(const char *path, uint64_t key)
+{
+    levelcacheheader_t  header;
+    FILE                *file;
+    byte                *data;
+    size_t              size;
+    vertex_t            *v;
+    sector_t            *sec;
+    side_t              *sd;
+    line_t              *ld;
+    seg_t               *sg;
+    subsector_t         *ss;
+    node_t              *no;
+    int                 *lineindexes;
+    int                 *bmap;
+    line_t              **linebuffer;
+
+    if (!(file = fopen(path, "rb")))
+        return false;
+
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.id, LEVELCACHEID, sizeof(header.id))
+        || header.version != LEVELCACHEVERSION || header.key != key)
+    {
+        fclose(file);
+        return false;
+    }
+
+    size = header.numvertexes * sizeof(*v) + header.numsectors * sizeof(*sec) + header.numsides * sizeof(*sd)
+        + header.numlines * sizeof(*ld) + header.numsegs * sizeof(*sg) + header.numsubsectors * sizeof(*ss)
+        + header.numnodes * sizeof(*no) + header.numlinebuffer * sizeof(*lineindexes)
+        + header.numblockmap * sizeof(*bmap);
+
+    if (!(data = malloc(size)) || fread(data, 1, size, file) != size || fgetc(file) != EOF)
+    {
+        free(data);
+        fclose(file);
+        return false;
+    }
+
+    fclose(file);
+
+    v = (vertex_t *)data;
+    sec = (sector_t *)(v + header.numvertexes);
+    sd = (side_t *)(sec + header.numsectors);
+    ld = (line_t *)(sd + header.numsides);
+    sg = (seg_t *)(ld + header.numlines);
+    ss = (subsector_t *)(sg + header.numsegs);
+    no = (node_t *)(ss + header.numsubsectors);
+    lineindexes = (int *)(no + header.numnodes);
+    bmap = lineindexes + header.numlinebuffer;
+
+    // make sure every index is valid before anything is changed
+    for (int i = 0; i < header.numsectors; i++)
+        if ((intptr_t)sec[i].lines < 0 || (intptr_t)sec[i].lines + sec[i].linecount > header.numlinebuffer
+            || !VALIDINDEX(sec[i].floorlightsec, header.numsectors)
+            || !VALIDINDEX(sec[i].ceilinglightsec, header.numsectors)
+            || !VALIDINDEX(sec[i].heightsec, header.numsectors))
+        {
+            free(data);
+            return false;
+        }
+
+    for (int i = 0; i < header.numsides; i++)
+        if (!VALIDINDEX(sd[i].sector, header.numsectors))
+        {
+            free(data);
+            return false;
+        }
+
+    for (int i = 0; i < header.numlines; i++)
+        if (!VALIDINDEX(ld[i].v1, header.numvertexes) || !VALIDINDEX(ld[i].v2, header.numvertexes)
+            || !VALIDINDEX(ld[i].frontsector, header.numsectors) || !VALIDINDEX(ld[i].backsector, header.numsectors)
+            || (ld[i].sidenum[0] != NO_INDEX && ld[i].sidenum[0] >= header.numsides)
+            || (ld[i].sidenum[1] != NO_INDEX && ld[i].sidenum[1] >= header.numsides))
+        {
+            free(data);
+            return false;
+        }
+
+    for (int i = 0; i < header.numsegs; i++)
+        if (!VALIDINDEX(sg[i].v1, header.numvertexes) || !VALIDINDEX(sg[i].v2, header.numvertexes)
+            || !VALIDINDEX(sg[i].sidedef, header.numsides) || !VALIDINDEX(sg[i].linedef, header.numlines)
+            || !VALIDINDEX(sg[i].frontsector, header.numsectors) || !VALIDINDEX(sg[i].backsector, header.numsectors))
+        {
+            free(data);
+            return false;
+        }
+
+    for (int i = 0; i < header.numsubsectors; i++)
+        if (!VALIDINDEX(ss[i].sector, header.numsectors) || ss[i].firstline < 0 || ss[i].numlines < 0
+            || ss[i].firstline + ss[i].numlines > header.numsegs)
+        {
+            free(data);
+            return false;
+        }
+
+    for (int i = 0; i < header.numnodes; i++)
+        for (int j = 0; j < 2; j++)
+        {
+            const int   child = no[i].children[j];
+
+            if ((child & NF_SUBSECTOR) ? (child & ~NF_SUBSECTOR) >= header.numsubsectors :
+                (child < 0 || child >= header.numnodes))
+            {
+                free(data);
+                return false;
+            }
+        }
+
+    for (int i = 0; i < header.numlinebuffer; i++)
+        if (lineindexes[i] < 0 || lineindexes[i] >= header.numlines)
+        {
+            free(data);
+            return false;
+        }
+
+    if (header.bmapwidth <= 0 || header.bmapheight <= 0
+        || header.numblockmap < 4 + header.bmapwidth * header.bmapheight)
+    {
+        free(data);
+        return false;
+    }
+
+    for (int i = 0; i < header.bmapwidth * header.bmapheight; i++)
+    {
+        int offset = bmap[4 + i];
+
+        if (offset < 0)
+        {
+            free(data);
+            return false;
+        }
+
+        // every blocklist must end before the blockmap does, and only list lines that exist
+        for (; offset < header.numblockmap && bmap[offset] != -1; offset++)
+            if (bmap[offset] < 0 || bmap[offset] >= header.numlines)
+            {
+                free(data);
+                return false;
+            }
+
+        if (offset >= header.numblockmap)
+        {
+            free(data);
+            return false;
+        }
+    }
+
+    numvertexes = header.numvertexes;
+    numsectors = header.numsectors;
+    numsides = header.numsides;
+    numlines = header.numlines;
+    numsegs = header.numsegs;
+    numsubsectors = header.numsubsectors;
+    numnodes = header.numnodes;
+
+    vertexes = malloc_IfSameLevel(vertexes, numvertexes * sizeof(*vertexes));
+    sectors = malloc_IfSameLevel(sectors, numsectors * sizeof(*sectors));
+    sides = malloc_IfSameLevel(sides, numsides * sizeof(*sides));
+    lines = malloc_IfSameLevel(lines, numlines * sizeof(*lines));
+    segs = malloc_IfSameLevel(segs, numsegs * sizeof(*segs));
+    subsectors = malloc_IfSameLevel(subsectors, numsubsectors * sizeof(*subsectors));
+    nodes = malloc_IfSameLevel(nodes, numnodes * sizeof(*nodes));
+    linebuffer = Z_Malloc(header.numlinebuffer * sizeof(*linebuffer), PU_LEVEL, NULL);
+
+    memcpy(vertexes, v, numvertexes * sizeof(*vertexes));
+    memcpy(sectors, sec, numsectors * sizeof(*sectors));
+    memcpy(sides, sd, numsides * sizeof(*sides));
+    memcpy(lines, ld, numlines * sizeof(*lines));
+    memcpy(segs, sg, numsegs * sizeof(*segs));
+    memcpy(subsectors, ss, numsubsectors * sizeof(*subsectors));
+    memcpy(nodes, no, numnodes * sizeof(*nodes));
+
+    for (int i = 0; i < header.numlinebuffer; i++)
+        linebuffer[i] = lines + lineindexes[i];
+
+    for (int i = 0; i < numsectors; i++)
+    {
+        sectors[i].lines = linebuffer + (intptr_t)sectors[i].lines;
+        sectors[i].floorlightsec = INDEXTOPTR(sectors[i].floorlightsec, sectors);
+        sectors[i].ceilinglightsec = INDEXTOPTR(sectors[i].ceilinglightsec, sectors);
+        sectors[i].heightsec = INDEXTOPTR(sectors[i].heightsec, sectors);
+    }
+
+    for (int i = 0; i < numsides; i++)
+        sides[i].sector = INDEXTOPTR(sides[i].sector, sectors);
+
+    for (int i = 0; i < numlines; i++)
+    {
+        lines[i].v1 = INDEXTOPTR(lines[i].v1, vertexes);
+        lines[i].v2 = INDEXTOPTR(lines[i].v2, vertexes);
+        lines[i].frontsector = INDEXTOPTR(lines[i].frontsector, sectors);
+        lines[i].backsector = INDEXTOPTR(lines[i].backsector, sectors);
+    }
+
+    for (int i = 0; i < numsegs; i++)
+    {
+        segs[i].v1 = INDEXTOPTR(segs[i].v1, vertexes);
+        segs[i].v2 = INDEXTOPTR(segs[i].v2, vertexes);
+        segs[i].sidedef = INDEXTOPTR(segs[i].sidedef, sides);
+        segs[i].linedef = INDEXTOPTR(segs[i].linedef, lines);
+        segs[i].frontsector = INDEXTOPTR(segs[i].frontsector, sectors);
+        segs[i].backsector = INDEXTOPTR(segs[i].backsector, sectors);
+    }
+
+    for (int i = 0; i < numsubsectors; i++)
+        subsectors[i].sector = INDEXTOPTR(subsectors[i].sector, sectors);
+
+    if (!samelevel)
+    {
+        blockmaplump = malloc(header.numblockmap * sizeof(*blockmaplump));
+        memcpy(blockmaplump, bmap, header.numblockmap * sizeof(*blockmaplump));
+        bmaporgx = header.bmaporgx;
+        bmaporgy = header.bmaporgy;
+        bmapwidth = header.bmapwidth;
+        bmapheight = header.bmapheight;
+        blockmaprebuilt = header.blockmaprebuilt;
+        blockmap = blockmaplump + 4;
+        blockmapxneg = (bmapwidth > 255 ? bmapwidth - 512 : -257);
+        blockmapyneg = (bmapheight > 255 ? bmapheight - 512 : -257);
+    }
+
+    P_InitThingGrid();
+
+    numdamaging = header.numdamaging;
+    transferredsky = header.transferredsky;
+    boomcompatible = header.boomcompatible;
+    mbfcompatible = header.mbfcompatible;
+
+    free(data);
+
+    return true;
+}
+
+//
+// P_SaveLoadStats
+//  Save how long each phase of loading the current map took as JSON.
+//
+dboolean P_SaveLoadStats(const char *filename)
+{
+    FILE    *file = fopen(filename, "wt");
+
+    if (!file)
+        return false;
+
+    fprintf(file, "{\n  \"map\": \"%s\",\n  \"levelcache\": %s,\n  \"scopes\": [\n",
+        mapnum, (levelcacheloaded ? "true" : "false"));
+
+    for (int i = 0; i < numprofiles; i++)
+    {
+        const profile_t *profile = profiles + i;
+
+        fprintf(file, "    { \"name\": \"%.*s\", \"parent\": ", profile->namelength, profile->name);
+
+        if (profile->parent == -1)
+            fputs("null", file);
+        else
+            fprintf(file, "\"%.*s\"", profiles[profile->parent].namelength, profiles[profile->parent].name);
+
+        fprintf(file, ", \"depth\": %i, \"calls\": %i, \"ms\": %.3f, \"bytes\": %llu }%s\n",
+            profile->depth, profile->calls, I_ProfileTime(profile), (unsigned long long)profile->bytes,
+            (i < numprofiles - 1 ? "," : ""));
+    }
+
+    fputs("  ]\n}\n", file);
+    fclose(file);
+
+    return true;
+}
+
 //
 // P_SetupLevel
 //
@@ -2815,6 +3608,12 @@ void P_SetupLevel(int ep, int map)
     int         lumpnum;
     static int  prevlumpnum = -1;
     char        *temp;
+    uint64_t    levelcachekey;
+    char        *levelcachepath;
+    int         i;
+
+    I_StartProfiling();
+    I_StartProfile("P_SetupLevel");
 
     boomcompatible = false;
     mbfcompatible = false;
@@ -2885,7 +3684,15 @@ void P_SetupLevel(int ep, int map)
 
     prevlumpnum = lumpnum;
 
+    // read the map's lumps in the background while its format is checked
+    W_CancelPrefetches();
+
+    for (i = ML_THINGS; i <= ML_BLOCKMAP; i++)
+        W_PrefetchLump(lumpnum + i);
+
+    I_StartProfile("P_CheckMapFormat");
     mapformat = P_CheckMapFormat(lumpnum);
+    I_EndProfile();
 
     canmodify = ((W_CheckMultipleLumps(lumpname) == 1 || (sigil && gamemission == doom) || gamemission == pack_nerve
         || (nerve && gamemission == doom2)) && !FREEDOOM);
@@ -2916,7 +3723,6 @@ void P_SetupLevel(int ep, int map)
         free(segs);
         free(nodes);
         free(subsectors);
-        free(blocklinks);
         free(blockmaplump);
         free(lines);
         free(sides);
@@ -2924,44 +3730,77 @@ void P_SetupLevel(int ep, int map)
         free(vertexes);
     }
 
-    // note: most of this ordering is important
-    P_LoadVertexes(lumpnum + ML_VERTEXES);
-    P_LoadSectors(lumpnum + ML_SECTORS);
-    P_LoadSideDefs(lumpnum + ML_SIDEDEFS);
-    P_LoadLineDefs(lumpnum + ML_LINEDEFS);
-    P_LoadSideDefs2(lumpnum + ML_SIDEDEFS);
-
-    // killough 01/30/98: Create xref tables for tags
-    P_InitTagLists();
+    levelcachekey = P_LevelCacheKey(lumpnum);
+    levelcachepath = P_LevelCachePath(lumpname, lumpnum);
 
-    P_LoadLineDefs2();
+    I_StartProfile("P_LoadLevelCache");
+    levelcacheloaded = P_LoadLevelCache(levelcachepath, levelcachekey);
+    I_EndProfile();
 
-    if (!samelevel)
-        P_LoadBlockMap(lumpnum + ML_BLOCKMAP);
-    else
-        memset(blocklinks, 0, (size_t)bmapwidth * bmapheight * sizeof(*blocklinks));
-
-    if (mapformat == ZDBSPX)
-        P_LoadZNodes(lumpnum + ML_NODES);
-    else if (mapformat == DEEPBSP)
+    if (levelcacheloaded)
     {
-        P_LoadSubsectors_V4(lumpnum + ML_SSECTORS);
-        P_LoadNodes_V4(lumpnum + ML_NODES);
-        P_LoadSegs_V4(lumpnum + ML_SEGS);
+        P_FreeInflatedNodes();
+        PROFILE(P_LoadReject(lumpnum));
     }
     else
     {
-        P_LoadSubsectors(lumpnum + ML_SSECTORS);
-        P_LoadNodes(lumpnum + ML_NODES);
-        P_LoadSegs(lumpnum + ML_SEGS);
+        // note: most of this ordering is important
+        PROFILE(P_LoadVertexes(lumpnum + ML_VERTEXES));
+        PROFILE(P_LoadSectors(lumpnum + ML_SECTORS));
+        PROFILE(P_LoadSideDefs(lumpnum + ML_SIDEDEFS));
+        PROFILE(P_LoadLineDefs(lumpnum + ML_LINEDEFS));
+        PROFILE(P_LoadSideDefs2(lumpnum + ML_SIDEDEFS));
+
+        // killough 01/30/98: Create xref tables for tags
+        PROFILE(P_InitTagLists());
+
+        PROFILE(P_LoadLineDefs2());
+
+        if (!samelevel)
+            PROFILE(P_LoadBlockMap(lumpnum + ML_BLOCKMAP));
+        else
+            P_InitThingGrid();
+
+        if (mapformat == ZDBSPX || mapformat == ZDBSPZ)
+            PROFILE(P_LoadZNodes(lumpnum + ML_NODES));
+        else if (mapformat == REBUILTBSP)
+        {
+            PROFILE(P_BuildNodes());
+            P_CheckLinedefs();
+            C_Warning(2, "The nodes in this map were rebuilt.");
+        }
+        else if (mapformat == DEEPBSP)
+        {
+            PROFILE(P_LoadSubsectors_V4(lumpnum + ML_SSECTORS));
+            PROFILE(P_LoadNodes_V4(lumpnum + ML_NODES));
+            PROFILE(P_LoadSegs_V4(lumpnum + ML_SEGS));
+        }
+        else
+        {
+            PROFILE(P_LoadSubsectors(lumpnum + ML_SSECTORS));
+            PROFILE(P_LoadNodes(lumpnum + ML_NODES));
+            PROFILE(P_LoadSegs(lumpnum + ML_SEGS));
+        }
+
+        PROFILE(P_GroupLines());
+        PROFILE(P_LoadReject(lumpnum));
+
+        PROFILE(P_RemoveSlimeTrails());
+
+        PROFILE(P_CalcSegsLength());
+
+        PROFILE(P_SaveLevelCache(levelcachepath, levelcachekey));
     }
 
-    P_GroupLines();
-    P_LoadReject(lumpnum);
+    PROFILE(R_InitRenderSegs());
+    PROFILE(R_InitPVS(levelcachepath, levelcachekey));
+
+    free(levelcachepath);
 
-    P_RemoveSlimeTrails();
+    // start reading flats and wall patches now that sectors and sidedefs are known
+    R_PrefetchLevel();
 
-    P_CalcSegsLength();
+    PROFILE(R_InitSubsectorGrid());
 
     r_bloodsplats_total = 0;
 
@@ -2977,23 +3816,29 @@ void P_SetupLevel(int ep, int map)
     P_GetMapNoLiquids((ep - 1) * 10 + map);
     P_SetLiquids();
 
-    P_LoadThings(lumpnum + ML_THINGS);
+    PROFILE(P_LoadThings(lumpnum + ML_THINGS));
 
     P_InitCards();
 
     // set up world state
-    P_SpawnSpecials();
-    P_SetLifts();
+    PROFILE(P_SpawnSpecials());
+    PROFILE(P_SetLifts());
 
-    P_MapEnd();
+    PROFILE(P_MapEnd());
 
     // preload graphics
-    R_PrecacheLevel();
+    PROFILE(R_PrecacheLevel());
 
-    S_Start();
+    PROFILE(S_Start());
 
     if (gamemode != shareware)
         S_ParseMusInfo(lumpname);
+
+    I_EndProfile();
+    I_StopProfiling();
+
+    if ((i = M_CheckParmWithArgs("-loadstats", 1, 1)))
+        P_SaveLoadStats(myargv[i + 1]);
 }
 
 static int  liquidlumps;
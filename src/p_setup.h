@@ -40,6 +40,7 @@
 #define __P_SETUP_H__
 
 extern dboolean     canmodify;
+extern dboolean     levelcacheloaded;
 extern dboolean     samelevel;
 extern dboolean     skipblstart;    // MaxW: Skip initial blocklist short
 extern const char   *linespecials[];
@@ -50,6 +51,7 @@ extern char         mapnumandtitle[512];
 extern char         automaptitle[512];
 
 void P_SetupLevel(int ep, int map);
+dboolean P_SaveLoadStats(const char *filename);
 void P_MapName(int ep, int map);
 
 // Called by startup code.
@@ -3148,10 +3148,10 @@ void T_Pusher(pusher_t *p)
         tmbbox[BOXRIGHT] = p->x + radius;
         tmbbox[BOXLEFT] = p->x - radius;
 
-        xl = P_GetSafeBlockX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
-        xh = P_GetSafeBlockX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
-        yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
-        yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
+        xl = P_GetThingGridX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
+        xh = P_GetThingGridX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
+        yl = P_GetThingGridY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
+        yh = P_GetThingGridY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
 
         for (int bx = xl; bx <= xh; bx++)
             for (int by = yl; by <= yh; by++)
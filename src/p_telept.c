@@ -36,6 +36,7 @@
 ========================================================================
 */
 
+#include "am_map.h"
 #include "p_local.h"
 #include "p_tick.h"
 #include "s_sound.h"
@@ -103,9 +104,13 @@ dboolean EV_Teleport(line_t *line, int side, mobj_t *thing)
                 {
                     // [BH] teleport can now be drawn on automap
                     if (line->backsector)
+                    {
                         for (int j = 0; j < line->backsector->linecount; j++)
                             line->backsector->lines[j]->flags |= ML_TELEPORTTRIGGERED;
 
+                        mapwindowchanged = true;
+                    }
+
                     // don't move for a bit
                     thing->reactiontime = 18;
 
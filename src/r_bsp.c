@@ -44,16 +44,21 @@
 #include "m_config.h"
 #include "r_main.h"
 #include "r_plane.h"
+#include "r_pvs.h"
 #include "r_segs.h"
 #include "r_things.h"
 
-seg_t       *curline;
-line_t      *linedef;
-sector_t    *frontsector;
-sector_t    *backsector;
+seg_t           *curline;
+line_t          *linedef;
+renderline_t    *renderline;
+sector_t        *frontsector;
+sector_t        *backsector;
 
-drawseg_t   *drawsegs;
-drawseg_t   *ds_p;
+drawseg_t       *drawsegs;
+drawseg_t       *ds_p;
+
+renderseg_t     *rendersegs;
+renderline_t    *renderlines;
 
 //
 // R_ClearDrawSegs
@@ -121,18 +126,47 @@ void R_ClearClipSegs(void)
     memset(solidcol, 0, SCREENWIDTH);
 }
 
+//
+// R_InitRenderSegs
+// Copies what R_AddLine() needs from each seg into a compact array, and
+// clears the flags of each linedef, once a map has been loaded.
+//
+void R_InitRenderSegs(void)
+{
+    free(rendersegs);
+    free(renderlines);
+
+    rendersegs = malloc(numsegs * sizeof(*rendersegs));
+    renderlines = calloc(numlines, sizeof(*renderlines));
+
+    for (int i = 0; i < numsegs; i++)
+    {
+        const seg_t *seg = segs + i;
+        renderseg_t *rseg = rendersegs + i;
+
+        rseg->x1 = seg->v1->x;
+        rseg->y1 = seg->v1->y;
+        rseg->x2 = seg->v2->x;
+        rseg->y2 = seg->v2->y;
+        rseg->linenum = seg->linedef - lines;
+    }
+
+    for (int i = 0; i < numlines; i++)
+        renderlines[i].validcount = -1;
+}
+
 // killough 01/18/98 -- This function is used to fix the automap bug which
 // showed lines behind closed doors simply because the door had a dropoff.
 //
 // cph - converted to R_RecalcLineFlags. This recalculates all the flags for
 // a line, including closure and texture tiling.
-static void R_RecalcLineFlags(line_t *line)
+static void R_RecalcLineFlags(renderline_t *line)
 {
     int c;
 
-    line->r_validcount = gametime;
+    line->validcount = gametime;
 
-    if (!(line->flags & ML_TWOSIDED)
+    if (!(linedef->flags & ML_TWOSIDED)
         || backsector->interpceilingheight <= frontsector->interpfloorheight
         || backsector->interpfloorheight >= frontsector->interpceilingheight
         || (backsector->interpceilingheight <= backsector->interpfloorheight
@@ -142,7 +176,7 @@ static void R_RecalcLineFlags(line_t *line)
                 || curline->sidedef->bottomtexture)
             && (backsector->ceilingpic != skyflatnum
                 || frontsector->ceilingpic != skyflatnum)))
-        line->r_flags = RF_CLOSED;
+        line->flags = RF_CLOSED;
     else
     {
         if (backsector->interpceilingheight != frontsector->interpceilingheight
@@ -150,34 +184,34 @@ static void R_RecalcLineFlags(line_t *line)
             || curline->sidedef->midtexture
             || memcmp(&backsector->floorxoffset, &frontsector->floorxoffset, memcmpsize))
         {
-            line->r_flags = RF_NONE;
+            line->flags = RF_NONE;
             return;
         }
         else
-            line->r_flags = RF_IGNORE;
+            line->flags = RF_IGNORE;
     }
 
     if (curline->sidedef->rowoffset)
         return;
 
-    if (line->flags & ML_TWOSIDED)
+    if (linedef->flags & ML_TWOSIDED)
     {
         // Does top texture need tiling
         if ((c = frontsector->interpceilingheight - backsector->interpceilingheight) > 0
             && textureheight[texturetranslation[curline->sidedef->toptexture]] > c)
-            line->r_flags |= RF_TOP_TILE;
+            line->flags |= RF_TOP_TILE;
 
         // Does bottom texture need tiling
         if ((c = frontsector->interpfloorheight - backsector->interpfloorheight) > 0
             && textureheight[texturetranslation[curline->sidedef->bottomtexture]] > c)
-            line->r_flags |= RF_BOT_TILE;
+            line->flags |= RF_BOT_TILE;
     }
     else
     {
         // Does middle texture need tiling
         if ((c = frontsector->interpceilingheight - frontsector->interpfloorheight) > 0
             && textureheight[texturetranslation[curline->sidedef->midtexture]] > c)
-            line->r_flags |= RF_MID_TILE;
+            line->flags |= RF_MID_TILE;
     }
 }
 
@@ -330,25 +364,53 @@ sector_t *R_FakeFlat(sector_t *sec, sector_t *tempsec, int *floorlightlevel, int
     return sec;
 }
 
+//
+// R_PointOnRenderSegSide
+// The same as R_PointOnSegSide(), but only using what's in a renderseg_t.
+//
+static int R_PointOnRenderSegSide(fixed_t x, fixed_t y, const renderseg_t *rseg)
+{
+    const fixed_t   lx = rseg->x1;
+    const fixed_t   ly = rseg->y1;
+    const int64_t   ldx = (int64_t)rseg->x2 - lx;
+    const int64_t   ldy = (int64_t)rseg->y2 - ly;
+
+    if (!ldx)
+        return (x <= lx ? (ldy > 0) : (ldy < 0));
+
+    if (!ldy)
+        return (y <= ly ? (ldx < 0) : (ldx > 0));
+
+    x -= lx;
+    y -= ly;
+
+    // Try to quickly decide by looking at sign bits.
+    if ((ldy ^ ldx ^ x ^ y) < 0)
+        return ((ldy ^ x) < 0); // (left is negative)
+
+    return (y * ldx >= ldy * x);
+}
+
 //
 // R_AddLine
 // Clips the given segment and adds any visible pieces to the line list.
 //
 static void R_AddLine(seg_t *line)
 {
-    int     x1;
-    int     x2;
-    angle_t angle1;
-    angle_t angle2;
+    const renderseg_t   *rseg = rendersegs + (line - segs);
+    int                 x1;
+    int                 x2;
+    angle_t             angle1;
+    angle_t             angle2;
 
     curline = line;
 
     // Skip this line if it's not facing the camera
-    if (R_PointOnSegSide(viewx, viewy, line))
+    if (R_PointOnRenderSegSide(viewx, viewy, rseg))
         return;
 
-    angle1 = R_PointToAngleEx(line->v1->x, line->v1->y);
-    angle2 = R_PointToAngleEx(line->v2->x, line->v2->y);
+    angle1 = R_PointToAngleEx(rseg->x1, rseg->y1);
+    angle2 = R_PointToAngleEx(rseg->x2, rseg->y2);
 
     // Back side? I.e. backface culling?
     if (angle1 - angle2 >= ANG180)
@@ -390,6 +452,10 @@ static void R_AddLine(seg_t *line)
     if (x1 >= x2)
         return;
 
+    // Skip this line if it was already found to be invisible this tic
+    if ((renderline = renderlines + rseg->linenum)->validcount == gametime && (renderline->flags & RF_IGNORE))
+        return;
+
     // Single sided line?
     if ((backsector = line->backsector))
     {
@@ -402,13 +468,48 @@ static void R_AddLine(seg_t *line)
         backsector = R_FakeFlat(backsector, &tempsec, NULL, NULL, true);
     }
 
-    if ((linedef = curline->linedef)->r_validcount != gametime)
-        R_RecalcLineFlags(linedef);
+    linedef = curline->linedef;
 
-    if (linedef->r_flags & RF_IGNORE)
-        return;
+    if (renderline->validcount != gametime)
+    {
+        R_RecalcLineFlags(renderline);
+
+        if (renderline->flags & RF_IGNORE)
+            return;
+    }
 
-    R_ClipWallSegment(x1, x2, (linedef->r_flags & RF_CLOSED));
+    R_ClipWallSegment(x1, x2, (renderline->flags & RF_CLOSED));
+}
+
+//
+// View frustum
+// The left and right edges of the view, each as the direction along it and
+// the corner of a bounding box that is furthest inside it, so that whole
+// boxes can be rejected by R_CheckBBox() without any angles being found.
+//
+static int64_t  leftcos, leftsin;
+static int64_t  rightcos, rightsin;
+static int      leftx, lefty;
+static int      rightx, righty;
+
+static void R_SetupFrustum(void)
+{
+    // widen the view a little so only boxes clearly outside it are rejected
+    const angle_t   leftangle = (viewangle + clipangle + ANG1) >> ANGLETOFINESHIFT;
+    const angle_t   rightangle = (viewangle - clipangle - ANG1) >> ANGLETOFINESHIFT;
+
+    leftcos = finecosine[leftangle];
+    leftsin = finesine[leftangle];
+    rightcos = finecosine[rightangle];
+    rightsin = finesine[rightangle];
+
+    // points are outside the left edge if they are to the left of it...
+    leftx = (leftsin < 0 ? BOXLEFT : BOXRIGHT);
+    lefty = (leftcos > 0 ? BOXBOTTOM : BOXTOP);
+
+    // ...and outside the right edge if they are to the right of it
+    rightx = (rightsin < 0 ? BOXRIGHT : BOXLEFT);
+    righty = (rightcos > 0 ? BOXTOP : BOXBOTTOM);
 }
 
 //
@@ -450,6 +551,11 @@ static dboolean R_CheckBBox(const fixed_t *bspcoord)
     if (boxpos == 5)
         return true;
 
+    // Reject the box if it's entirely outside either edge of the view.
+    if (leftcos * ((int64_t)bspcoord[lefty] - viewy) - leftsin * ((int64_t)bspcoord[leftx] - viewx) > 0
+        || rightcos * ((int64_t)bspcoord[righty] - viewy) - rightsin * ((int64_t)bspcoord[rightx] - viewx) < 0)
+        return false;
+
     check = checkcoord[boxpos];
 
     // check clip list for an open space
@@ -568,12 +674,15 @@ void R_RenderBSPNode(int bspnum)
     int stack[MAX_BSP_DEPTH];
     int sp = 0;
 
+    R_SetupFrustum();
+
     while (true)
     {
         const node_t    *bsp;
         int             side;
 
-        while (!(bspnum & NF_SUBSECTOR))
+        // skip any subtree with nothing in it that can be seen
+        while (!(bspnum & NF_SUBSECTOR) && R_InPVS(bspnum))
         {
             if (sp == MAX_BSP_DEPTH)
                 break;
@@ -585,7 +694,8 @@ void R_RenderBSPNode(int bspnum)
             bspnum = bsp->children[side];
         }
 
-        R_Subsector(bspnum == -1 ? 0 : (bspnum & ~NF_SUBSECTOR));
+        if ((bspnum & NF_SUBSECTOR) && R_InPVS(bspnum))
+            R_Subsector(bspnum == -1 ? 0 : (bspnum & ~NF_SUBSECTOR));
 
         if (!sp)
             return;
@@ -593,7 +703,7 @@ void R_RenderBSPNode(int bspnum)
         side = stack[--sp] ^ 1;
         bsp = nodes + stack[--sp];
 
-        while (!R_CheckBBox(bsp->bbox[side]))
+        while (!R_InPVS(bsp->children[side]) || !R_CheckBBox(bsp->bbox[side]))
         {
             if (!sp)
                 return;
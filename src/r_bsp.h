@@ -41,6 +41,7 @@
 
 extern seg_t        *curline;
 extern line_t       *linedef;
+extern renderline_t *renderline;
 extern sector_t     *frontsector;
 extern sector_t     *backsector;
 
@@ -50,8 +51,12 @@ extern byte         *solidcol;
 
 extern drawseg_t    *ds_p;
 
+extern renderseg_t  *rendersegs;
+extern renderline_t *renderlines;
+
 // BSP?
 void R_InitClipSegs(void);
+void R_InitRenderSegs(void);
 void R_ClearClipSegs(void);
 void R_ClearDrawSegs(void);
 
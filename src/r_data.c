@@ -838,7 +838,7 @@ int R_TextureNumForName(char *name)
 //
 // Totally rewritten by Lee Killough to use less memory,
 // to avoid using alloca(), and to improve performance.
-void R_PrecacheLevel(void)
+static void R_ForEachLevelGraphic(void (*func)(int lumpnum))
 {
     dboolean    *hitlist = calloc(MAX(numtextures, numflats), sizeof(dboolean));
 
@@ -851,10 +851,10 @@ void R_PrecacheLevel(void)
 
     for (int i = 0; i < numflats; i++)
         if (hitlist[i])
-            W_CacheLumpNum(firstflat + i);
+            func(firstflat + i);
 
     // Precache textures.
-    memset(hitlist, false, sizeof(*hitlist));
+    memset(hitlist, false, MAX(numtextures, numflats) * sizeof(*hitlist));
 
     for (int i = 0; i < numsides; i++)
     {
@@ -877,8 +877,28 @@ void R_PrecacheLevel(void)
             texture_t   *texture = textures[i];
 
             for (int j = 0; j < texture->patchcount; j++)
-                W_CacheLumpNum(texture->patches[j].patch);
+                func(texture->patches[j].patch);
         }
 
     free(hitlist);
 }
+
+static void R_CacheLump(int lumpnum)
+{
+    W_CacheLumpNum(lumpnum);
+}
+
+void R_PrecacheLevel(void)
+{
+    R_ForEachLevelGraphic(&R_CacheLump);
+}
+
+//
+// R_PrefetchLevel
+// Queues the graphics that R_PrecacheLevel() will load to be read in the
+// background while the rest of the level is set up.
+//
+void R_PrefetchLevel(void)
+{
+    R_ForEachLevelGraphic(&W_PrefetchLump);
+}
@@ -129,6 +129,7 @@ byte *R_GetTextureColumn(const rpatch_t *texpatch, int col);
 // I/O, setting up the stuff.
 void R_InitData(void);
 void R_PrecacheLevel(void);
+void R_PrefetchLevel(void);
 
 // Retrieval.
 // Floor/ceiling opaque texture tiles, lookup by name. For animation?
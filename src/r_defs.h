@@ -287,7 +287,18 @@ typedef struct line_s
     int                 nexttag;
     int                 firsttag;
 
-    int                 r_validcount;   // cph: if == gametime, r_flags already done
+    // sound origin for switches/buttons
+    degenmobj_t         soundorg;
+} line_t;
+
+//
+// The parts of a LineDef that the renderer works out once every tic, kept
+// apart from the rest of it so that R_AddLine() can reject a seg without
+// touching its LineDef.
+//
+typedef struct
+{
+    int                 validcount;     // cph: if == gametime, flags already done
 
     enum
     {
@@ -297,11 +308,8 @@ typedef struct line_s
         RF_BOT_TILE =  4,               // Lower texture needs tiling
         RF_IGNORE   =  8,               // Renderer can skip this line
         RF_CLOSED   = 16                // Line blocks view
-    } r_flags;
-
-    // sound origin for switches/buttons
-    degenmobj_t         soundorg;
-} line_t;
+    } flags;
+} renderline_t;
 
 enum
 {
@@ -810,6 +818,18 @@ typedef struct
     int                 fakecontrast;
 } seg_t;
 
+//
+// The parts of a seg that R_AddLine() needs to cull it, kept apart from the
+// rest of it so that more segs fit in each cache line while walking the BSP
+// tree.
+//
+typedef struct
+{
+    fixed_t             x1, y1;
+    fixed_t             x2, y2;
+    int                 linenum;
+} renderseg_t;
+
 //
 // BSP node.
 //
@@ -46,8 +46,10 @@
 #include "p_local.h"
 #include "p_setup.h"
 #include "p_tick.h"
+#include "r_pvs.h"
 #include "r_sky.h"
 #include "v_video.h"
+#include "z_zone.h"
 
 // increment every time a check is made
 int                 validcount = 1;
@@ -720,6 +722,85 @@ void R_Init(void)
     R_InitColumnFunctions();
 }
 
+//
+// R_BoxOnNodeSide
+// Returns the side of a node's partition line that a box is entirely on, or
+// -1 if the partition line crosses it. Each corner is tested with the same
+// fixed-point maths as R_PointOnSide(), so every point in the box will be
+// put on the same side by it.
+//
+static int R_BoxOnNodeSide(fixed_t left, fixed_t bottom, fixed_t right, fixed_t top, const node_t *node)
+{
+    const fixed_t   nx = node->x;
+    const fixed_t   ny = node->y;
+    const int64_t   ndx = node->dx;
+    const int64_t   ndy = node->dy;
+    const fixed_t   corners[4][2] = { { left, bottom }, { right, bottom }, { left, top }, { right, top } };
+    int             side = -1;
+
+    for (int i = 0; i < 4; i++)
+    {
+        const fixed_t   x = (fixed_t)((int64_t)corners[i][0] - nx);
+        const fixed_t   y = (fixed_t)((int64_t)corners[i][1] - ny);
+        const int64_t   cross = y * ndx - ndy * x;
+        int             cornerside;
+
+        // a corner on the partition line itself could go either way
+        if (!cross)
+            return -1;
+
+        cornerside = (cross > 0);
+
+        if (side == -1)
+            side = cornerside;
+        else if (side != cornerside)
+            return -1;
+    }
+
+    return side;
+}
+
+// the node or subsector that R_PointInSubsector() starts from in each block
+static int  *subsectorgrid;
+
+//
+// R_InitSubsectorGrid
+// For each block in the blockmap, find the deepest node in the BSP tree
+// that contains the whole of it, or the subsector it is entirely within,
+// so R_PointInSubsector() can start there instead of at the root.
+//
+void R_InitSubsectorGrid(void)
+{
+    if (!numnodes || bmapwidth <= 0 || bmapheight <= 0)
+        return;
+
+    subsectorgrid = Z_Malloc(bmapwidth * bmapheight * sizeof(*subsectorgrid), PU_LEVEL, (void **)&subsectorgrid);
+
+    for (int by = 0; by < bmapheight; by++)
+    {
+        // the first and last fixed-point coordinates within the block
+        const int64_t   bottom = (int64_t)bmaporgy + (int64_t)by * MAPBLOCKSIZE;
+        const int64_t   top = bottom + MAPBLOCKSIZE - 1;
+
+        for (int bx = 0; bx < bmapwidth; bx++)
+        {
+            const int64_t   left = (int64_t)bmaporgx + (int64_t)bx * MAPBLOCKSIZE;
+            const int64_t   right = left + MAPBLOCKSIZE - 1;
+            int             nodenum = numnodes - 1;
+            int             side;
+
+            // a block beyond the range of fixed-point coordinates starts at the root
+            if (right <= INT_MAX && top <= INT_MAX)
+                while (!(nodenum & NF_SUBSECTOR)
+                    && (side = R_BoxOnNodeSide((fixed_t)left, (fixed_t)bottom, (fixed_t)right, (fixed_t)top,
+                        nodes + nodenum)) != -1)
+                    nodenum = nodes[nodenum].children[side];
+
+            subsectorgrid[by * bmapwidth + bx] = nodenum;
+        }
+    }
+}
+
 //
 // R_PointInSubsector
 //
@@ -730,7 +811,13 @@ subsector_t *R_PointInSubsector(fixed_t x, fixed_t y)
         return subsectors;
     else
     {
-        int nodenum = numnodes - 1;
+        int                 nodenum = numnodes - 1;
+        const unsigned int  bx = (unsigned int)((int64_t)x - bmaporgx) >> MAPBLOCKSHIFT;
+        const unsigned int  by = (unsigned int)((int64_t)y - bmaporgy) >> MAPBLOCKSHIFT;
+
+        // start from the grid if the point is within it
+        if (subsectorgrid && bx < (unsigned int)bmapwidth && by < (unsigned int)bmapheight)
+            nodenum = subsectorgrid[by * bmapwidth + bx];
 
         while (!(nodenum & NF_SUBSECTOR))
         {
@@ -867,6 +954,7 @@ static void R_SetupFrame(void)
 void R_RenderPlayerView(void)
 {
     R_SetupFrame();
+    R_SetupPVS();
 
     // Clear buffers.
     R_ClearClipSegs();
@@ -0,0 +1,1344 @@
+/*
+========================================================================
+
+                           D O O M  R e t r o
+         The classic, refined DOOM source port. For Windows PC.
+
+========================================================================
+
+  Copyright © 1993-2012 by id Software LLC, a ZeniMax Media company.
+  Copyright © 2013-2020 by Brad Harding.
+
+  DOOM Retro is a fork of Chocolate DOOM. For a list of credits, see
+  <https://github.com/bradharding/doomretro/wiki/CREDITS>.
+
+  This file is a part of DOOM Retro.
+
+  DOOM Retro is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  DOOM Retro is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with DOOM Retro. If not, see <https://www.gnu.org/licenses/>.
+
+  DOOM is a registered trademark of id Software LLC, a ZeniMax Media
+  company, in the US and/or other countries, and is used without
+  permission. All other trademarks are the property of their respective
+  holders. DOOM Retro is in no way affiliated with nor endorsed by
+  id Software.
+
+========================================================================
+*/
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#include "doomstat.h"
+#include "i_system.h"
+#include "m_config.h"
+#include "m_misc.h"
+#include "r_main.h"
+#include "r_pvs.h"
+#include "r_state.h"
+
+//
+// Potentially visible set
+//
+// For each subsector, the set of subsectors that might be seen from anywhere
+// within it is found when a map is loaded, so that R_RenderBSPNode() can skip
+// whole subtrees that can never be seen instead of rejecting them one node at
+// a time with R_CheckBBox().
+//
+// The BSP tree is first cut into convex regions, and any subtree that has no
+// one-sided linedefs within it is merged into a single convex cluster. The
+// edges that clusters share are turned into portals, less any parts that lie
+// along one-sided linedefs. Only one-sided linedefs block sight, since sectors
+// can change height. Then, in the same way as Quake's vis, a flow through the
+// portals from each portal narrows the window through which the next portal
+// can be seen until nothing more can be. The windows already flowed through
+// each portal are remembered so that the same paths aren't flowed again.
+//
+// Each row of the PVS is compressed with a run-length encoding of its zeros,
+// and it is cached alongside the level cache.
+//
+#define PVSEPSILON      0.01
+#define PVSCUTEPSILON   0.1
+#define PVSMAXMEMORY    (256 * 1024 * 1024)
+#define PVSMAXDEPTH     512
+#define PVSMAXFLOW      (1 << 18)
+#define PVSMAXPIECES    64
+#define PVSMAXMEMOS     16
+
+#define PVSID           "DRPV"
+#define PVSVERSION      1
+
+typedef struct
+{
+    double          x, y;
+} pvspoint_t;
+
+typedef struct
+{
+    pvspoint_t      p1, p2;
+
+    // the normal points into the cluster the portal leads to
+    double          nx, ny;
+    double          dist;
+
+    int             from;
+    int             cluster;
+
+    uint32_t        *mightsee;
+    int             mightcount;
+    uint32_t        *vis;
+    SDL_atomic_t    done;
+} pvsportal_t;
+
+typedef struct
+{
+    pvspoint_t      *points;
+    int             numpoints;
+} pvspolygon_t;
+
+typedef struct
+{
+    int             leaf;
+    double          t1, t2;
+} pvspiece_t;
+
+typedef struct
+{
+    float           s1, s2;
+    float           t1, t2;
+} pvsmemo_t;
+
+typedef struct
+{
+    uint32_t        *vis;
+    uint32_t        *might;
+    int             *stack;
+    byte            *row;
+    int             flow;
+    dboolean        overflow;
+
+    // the windows each portal has already been flowed through
+    const pvsportal_t   *source;
+    pvsmemo_t       *memos;
+    byte            *memocounts;
+    int             *memoflows;
+    int             numflows;
+} pvsworker_t;
+
+typedef struct
+{
+    char            id[4];
+    int             version;
+    uint64_t        key;
+    int             numsubsectors;
+    int             numnodes;
+    int             numclusters;
+    int             size;
+} pvsheader_t;
+
+int                 *pvsclusters;
+byte                *pvsrow;
+byte                *pvsnodes;
+dboolean            pvsactive;
+
+dboolean            r_pvs = r_pvs_default;
+
+static byte         *pvsdata;
+static int          *pvsoffsets;
+static int          *pvsorder;
+static int          numpvsorder;
+static int          numclusters;
+static int          pvscluster;
+
+static pvspolygon_t *regions;
+static pvsportal_t  *portals;
+static int          numportals;
+static int          maxportals;
+static int          *firstportal;
+static int          *portalcounts;
+static int          *portalorder;
+static int          rowwords;
+
+static byte         **rows;
+static int          *rowsizes;
+
+static SDL_atomic_t nextpvsitem;
+
+static void R_AddPVSPortal(int from, int cluster, pvspoint_t p1, pvspoint_t p2, double nx, double ny)
+{
+    pvsportal_t *portal;
+
+    if (numportals == maxportals)
+    {
+        maxportals = (maxportals ? maxportals * 2 : 1024);
+        portals = I_Realloc(portals, maxportals * sizeof(*portals));
+    }
+
+    portal = portals + numportals++;
+    portal->p1 = p1;
+    portal->p2 = p2;
+    portal->nx = nx;
+    portal->ny = ny;
+    portal->dist = nx * p1.x + ny * p1.y;
+    portal->from = from;
+    portal->cluster = cluster;
+    portal->mightsee = NULL;
+    portal->mightcount = 0;
+    portal->vis = NULL;
+    SDL_AtomicSet(&portal->done, false);
+}
+
+// Cuts a convex polygon along a line, keeping the part on its front side.
+static pvspolygon_t R_ClipPVSPolygon(const pvspolygon_t *polygon, double x, double y, double dx, double dy)
+{
+    pvspolygon_t    result;
+    const double    length = sqrt(dx * dx + dy * dy);
+
+    result.points = malloc((polygon->numpoints + 1) * sizeof(*result.points));
+    result.numpoints = 0;
+
+    for (int i = 0; i < polygon->numpoints; i++)
+    {
+        const pvspoint_t    *p1 = polygon->points + i;
+        const pvspoint_t    *p2 = polygon->points + (i + 1) % polygon->numpoints;
+        const double        d1 = ((p1->x - x) * dy - (p1->y - y) * dx) / length;
+        const double        d2 = ((p2->x - x) * dy - (p2->y - y) * dx) / length;
+
+        if (d1 >= -PVSEPSILON)
+            result.points[result.numpoints++] = *p1;
+
+        if ((d1 > PVSEPSILON && d2 < -PVSEPSILON) || (d1 < -PVSEPSILON && d2 > PVSEPSILON))
+        {
+            const double    f = d1 / (d1 - d2);
+
+            result.points[result.numpoints].x = p1->x + f * (p2->x - p1->x);
+            result.points[result.numpoints++].y = p1->y + f * (p2->y - p1->y);
+        }
+    }
+
+    if (result.numpoints < 3)
+        result.numpoints = 0;
+
+    return result;
+}
+
+// Clips a segment to the part where nx * x + ny * y >= dist.
+static dboolean R_ClipPVSSegment(pvspoint_t *p1, pvspoint_t *p2, double nx, double ny, double dist)
+{
+    const double    d1 = nx * p1->x + ny * p1->y - dist;
+    const double    d2 = nx * p2->x + ny * p2->y - dist;
+    double          f;
+    pvspoint_t      p;
+
+    if (d1 >= -PVSEPSILON && d2 >= -PVSEPSILON)
+        return true;
+    else if (d1 < -PVSEPSILON && d2 < -PVSEPSILON)
+        return false;
+
+    f = d1 / (d1 - d2);
+    p.x = p1->x + f * (p2->x - p1->x);
+    p.y = p1->y + f * (p2->y - p1->y);
+
+    if (d1 < 0.0)
+        *p1 = p;
+    else
+        *p2 = p;
+
+    return true;
+}
+
+// Finds which leaves lie along each part of a segment on a node's partition
+// line. The normal points into the side of the partition the subtree is on.
+static void R_FilterPVSPortal(int child, pvspoint_t p1, pvspoint_t p2, double nx, double ny,
+    const pvspoint_t *origin, double ux, double uy, pvspiece_t **pieces, int *numpieces, int *maxpieces)
+{
+    while (!(child & NF_SUBSECTOR))
+    {
+        const node_t    *node = nodes + child;
+        const double    x = FIXED2DOUBLE(node->x);
+        const double    y = FIXED2DOUBLE(node->y);
+        const double    dx = FIXED2DOUBLE(node->dx);
+        const double    dy = FIXED2DOUBLE(node->dy);
+        const double    length = sqrt(dx * dx + dy * dy);
+        const double    d1 = ((p1.x - x) * dy - (p1.y - y) * dx) / length;
+        const double    d2 = ((p2.x - x) * dy - (p2.y - y) * dx) / length;
+
+        if (fabs(d1) <= PVSEPSILON && fabs(d2) <= PVSEPSILON)
+            child = node->children[(nx * dy - ny * dx) <= 0.0];
+        else if (d1 >= -PVSEPSILON && d2 >= -PVSEPSILON)
+            child = node->children[0];
+        else if (d1 <= PVSEPSILON && d2 <= PVSEPSILON)
+            child = node->children[1];
+        else
+        {
+            const double    f = d1 / (d1 - d2);
+            pvspoint_t      p;
+
+            p.x = p1.x + f * (p2.x - p1.x);
+            p.y = p1.y + f * (p2.y - p1.y);
+
+            R_FilterPVSPortal(node->children[d1 < 0.0], p1, p, nx, ny, origin, ux, uy, pieces, numpieces, maxpieces);
+            p1 = p;
+            child = node->children[d2 < 0.0];
+        }
+    }
+
+    if (*numpieces == *maxpieces)
+    {
+        *maxpieces = (*maxpieces ? *maxpieces * 2 : 64);
+        *pieces = I_Realloc(*pieces, *maxpieces * sizeof(**pieces));
+    }
+
+    (*pieces)[*numpieces].leaf = child & ~NF_SUBSECTOR;
+    (*pieces)[*numpieces].t1 = fmin((p1.x - origin->x) * ux + (p1.y - origin->y) * uy,
+        (p2.x - origin->x) * ux + (p2.y - origin->y) * uy);
+    (*pieces)[(*numpieces)++].t2 = fmax((p1.x - origin->x) * ux + (p1.y - origin->y) * uy,
+        (p2.x - origin->x) * ux + (p2.y - origin->y) * uy);
+}
+
+static int R_ComparePVSPieces(const void *a, const void *b)
+{
+    const double    t1 = ((const pvspiece_t *)a)->t1;
+    const double    t2 = ((const pvspiece_t *)b)->t1;
+
+    return (t1 < t2 ? -1 : (t1 > t2));
+}
+
+// Removes the parts of [t1, t2] that lie along a one-sided seg of a subsector.
+static int R_SubtractPVSSegs(int leaf, const pvspoint_t *origin, double ux, double uy,
+    double *t1, double *t2, int count)
+{
+    const subsector_t   *subsector = subsectors + leaf;
+
+    for (int i = 0; i < subsector->numlines; i++)
+    {
+        const seg_t     *seg = segs + subsector->firstline + i;
+        const double    x1 = FIXED2DOUBLE(seg->v1->x) - origin->x;
+        const double    y1 = FIXED2DOUBLE(seg->v1->y) - origin->y;
+        const double    x2 = FIXED2DOUBLE(seg->v2->x) - origin->x;
+        const double    y2 = FIXED2DOUBLE(seg->v2->y) - origin->y;
+        double          s1, s2;
+
+        if (seg->backsector || fabs(x1 * uy - y1 * ux) > PVSEPSILON || fabs(x2 * uy - y2 * ux) > PVSEPSILON)
+            continue;
+
+        s1 = fmin(x1 * ux + y1 * uy, x2 * ux + y2 * uy) - PVSEPSILON;
+        s2 = fmax(x1 * ux + y1 * uy, x2 * ux + y2 * uy) + PVSEPSILON;
+
+        for (int j = count - 1; j >= 0; j--)
+        {
+            if (s2 <= t1[j] || s1 >= t2[j])
+                continue;
+
+            if (s1 > t1[j] && s2 < t2[j])
+            {
+                // the seg splits the piece in two
+                if (count == PVSMAXPIECES)
+                    continue;
+
+                t1[count] = s2;
+                t2[count++] = t2[j];
+                t2[j] = s1;
+            }
+            else if (s1 > t1[j])
+                t2[j] = s1;
+            else if (s2 < t2[j])
+                t1[j] = s2;
+            else
+            {
+                t1[j] = t1[--count];
+                t2[j] = t2[count];
+            }
+        }
+    }
+
+    return count;
+}
+
+// Restricts a portal to the part of it that is on the edge of the area that
+// is actually inside a subsector, which is the front side of all its segs.
+static dboolean R_ClipPVSPortalToSubsector(int leaf, pvspoint_t *p1, pvspoint_t *p2)
+{
+    const subsector_t   *subsector = subsectors + leaf;
+
+    for (int i = 0; i < subsector->numlines; i++)
+    {
+        const seg_t     *seg = segs + subsector->firstline + i;
+        const double    x = FIXED2DOUBLE(seg->v1->x);
+        const double    y = FIXED2DOUBLE(seg->v1->y);
+        const double    dx = FIXED2DOUBLE(seg->v2->x) - x;
+        const double    dy = FIXED2DOUBLE(seg->v2->y) - y;
+        const double    length = sqrt(dx * dx + dy * dy);
+
+        if (length > PVSEPSILON && !R_ClipPVSSegment(p1, p2, dy / length, -dx / length, (x * dy - y * dx) / length))
+            return false;
+    }
+
+    return true;
+}
+
+static void R_AddPVSPortals(int front, int back, const pvspoint_t *origin, double ux, double uy,
+    double t1, double t2)
+{
+    pvspoint_t  p1 = { origin->x + ux * t1, origin->y + uy * t1 };
+    pvspoint_t  p2 = { origin->x + ux * t2, origin->y + uy * t2 };
+    double      pieces1[PVSMAXPIECES];
+    double      pieces2[PVSMAXPIECES];
+    int         count = 1;
+
+    // there are no portals within a cluster
+    if (pvsclusters[front] == pvsclusters[back]
+        || !R_ClipPVSPortalToSubsector(front, &p1, &p2) || !R_ClipPVSPortalToSubsector(back, &p1, &p2))
+        return;
+
+    pieces1[0] = (p1.x - origin->x) * ux + (p1.y - origin->y) * uy;
+    pieces2[0] = (p2.x - origin->x) * ux + (p2.y - origin->y) * uy;
+
+    if (pieces1[0] > pieces2[0])
+    {
+        const double    temp = pieces1[0];
+
+        pieces1[0] = pieces2[0];
+        pieces2[0] = temp;
+    }
+
+    count = R_SubtractPVSSegs(front, origin, ux, uy, pieces1, pieces2, count);
+    count = R_SubtractPVSSegs(back, origin, ux, uy, pieces1, pieces2, count);
+
+    for (int i = 0; i < count; i++)
+        if (pieces2[i] - pieces1[i] > PVSEPSILON)
+        {
+            p1.x = origin->x + ux * pieces1[i];
+            p1.y = origin->y + uy * pieces1[i];
+            p2.x = origin->x + ux * pieces2[i];
+            p2.y = origin->y + uy * pieces2[i];
+
+            // the front side of a partition is on its right
+            R_AddPVSPortal(pvsclusters[front], pvsclusters[back], p1, p2, -uy, ux);
+            R_AddPVSPortal(pvsclusters[back], pvsclusters[front], p1, p2, uy, -ux);
+        }
+}
+
+static pvspolygon_t *R_PVSRegion(int child)
+{
+    return (regions + (child & NF_SUBSECTOR ? numnodes + (child & ~NF_SUBSECTOR) : child));
+}
+
+// Splits the area a node covers between its children.
+static void R_PartitionPVSRegion(int child, pvspolygon_t polygon)
+{
+    *R_PVSRegion(child) = polygon;
+
+    if (!(child & NF_SUBSECTOR))
+    {
+        const node_t    *node = nodes + child;
+        const double    x = FIXED2DOUBLE(node->x);
+        const double    y = FIXED2DOUBLE(node->y);
+        const double    dx = FIXED2DOUBLE(node->dx);
+        const double    dy = FIXED2DOUBLE(node->dy);
+
+        R_PartitionPVSRegion(node->children[0], R_ClipPVSPolygon(&polygon, x, y, dx, dy));
+        R_PartitionPVSRegion(node->children[1], R_ClipPVSPolygon(&polygon, x, y, -dx, -dy));
+    }
+}
+
+// Returns true if there is a one-sided seg in a subtree along a line.
+static dboolean R_PVSWallAlongLine(int child, double x, double y, double ux, double uy)
+{
+    if (child & NF_SUBSECTOR)
+    {
+        const subsector_t   *subsector = subsectors + (child & ~NF_SUBSECTOR);
+
+        for (int i = 0; i < subsector->numlines; i++)
+        {
+            const seg_t *seg = segs + subsector->firstline + i;
+
+            if (!seg->backsector
+                && fabs((FIXED2DOUBLE(seg->v1->x) - x) * uy - (FIXED2DOUBLE(seg->v1->y) - y) * ux) <= PVSEPSILON
+                && fabs((FIXED2DOUBLE(seg->v2->x) - x) * uy - (FIXED2DOUBLE(seg->v2->y) - y) * ux) <= PVSEPSILON)
+                return true;
+        }
+
+        return false;
+    }
+    else
+        return (R_PVSWallAlongLine(nodes[child].children[0], x, y, ux, uy)
+            || R_PVSWallAlongLine(nodes[child].children[1], x, y, ux, uy));
+}
+
+// A subtree is open if nothing inside the area it covers blocks sight, so it
+// can be treated as a single convex cluster. A subsector is open if none of
+// its segs cut into that area, and a node is open if both its children are,
+// and there are no walls along its partition line.
+static dboolean R_CheckPVSRegion(int child)
+{
+    const pvspolygon_t  *region = R_PVSRegion(child);
+
+    if (!region->numpoints)
+        return false;
+    else if (child & NF_SUBSECTOR)
+    {
+        const subsector_t   *subsector = subsectors + (child & ~NF_SUBSECTOR);
+
+        for (int i = 0; i < subsector->numlines; i++)
+        {
+            const seg_t     *seg = segs + subsector->firstline + i;
+            const double    x = FIXED2DOUBLE(seg->v1->x);
+            const double    y = FIXED2DOUBLE(seg->v1->y);
+            const double    dx = FIXED2DOUBLE(seg->v2->x) - x;
+            const double    dy = FIXED2DOUBLE(seg->v2->y) - y;
+            const double    length = sqrt(dx * dx + dy * dy);
+
+            if (length > PVSEPSILON)
+                for (int j = 0; j < region->numpoints; j++)
+                    if (((region->points[j].x - x) * dy - (region->points[j].y - y) * dx) / length < -PVSCUTEPSILON)
+                        return false;
+        }
+
+        return true;
+    }
+    else
+    {
+        const node_t    *node = nodes + child;
+        const double    dx = FIXED2DOUBLE(node->dx);
+        const double    dy = FIXED2DOUBLE(node->dy);
+        const double    length = sqrt(dx * dx + dy * dy);
+        const dboolean  front = R_CheckPVSRegion(node->children[0]);
+        const dboolean  back = R_CheckPVSRegion(node->children[1]);
+
+        return (front && back && length > 0.0
+            && !R_PVSWallAlongLine(child, FIXED2DOUBLE(node->x), FIXED2DOUBLE(node->y), dx / length, dy / length));
+    }
+}
+
+// Puts every subsector in a subtree into the same cluster if it is open, or
+// each of them into their own cluster otherwise.
+static void R_AssignPVSClusters(int child, int cluster)
+{
+    if (cluster < 0 && R_CheckPVSRegion(child))
+        cluster = numclusters++;
+
+    if (child & NF_SUBSECTOR)
+        pvsclusters[child & ~NF_SUBSECTOR] = (cluster >= 0 ? cluster : numclusters++);
+    else
+    {
+        R_AssignPVSClusters(nodes[child].children[0], cluster);
+        R_AssignPVSClusters(nodes[child].children[1], cluster);
+    }
+}
+
+// Adds portals for the edges between the subsectors on either side of the
+// part of a node's partition line within the area the node covers.
+static void R_AddNodePVSPortals(int nodenum)
+{
+    const node_t        *node = nodes + nodenum;
+    const pvspolygon_t  *front = R_PVSRegion(node->children[0]);
+    const double        x = FIXED2DOUBLE(node->x);
+    const double        y = FIXED2DOUBLE(node->y);
+    const double        dx = FIXED2DOUBLE(node->dx);
+    const double        dy = FIXED2DOUBLE(node->dy);
+    const double        length = sqrt(dx * dx + dy * dy);
+    double              ux, uy;
+    double              t1 = 0.0, t2 = 0.0;
+    dboolean            found = false;
+    pvspoint_t          origin, p1, p2;
+    pvspiece_t          *frontpieces = NULL;
+    pvspiece_t          *backpieces = NULL;
+    int                 numfrontpieces = 0;
+    int                 numbackpieces = 0;
+    int                 maxfrontpieces = 0;
+    int                 maxbackpieces = 0;
+    int                 i = 0;
+    int                 j = 0;
+
+    if (length <= 0.0)
+        return;
+
+    ux = dx / length;
+    uy = dy / length;
+    origin.x = x;
+    origin.y = y;
+
+    // the portal is the part of the partition line within the node's area
+    for (int k = 0; k < front->numpoints; k++)
+        if (fabs((front->points[k].x - x) * uy - (front->points[k].y - y) * ux) <= PVSEPSILON)
+        {
+            const double    t = (front->points[k].x - x) * ux + (front->points[k].y - y) * uy;
+
+            if (!found)
+            {
+                t1 = t2 = t;
+                found = true;
+            }
+            else
+            {
+                t1 = fmin(t1, t);
+                t2 = fmax(t2, t);
+            }
+        }
+
+    if (!found || t2 - t1 <= PVSEPSILON)
+        return;
+
+    p1.x = x + ux * t1;
+    p1.y = y + uy * t1;
+    p2.x = x + ux * t2;
+    p2.y = y + uy * t2;
+
+    R_FilterPVSPortal(node->children[0], p1, p2, uy, -ux, &origin, ux, uy,
+        &frontpieces, &numfrontpieces, &maxfrontpieces);
+    R_FilterPVSPortal(node->children[1], p1, p2, -uy, ux, &origin, ux, uy,
+        &backpieces, &numbackpieces, &maxbackpieces);
+
+    qsort(frontpieces, numfrontpieces, sizeof(*frontpieces), &R_ComparePVSPieces);
+    qsort(backpieces, numbackpieces, sizeof(*backpieces), &R_ComparePVSPieces);
+
+    // add a portal wherever a subsector on one side overlaps one on the other
+    while (i < numfrontpieces && j < numbackpieces)
+    {
+        const double    start = fmax(frontpieces[i].t1, backpieces[j].t1);
+        const double    end = fmin(frontpieces[i].t2, backpieces[j].t2);
+
+        if (end - start > PVSEPSILON)
+            R_AddPVSPortals(frontpieces[i].leaf, backpieces[j].leaf, &origin, ux, uy, start, end);
+
+        if (frontpieces[i].t2 < backpieces[j].t2)
+            i++;
+        else
+            j++;
+    }
+
+    free(frontpieces);
+    free(backpieces);
+}
+
+// A portal might be seen through another if part of the other is beyond it,
+// and part of it is behind the other.
+static dboolean R_PVSPortalMightSee(const pvsportal_t *source, const pvsportal_t *portal)
+{
+    return ((source->nx * portal->p1.x + source->ny * portal->p1.y - source->dist > PVSEPSILON
+        || source->nx * portal->p2.x + source->ny * portal->p2.y - source->dist > PVSEPSILON)
+        && (portal->nx * source->p1.x + portal->ny * source->p1.y - portal->dist < -PVSEPSILON
+        || portal->nx * source->p2.x + portal->ny * source->p2.y - portal->dist < -PVSEPSILON));
+}
+
+// Finds every cluster that might be seen through a portal, by flooding through
+// the portals after it that it might see through.
+static void R_PVSPortalFlood(pvsworker_t *worker, pvsportal_t *source)
+{
+    int sp = 0;
+
+    source->mightsee = calloc(rowwords, sizeof(*source->mightsee));
+    source->mightsee[source->cluster >> 5] |= 1u << (source->cluster & 31);
+    worker->stack[sp++] = source->cluster;
+
+    while (sp)
+    {
+        const int   cluster = worker->stack[--sp];
+
+        for (int i = firstportal[cluster]; i < firstportal[cluster] + portalcounts[cluster]; i++)
+        {
+            const pvsportal_t   *portal = portals + i;
+
+            if (!(source->mightsee[portal->cluster >> 5] & (1u << (portal->cluster & 31)))
+                && R_PVSPortalMightSee(source, portal))
+            {
+                source->mightsee[portal->cluster >> 5] |= 1u << (portal->cluster & 31);
+                source->mightcount++;
+                worker->stack[sp++] = portal->cluster;
+            }
+        }
+    }
+}
+
+static dboolean R_PVSBeyond(const pvspoint_t *p1, const pvspoint_t *p2, const pvsportal_t *portal)
+{
+    return (fabs(portal->nx * p1->x + portal->ny * p1->y - portal->dist) > PVSEPSILON
+        || fabs(portal->nx * p2->x + portal->ny * p2->y - portal->dist) > PVSEPSILON);
+}
+
+// Clips a segment to the region that can be seen from the source window
+// through the pass window, which is bounded by the two lines through an end
+// of each that have the rest of the source and pass windows on opposite sides.
+static dboolean R_ClipPVSWindow(pvspoint_t *p1, pvspoint_t *p2, const pvspoint_t *source, const pvspoint_t *pass)
+{
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+        {
+            const pvspoint_t    *s = source + i;
+            const pvspoint_t    *sother = source + (i ^ 1);
+            const pvspoint_t    *p = pass + j;
+            const pvspoint_t    *pother = pass + (j ^ 1);
+            const double        dx = p->x - s->x;
+            const double        dy = p->y - s->y;
+            const double        length = sqrt(dx * dx + dy * dy);
+            double              nx, ny, ds, dp;
+
+            if (length <= PVSEPSILON)
+                continue;
+
+            nx = -dy / length;
+            ny = dx / length;
+            ds = nx * (sother->x - s->x) + ny * (sother->y - s->y);
+            dp = nx * (pother->x - s->x) + ny * (pother->y - s->y);
+
+            if ((ds > PVSEPSILON && dp > PVSEPSILON) || (ds < -PVSEPSILON && dp < -PVSEPSILON)
+                || (fabs(ds) <= PVSEPSILON && fabs(dp) <= PVSEPSILON))
+                continue;
+
+            // keep the side the rest of the pass window is on
+            if (dp < -PVSEPSILON || (dp <= PVSEPSILON && ds > 0.0))
+            {
+                nx = -nx;
+                ny = -ny;
+            }
+
+            if (!R_ClipPVSSegment(p1, p2, nx, ny, nx * s->x + ny * s->y))
+                return false;
+        }
+
+    return true;
+}
+
+static double R_PVSLength(const pvspoint_t *p)
+{
+    return sqrt((p[1].x - p[0].x) * (p[1].x - p[0].x) + (p[1].y - p[0].y) * (p[1].y - p[0].y));
+}
+
+static double R_PVSPortalFraction(const pvsportal_t *portal, const pvspoint_t *p)
+{
+    const double    dx = portal->p2.x - portal->p1.x;
+    const double    dy = portal->p2.y - portal->p1.y;
+
+    return (((p->x - portal->p1.x) * dx + (p->y - portal->p1.y) * dy) / (dx * dx + dy * dy));
+}
+
+// Returns true if a portal has already been flowed through with windows that
+// contain these ones, since nothing more could then be seen. Otherwise, the
+// windows are remembered.
+static dboolean R_PVSFlowedThrough(pvsworker_t *worker, const pvsportal_t *portal, const pvspoint_t *source,
+    const pvspoint_t *target)
+{
+    const int       i = (int)(portal - portals);
+    pvsmemo_t       *memos = worker->memos + (size_t)i * PVSMAXMEMOS;
+    const double    f1 = R_PVSPortalFraction(worker->source, source);
+    const double    f2 = R_PVSPortalFraction(worker->source, source + 1);
+    const double    f3 = R_PVSPortalFraction(portal, target);
+    const double    f4 = R_PVSPortalFraction(portal, target + 1);
+    const float     s1 = (float)fmin(f1, f2);
+    const float     s2 = (float)fmax(f1, f2);
+    const float     t1 = (float)fmin(f3, f4);
+    const float     t2 = (float)fmax(f3, f4);
+
+    if (worker->memoflows[i] != worker->numflows)
+    {
+        worker->memoflows[i] = worker->numflows;
+        worker->memocounts[i] = 0;
+    }
+
+    for (int j = 0; j < worker->memocounts[i]; j++)
+        if (memos[j].s1 <= s1 && memos[j].s2 >= s2 && memos[j].t1 <= t1 && memos[j].t2 >= t2)
+            return true;
+
+    // replace any windows these ones contain
+    for (int j = 0; j < worker->memocounts[i]; j++)
+        if (memos[j].s1 >= s1 && memos[j].s2 <= s2 && memos[j].t1 >= t1 && memos[j].t2 <= t2)
+        {
+            memos[j].s1 = s1;
+            memos[j].s2 = s2;
+            memos[j].t1 = t1;
+            memos[j].t2 = t2;
+            return false;
+        }
+
+    if (worker->memocounts[i] < PVSMAXMEMOS)
+    {
+        memos[worker->memocounts[i]].s1 = s1;
+        memos[worker->memocounts[i]].s2 = s2;
+        memos[worker->memocounts[i]].t1 = t1;
+        memos[worker->memocounts[i]++].t2 = t2;
+    }
+
+    return false;
+}
+
+static void R_PVSFlow(pvsworker_t *worker, int cluster, const pvspoint_t *source, const pvsportal_t *pass,
+    const pvspoint_t *window, const uint32_t *might, int depth)
+{
+    uint32_t    *newmight = worker->might + (size_t)depth * rowwords;
+
+    worker->vis[cluster >> 5] |= 1u << (cluster & 31);
+
+    if (++worker->flow > PVSMAXFLOW || depth >= PVSMAXDEPTH)
+    {
+        worker->overflow = true;
+        return;
+    }
+
+    for (int i = firstportal[cluster]; i < firstportal[cluster] + portalcounts[cluster] && !worker->overflow; i++)
+    {
+        pvsportal_t         *portal = portals + i;
+        const uint32_t      *portalvis;
+        pvspoint_t          target[2];
+        pvspoint_t          newsource[2];
+        dboolean            more = false;
+
+        if (!(might[portal->cluster >> 5] & (1u << (portal->cluster & 31))))
+            continue;
+
+        // nothing can be seen through a portal that can't be seen from it, so
+        // use what can be seen from it once that is known
+        portalvis = (SDL_AtomicGet(&portal->done) ? portal->vis : portal->mightsee);
+
+        for (int j = 0; j < rowwords; j++)
+        {
+            newmight[j] = worker->source->mightsee[j] & portalvis[j];
+            more |= !!(newmight[j] & ~worker->vis[j]);
+        }
+
+        // skip the portal if nothing new can be seen through it
+        if (!more && (worker->vis[portal->cluster >> 5] & (1u << (portal->cluster & 31))))
+            continue;
+
+        // a portal in line with the last one can only be seen edge on
+        if (!R_PVSBeyond(&portal->p1, &portal->p2, pass))
+            continue;
+
+        target[0] = portal->p1;
+        target[1] = portal->p2;
+        newsource[0] = source[0];
+        newsource[1] = source[1];
+
+        // a window that has shrunk to a point can only be seen through edge on
+        if (window && (!R_ClipPVSWindow(&target[0], &target[1], source, window)
+            || !R_ClipPVSWindow(&newsource[0], &newsource[1], target, window)
+            || R_PVSLength(target) <= PVSEPSILON || R_PVSLength(newsource) <= PVSEPSILON))
+            continue;
+
+        if (R_PVSFlowedThrough(worker, portal, newsource, target))
+            continue;
+
+        R_PVSFlow(worker, portal->cluster, newsource, portal, target, newmight, depth + 1);
+    }
+
+}
+
+static void R_InitPVSWorker(pvsworker_t *worker)
+{
+    worker->vis = malloc(rowwords * sizeof(*worker->vis));
+    worker->might = malloc((size_t)PVSMAXDEPTH * rowwords * sizeof(*worker->might));
+    worker->stack = malloc(numclusters * sizeof(*worker->stack));
+    worker->row = malloc(rowwords * 4 * 2);
+    worker->memos = malloc((size_t)MAX(1, numportals) * PVSMAXMEMOS * sizeof(*worker->memos));
+    worker->memocounts = malloc(MAX(1, numportals) * sizeof(*worker->memocounts));
+    worker->memoflows = calloc(MAX(1, numportals), sizeof(*worker->memoflows));
+    worker->numflows = 0;
+}
+
+static void R_FreePVSWorker(pvsworker_t *worker)
+{
+    free(worker->vis);
+    free(worker->might);
+    free(worker->stack);
+    free(worker->row);
+    free(worker->memos);
+    free(worker->memocounts);
+    free(worker->memoflows);
+}
+
+// Zeros are written as a zero followed by how many there are.
+static void R_CompressPVSRow(pvsworker_t *worker, int cluster)
+{
+    const int   rowbytes = (numclusters + 7) / 8;
+    int         size = 0;
+
+    for (int i = 0; i < rowbytes; i++)
+    {
+        const byte  b = (worker->vis[i >> 2] >> ((i & 3) * 8)) & 0xFF;
+
+        if (b)
+            worker->row[size++] = b;
+        else
+        {
+            int count = 1;
+
+            while (i + count < rowbytes && count < 255
+                && !((worker->vis[(i + count) >> 2] >> (((i + count) & 3) * 8)) & 0xFF))
+                count++;
+
+            worker->row[size++] = 0;
+            worker->row[size++] = count;
+            i += count - 1;
+        }
+    }
+
+    rows[cluster] = malloc(MAX(1, size));
+    memcpy(rows[cluster], worker->row, size);
+    rowsizes[cluster] = size;
+}
+
+static int SDLCALL R_PVSFloodThread(void *data)
+{
+    pvsworker_t worker;
+    int         i;
+
+    R_InitPVSWorker(&worker);
+
+    while ((i = SDL_AtomicAdd(&nextpvsitem, 1)) < numportals)
+        R_PVSPortalFlood(&worker, portals + i);
+
+    R_FreePVSWorker(&worker);
+
+    return 0;
+}
+
+static int SDLCALL R_PVSFlowThread(void *data)
+{
+    pvsworker_t worker;
+    int         i;
+
+    R_InitPVSWorker(&worker);
+
+    while ((i = SDL_AtomicAdd(&nextpvsitem, 1)) < numportals)
+    {
+        pvsportal_t         *portal = portals + portalorder[i];
+        const pvspoint_t    source[2] = { portal->p1, portal->p2 };
+
+        memset(worker.vis, 0, rowwords * sizeof(*worker.vis));
+        worker.flow = 0;
+        worker.overflow = false;
+        worker.source = portal;
+        worker.numflows++;
+        R_PVSFlow(&worker, portal->cluster, source, portal, NULL, portal->mightsee, 0);
+
+        // if it took too long, fall back to everything that might be seen
+        portal->vis = malloc(rowwords * sizeof(*portal->vis));
+        memcpy(portal->vis, (worker.overflow ? portal->mightsee : worker.vis), rowwords * sizeof(*portal->vis));
+        SDL_AtomicSet(&portal->done, true);
+    }
+
+    R_FreePVSWorker(&worker);
+
+    return 0;
+}
+
+static int R_ComparePVSPortals(const void *a, const void *b)
+{
+    return (portals[*(const int *)a].mightcount - portals[*(const int *)b].mightcount);
+}
+
+static void R_RunPVSThreads(SDL_ThreadFunction func, const char *name, int numitems)
+{
+    const int   numthreads = MIN(SDL_GetCPUCount(), numitems) - 1;
+    SDL_Thread  **threads = malloc(MAX(1, numthreads) * sizeof(*threads));
+
+    SDL_AtomicSet(&nextpvsitem, 0);
+
+    for (int i = 0; i < numthreads; i++)
+        threads[i] = SDL_CreateThread(func, name, NULL);
+
+    // work on this thread too, which also ensures everything is done even if
+    // no threads could be created
+    func(NULL);
+
+    for (int i = 0; i < numthreads; i++)
+        if (threads[i])
+            SDL_WaitThread(threads[i], NULL);
+
+    free(threads);
+}
+
+static void R_FreePVSPortals(void)
+{
+    for (int i = 0; i < numportals; i++)
+    {
+        free(portals[i].mightsee);
+        free(portals[i].vis);
+    }
+
+    free(portals);
+    free(portalorder);
+    free(firstportal);
+    free(portalcounts);
+
+    portals = NULL;
+    portalorder = NULL;
+    firstportal = NULL;
+    portalcounts = NULL;
+}
+
+static dboolean R_BuildPVS(void)
+{
+    fixed_t         minx = INT_MAX, miny = INT_MAX;
+    fixed_t         maxx = INT_MIN, maxy = INT_MIN;
+    pvspolygon_t    polygon;
+    pvsportal_t     *sorted;
+    pvsworker_t     worker;
+    int             size = 0;
+
+    for (int i = 0; i < numvertexes; i++)
+    {
+        minx = MIN(minx, vertexes[i].x);
+        miny = MIN(miny, vertexes[i].y);
+        maxx = MAX(maxx, vertexes[i].x);
+        maxy = MAX(maxy, vertexes[i].y);
+    }
+
+    // start with a box around the whole map
+    polygon.points = malloc(4 * sizeof(*polygon.points));
+    polygon.numpoints = 4;
+    polygon.points[0].x = FIXED2DOUBLE(minx) - 64.0;
+    polygon.points[0].y = FIXED2DOUBLE(miny) - 64.0;
+    polygon.points[1].x = FIXED2DOUBLE(minx) - 64.0;
+    polygon.points[1].y = FIXED2DOUBLE(maxy) + 64.0;
+    polygon.points[2].x = FIXED2DOUBLE(maxx) + 64.0;
+    polygon.points[2].y = FIXED2DOUBLE(maxy) + 64.0;
+    polygon.points[3].x = FIXED2DOUBLE(maxx) + 64.0;
+    polygon.points[3].y = FIXED2DOUBLE(miny) - 64.0;
+
+    regions = malloc(((size_t)numnodes + numsubsectors) * sizeof(*regions));
+    R_PartitionPVSRegion(numnodes - 1, polygon);
+
+    pvsclusters = malloc(numsubsectors * sizeof(*pvsclusters));
+    numclusters = 0;
+    R_AssignPVSClusters(numnodes - 1, -1);
+
+    numportals = 0;
+    maxportals = 0;
+
+    for (int i = 0; i < numnodes; i++)
+        R_AddNodePVSPortals(i);
+
+    for (int i = 0; i < numnodes + numsubsectors; i++)
+        free(regions[i].points);
+
+    free(regions);
+
+    rowwords = (numclusters + 31) / 32;
+
+    if ((size_t)numportals * rowwords * sizeof(uint32_t) * 2 > PVSMAXMEMORY)
+    {
+        free(portals);
+        portals = NULL;
+        return false;
+    }
+
+    // sort the portals by the cluster they lead out of
+    firstportal = calloc(numclusters, sizeof(*firstportal));
+    portalcounts = calloc(numclusters, sizeof(*portalcounts));
+    sorted = malloc(MAX(1, numportals) * sizeof(*sorted));
+
+    for (int i = 0; i < numportals; i++)
+        portalcounts[portals[i].from]++;
+
+    for (int i = 1; i < numclusters; i++)
+        firstportal[i] = firstportal[i - 1] + portalcounts[i - 1];
+
+    memset(portalcounts, 0, numclusters * sizeof(*portalcounts));
+
+    for (int i = 0; i < numportals; i++)
+        sorted[firstportal[portals[i].from] + portalcounts[portals[i].from]++] = portals[i];
+
+    free(portals);
+    portals = sorted;
+
+    R_RunPVSThreads(R_PVSFloodThread, "R_PVSFloodThread", numportals);
+
+    // flow through the portals that can see the least first, so that what
+    // they can see is known by the time the others flow through them
+    portalorder = malloc(MAX(1, numportals) * sizeof(*portalorder));
+
+    for (int i = 0; i < numportals; i++)
+        portalorder[i] = i;
+
+    qsort(portalorder, numportals, sizeof(*portalorder), &R_ComparePVSPortals);
+    R_RunPVSThreads(R_PVSFlowThread, "R_PVSFlowThread", numportals);
+
+    // each cluster can see whatever can be seen through its portals
+    rows = malloc(numclusters * sizeof(*rows));
+    rowsizes = malloc(numclusters * sizeof(*rowsizes));
+    R_InitPVSWorker(&worker);
+
+    for (int cluster = 0; cluster < numclusters; cluster++)
+    {
+        memset(worker.vis, 0, rowwords * sizeof(*worker.vis));
+        worker.vis[cluster >> 5] |= 1u << (cluster & 31);
+
+        for (int i = firstportal[cluster]; i < firstportal[cluster] + portalcounts[cluster]; i++)
+            for (int j = 0; j < rowwords; j++)
+                worker.vis[j] |= portals[i].vis[j];
+
+        R_CompressPVSRow(&worker, cluster);
+    }
+
+    R_FreePVSWorker(&worker);
+    R_FreePVSPortals();
+
+    // join the rows together
+    pvsoffsets = malloc((numclusters + 1) * sizeof(*pvsoffsets));
+
+    for (int i = 0; i < numclusters; i++)
+    {
+        pvsoffsets[i] = size;
+        size += rowsizes[i];
+    }
+
+    pvsoffsets[numclusters] = size;
+    pvsdata = malloc(MAX(1, size));
+
+    for (int i = 0; i < numclusters; i++)
+    {
+        memcpy(pvsdata + pvsoffsets[i], rows[i], rowsizes[i]);
+        free(rows[i]);
+    }
+
+    free(rows);
+    free(rowsizes);
+
+    return true;
+}
+
+static char *R_PVSCachePath(const char *cachepath)
+{
+    char    *temp = M_StringDuplicate(cachepath);
+    char    *extension = strrchr(temp, '.');
+    char    *path;
+
+    // replace the level cache's extension
+    if (extension)
+        *extension = '\0';
+
+    path = M_StringJoin(temp, ".pvs", NULL);
+    free(temp);
+
+    return path;
+}
+
+static dboolean R_LoadPVS(const char *path, uint64_t key)
+{
+    pvsheader_t header;
+    FILE        *file;
+
+    if (!(file = fopen(path, "rb")))
+        return false;
+
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.id, PVSID, sizeof(header.id))
+        || header.version != PVSVERSION || header.key != key || header.numsubsectors != numsubsectors
+        || header.numnodes != numnodes || header.numclusters <= 0 || header.numclusters > numsubsectors
+        || header.size < 0)
+    {
+        fclose(file);
+        return false;
+    }
+
+    numclusters = header.numclusters;
+    pvsclusters = malloc(numsubsectors * sizeof(*pvsclusters));
+    pvsoffsets = malloc((numclusters + 1) * sizeof(*pvsoffsets));
+    pvsdata = malloc(MAX(1, header.size));
+
+    if (fread(pvsclusters, sizeof(*pvsclusters), numsubsectors, file) != (size_t)numsubsectors
+        || fread(pvsoffsets, sizeof(*pvsoffsets), (size_t)numclusters + 1, file) != (size_t)numclusters + 1
+        || fread(pvsdata, 1, header.size, file) != (size_t)header.size || fgetc(file) != EOF
+        || pvsoffsets[0] || pvsoffsets[numclusters] != header.size)
+    {
+        fclose(file);
+        R_FreePVS();
+        return false;
+    }
+
+    fclose(file);
+
+    for (int i = 0; i < numsubsectors; i++)
+        if (pvsclusters[i] < 0 || pvsclusters[i] >= numclusters)
+        {
+            R_FreePVS();
+            return false;
+        }
+
+    for (int i = 0; i < numclusters; i++)
+        if (pvsoffsets[i] > pvsoffsets[i + 1])
+        {
+            R_FreePVS();
+            return false;
+        }
+
+    return true;
+}
+
+static void R_SavePVS(const char *path, uint64_t key)
+{
+    pvsheader_t header;
+    FILE        *file;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.id, PVSID, sizeof(header.id));
+    header.version = PVSVERSION;
+    header.key = key;
+    header.numsubsectors = numsubsectors;
+    header.numnodes = numnodes;
+    header.numclusters = numclusters;
+    header.size = pvsoffsets[numclusters];
+
+    if ((file = fopen(path, "wb")))
+    {
+        const dboolean  result = (fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(pvsclusters, sizeof(*pvsclusters), numsubsectors, file) == (size_t)numsubsectors
+            && fwrite(pvsoffsets, sizeof(*pvsoffsets), (size_t)numclusters + 1, file) == (size_t)numclusters + 1
+            && fwrite(pvsdata, 1, header.size, file) == (size_t)header.size);
+
+        fclose(file);
+
+        if (!result)
+            remove(path);
+    }
+}
+
+//
+// R_InitPVS
+// Loads the PVS for the current map from the cache, or builds it.
+//
+void R_InitPVS(const char *cachepath, uint64_t key)
+{
+    char    *path;
+    int     *stack;
+    int     sp = 0;
+    int     count = 0;
+
+    R_FreePVS();
+
+    if (!r_pvs || !numnodes)
+        return;
+
+    path = (cachepath ? R_PVSCachePath(cachepath) : NULL);
+
+    if (!path || !R_LoadPVS(path, key))
+    {
+        if (!R_BuildPVS())
+        {
+            R_FreePVS();
+            free(path);
+            return;
+        }
+
+        if (path)
+            R_SavePVS(path, key);
+    }
+
+    free(path);
+
+    // list the nodes so that children always come before their parents
+    pvsorder = malloc(numnodes * sizeof(*pvsorder));
+    stack = malloc(numnodes * 2 * sizeof(*stack));
+    stack[sp++] = numnodes - 1;
+
+    while (sp)
+    {
+        const int   nodenum = stack[--sp];
+
+        if (nodenum < 0)
+            pvsorder[count++] = ~nodenum;
+        else
+        {
+            stack[sp++] = ~nodenum;
+
+            for (int i = 0; i < 2; i++)
+                if (!(nodes[nodenum].children[i] & NF_SUBSECTOR))
+                    stack[sp++] = nodes[nodenum].children[i];
+        }
+    }
+
+    free(stack);
+    numpvsorder = count;
+
+    pvsrow = malloc((numclusters + 7) / 8);
+    pvsnodes = malloc((numnodes + 7) / 8);
+    pvscluster = -1;
+}
+
+void R_FreePVS(void)
+{
+    free(pvsclusters);
+    free(pvsdata);
+    free(pvsoffsets);
+    free(pvsorder);
+    free(pvsrow);
+    free(pvsnodes);
+
+    pvsclusters = NULL;
+    pvsdata = NULL;
+    pvsoffsets = NULL;
+    pvsorder = NULL;
+    pvsrow = NULL;
+    pvsnodes = NULL;
+    pvsactive = false;
+}
+
+//
+// R_SetupPVS
+// Decompresses the PVS of the cluster the view is in, and marks each node
+// with anything in it that might be seen.
+//
+void R_SetupPVS(void)
+{
+    int cluster;
+
+    if (!pvsdata || !r_pvs || (viewplayer->cheats & CF_NOCLIP))
+    {
+        pvsactive = false;
+        return;
+    }
+
+    if ((cluster = pvsclusters[R_PointInSubsector(viewx, viewy) - subsectors]) != pvscluster)
+    {
+        const byte  *in = pvsdata + pvsoffsets[cluster];
+        const byte  *end = pvsdata + pvsoffsets[cluster + 1];
+        byte        *out = pvsrow;
+        byte        *outend = pvsrow + (numclusters + 7) / 8;
+
+        while (in < end && out < outend)
+            if (*in)
+                *out++ = *in++;
+            else if (in + 1 < end)
+            {
+                const int   count = MIN(in[1], (int)(outend - out));
+
+                memset(out, 0, count);
+                out += count;
+                in += 2;
+            }
+            else
+                break;
+
+        // anything missing from a row is assumed to be visible
+        if (out < outend)
+            memset(out, 0xFF, outend - out);
+
+        memset(pvsnodes, 0, (numnodes + 7) / 8);
+        pvsactive = true;
+
+        for (int i = 0; i < numpvsorder; i++)
+        {
+            const int   nodenum = pvsorder[i];
+
+            if (R_InPVS(nodes[nodenum].children[0]) || R_InPVS(nodes[nodenum].children[1]))
+                pvsnodes[nodenum >> 3] |= 1 << (nodenum & 7);
+        }
+
+        pvscluster = cluster;
+    }
+
+    pvsactive = true;
+}
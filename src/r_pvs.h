@@ -0,0 +1,72 @@
+/*
+========================================================================
+
+                           D O O M  R e t r o
+         The classic, refined DOOM source port. For Windows PC.
+
+========================================================================
+
+  Copyright © 1993-2012 by id Software LLC, a ZeniMax Media company.
+  Copyright © 2013-2020 by Brad Harding.
+
+  DOOM Retro is a fork of Chocolate DOOM. For a list of credits, see
+  <https://github.com/bradharding/doomretro/wiki/CREDITS>.
+
+  This file is a part of DOOM Retro.
+
+  DOOM Retro is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  DOOM Retro is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with DOOM Retro. If not, see <https://www.gnu.org/licenses/>.
+
+  DOOM is a registered trademark of id Software LLC, a ZeniMax Media
+  company, in the US and/or other countries, and is used without
+  permission. All other trademarks are the property of their respective
+  holders. DOOM Retro is in no way affiliated with nor endorsed by
+  id Software.
+
+========================================================================
+*/
+
+#if !defined(__R_PVS_H__)
+#define __R_PVS_H__
+
+#include "doomdata.h"
+
+extern int      *pvsclusters;
+extern byte     *pvsrow;
+extern byte     *pvsnodes;
+extern dboolean pvsactive;
+
+void R_InitPVS(const char *cachepath, uint64_t key);
+void R_FreePVS(void);
+void R_SetupPVS(void);
+
+//
+// R_InPVS
+// Returns true if the given node or subsector contains anything that might be
+// visible from the subsector the view is in.
+//
+static inline dboolean R_InPVS(int child)
+{
+    if (!pvsactive)
+        return true;
+    else if (child & NF_SUBSECTOR)
+    {
+        const int   cluster = pvsclusters[child & ~NF_SUBSECTOR];
+
+        return !!(pvsrow[cluster >> 3] & (1 << (cluster & 7)));
+    }
+    else
+        return !!(pvsnodes[child >> 3] & (1 << (child & 7)));
+}
+
+#endif
@@ -38,6 +38,7 @@
 
 #include <string.h>
 
+#include "am_map.h"
 #include "doomstat.h"
 #include "i_system.h"
 #include "m_config.h"
@@ -521,7 +522,11 @@ void R_StoreWallRange(const int start, const int stop)
     linedef = curline->linedef;
 
     // mark the segment as visible for automap
-    linedef->flags |= ML_MAPPED;
+    if (!(linedef->flags & ML_MAPPED))
+    {
+        linedef->flags |= ML_MAPPED;
+        mapwindowchanged = true;
+    }
 
     // [BH] if in automap, we're done now that line is mapped
     if (automapactive)
@@ -650,7 +655,7 @@ void R_StoreWallRange(const int start, const int stop)
 
             midtexture = texturetranslation[sidedef->midtexture];
             height = textureheight[midtexture];
-            midtexheight = ((linedef->r_flags & RF_MID_TILE) ? 0 : (height >> FRACBITS));
+            midtexheight = ((renderline->flags & RF_MID_TILE) ? 0 : (height >> FRACBITS));
             midbrightmap = (usebrightmaps && !nobrightmap[midtexture] ? brightmap[midtexture] : NULL);
             rw_midtexturemid = ((linedef->flags & ML_DONTPEGBOTTOM) ? frontsector->interpfloorheight + height - viewz : worldtop)
                 + FixedMod(sidedef->rowoffset, height);
@@ -669,7 +674,7 @@ void R_StoreWallRange(const int start, const int stop)
         int liquidoffset = 0;
 
         // two sided line
-        if (linedef->r_flags & RF_CLOSED)
+        if (renderline->flags & RF_CLOSED)
         {
             ds_p->sprtopclip = viewheightarray;
             ds_p->sprbottomclip = negonearray;
@@ -754,7 +759,7 @@ void R_StoreWallRange(const int start, const int stop)
 
                 toptexture = texturetranslation[sidedef->toptexture];
                 height = textureheight[toptexture];
-                toptexheight = ((linedef->r_flags & RF_TOP_TILE) ? 0 : (height >> FRACBITS));
+                toptexheight = ((renderline->flags & RF_TOP_TILE) ? 0 : (height >> FRACBITS));
                 topbrightmap = (usebrightmaps && !nobrightmap[toptexture] ? brightmap[toptexture] : NULL);
                 rw_toptexturemid = ((linedef->flags & ML_DONTPEGTOP) ? worldtop : backsector->interpceilingheight + height - viewz)
                     + FixedMod(sidedef->rowoffset, height);
@@ -772,7 +777,7 @@ void R_StoreWallRange(const int start, const int stop)
 
                 bottomtexture = texturetranslation[sidedef->bottomtexture];
                 height = textureheight[bottomtexture];
-                bottomtexheight = ((linedef->r_flags & RF_BOT_TILE) ? 0 : (height >> FRACBITS));
+                bottomtexheight = ((renderline->flags & RF_BOT_TILE) ? 0 : (height >> FRACBITS));
                 bottombrightmap = (usebrightmaps && !nobrightmap[bottomtexture] ? brightmap[bottomtexture] : NULL);
                 rw_bottomtexturemid = ((linedef->flags & ML_DONTPEGBOTTOM) ? worldtop : worldlow - liquidoffset)
                     + FixedMod(sidedef->rowoffset, height);
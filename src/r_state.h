@@ -115,7 +115,9 @@ typedef enum
 {
     DOOMBSP,
     DEEPBSP,
-    ZDBSPX
+    ZDBSPX,
+    ZDBSPZ,
+    REBUILTBSP
 } mapformat_t;
 
 extern mapformat_t  mapformat;
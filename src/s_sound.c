@@ -40,6 +40,7 @@
 
 #include "c_console.h"
 #include "doomstat.h"
+#include "i_timer.h"
 #include "m_argv.h"
 #include "m_config.h"
 #include "m_misc.h"
@@ -82,6 +83,10 @@ typedef struct
 
     // handle of the sound being played
     int             handle;
+
+    // volume and separation last given to the mixer
+    int             volume;
+    int             sep;
 } channel_t;
 
 // [crispy] "sound objects" hold the coordinates of removed map objects
@@ -115,6 +120,11 @@ static int          snd_SfxVolume;
 // Whether songs are mus_paused
 static dboolean     mus_paused;
 
+// Whether the music playing is still being loaded
+static dboolean     mus_loading;
+static dboolean     mus_looping;
+static char         mus_loadingname[9];
+
 // Music currently being played
 musicinfo_t         *mus_playing;
 
@@ -498,7 +508,11 @@ static void S_StartSoundAtVolume(mobj_t *origin, int sfx_id, int pitch)
     // Assigns the handle to one of the channels in the mix/output buffer.
     // e6y: [Fix] Crash with zero-length sounds.
     if ((handle = I_StartSound(sfx, cnum, volume, sep, pitch)) != -1)
+    {
         channels[cnum].handle = handle;
+        channels[cnum].volume = volume;
+        channels[cnum].sep = sep;
+    }
 }
 
 void S_StartSound(mobj_t *mobj, int sfx_id)
@@ -553,13 +567,21 @@ void S_ResumeMusic(void)
 }
 
 //
-// Updates sounds
+// S_UpdateSounds
+// Updates sounds. Positional sounds are only updated once per tic, rather
+// than every frame, and the mixer is only told about channels whose
+// parameters have changed.
 //
 void S_UpdateSounds(void)
 {
-    if (nosfx)
+    static int  soundtic = -1;
+    const int   tic = I_GetTime();
+
+    if (nosfx || tic == soundtic)
         return;
 
+    soundtic = tic;
+
     for (int cnum = 0; cnum < s_channels; cnum++)
     {
         channel_t   *c = &channels[cnum];
@@ -581,8 +603,12 @@ void S_UpdateSounds(void)
 
                 if (!S_AdjustSoundParms(origin, &volume, &sep))
                     S_StopChannel(cnum);
-                else
+                else if (volume != c->volume || sep != c->sep)
+                {
+                    c->volume = volume;
+                    c->sep = sep;
                     I_UpdateSoundParms(c->handle, volume, sep);
+                }
             }
         }
         else
@@ -620,7 +646,6 @@ void S_ChangeMusic(int music_id, dboolean looping, dboolean allowrestart, dboole
 {
     musicinfo_t *music = &S_music[music_id];
     char        namebuf[9];
-    void        *handle;
     int         mapinfomusic;
 
     // current music which should play
@@ -656,18 +681,50 @@ void S_ChangeMusic(int music_id, dboolean looping, dboolean allowrestart, dboole
         return;
     }
 
-    // Load & register it
+    // Load & register it in the background. S_UpdateMusic() will play it once
+    // it has loaded.
     music->data = W_CacheLumpNum(music->lumpnum);
+    music->handle = NULL;
+    I_RegisterSongAsync(music->data, W_LumpLength(music->lumpnum));
+
+    M_StringCopy(mus_loadingname, namebuf, sizeof(mus_loadingname));
+    mus_loading = true;
+    mus_looping = looping;
+
+    mus_playing = music;
+
+    // [crispy] musinfo.items[0] is reserved for the map's default music
+    if (!musinfo.items[0])
+    {
+        musinfo.items[0] = music->lumpnum;
+        S_music[mus_musinfo].lumpnum = -1;
+    }
+}
 
-    if (!(handle = I_RegisterSong(music->data, W_LumpLength(music->lumpnum))))
+//
+// S_UpdateMusic
+// Play the current music once it has been loaded in the background.
+//
+void S_UpdateMusic(void)
+{
+    void    *handle;
+
+    if (!mus_loading || !I_SongLoaded(&handle))
+        return;
+
+    mus_loading = false;
+
+    // if the lump couldn't be loaded from memory, try again from a temporary
+    // file (music loaded using MUSINFO isn't retried)
+    if (!handle && *mus_loadingname)
 #if defined(_WIN32)
         if (!serverMidiPlaying)
 #endif
         {
-            char    *filename = M_StringJoin(namebuf, ".mp3", NULL);
+            char    *filename = M_StringJoin(mus_loadingname, ".mp3", NULL);
             char    *path = M_TempFile(filename);
 
-            if (W_WriteFile(path, music->data, W_LumpLength(music->lumpnum)))
+            if (W_WriteFile(path, mus_playing->data, W_LumpLength(mus_playing->lumpnum)))
                 handle = Mix_LoadMUS(path);
 
             free(filename);
@@ -675,27 +732,24 @@ void S_ChangeMusic(int music_id, dboolean looping, dboolean allowrestart, dboole
 
             if (!handle)
             {
-                char    *temp = uppercase(namebuf);
+                char    *temp = uppercase(mus_loadingname);
 
                 C_Warning(1, "The <b>%s</b> music lump can't be played.", temp);
                 free(temp);
+                W_ReleaseLumpNum(mus_playing->lumpnum);
+                mus_playing->data = NULL;
+                mus_playing = NULL;
                 return;
             }
         }
 
-    music->handle = handle;
+    mus_playing->handle = handle;
 
     // Play it
-    I_PlaySong(handle, looping);
-
-    mus_playing = music;
+    I_PlaySong(handle, mus_looping);
 
-    // [crispy] musinfo.items[0] is reserved for the map's default music
-    if (!musinfo.items[0])
-    {
-        musinfo.items[0] = music->lumpnum;
-        S_music[mus_musinfo].lumpnum = -1;
-    }
+    if (mus_paused)
+        I_PauseSong();
 }
 
 void S_StopMusic(void)
@@ -703,6 +757,12 @@ void S_StopMusic(void)
     if (!mus_playing)
         return;
 
+    if (mus_loading)
+    {
+        I_CancelSong();
+        mus_loading = false;
+    }
+
     if (mus_paused)
         I_ResumeSong();
 
@@ -736,10 +796,12 @@ void S_ChangeMusInfoMusic(int lumpnum, int looping)
 
     // load & register it
     music->data = W_CacheLumpNum(music->lumpnum);
-    music->handle = I_RegisterSong(music->data, W_LumpLength(music->lumpnum));
+    music->handle = NULL;
+    I_RegisterSongAsync(music->data, W_LumpLength(music->lumpnum));
 
-    // play it
-    I_PlaySong(music->handle, looping);
+    *mus_loadingname = '\0';
+    mus_loading = true;
+    mus_looping = looping;
 
     mus_playing = music;
 
@@ -69,7 +69,9 @@ void I_ShutdownMusic(void);
 void I_SetMusicVolume(int volume);
 void I_PauseSong(void);
 void I_ResumeSong(void);
-void *I_RegisterSong(void *data, int size);
+void I_RegisterSongAsync(void *data, int size);
+dboolean I_SongLoaded(void **handle);
+void I_CancelSong(void);
 void I_UnRegisterSong(void *handle);
 void I_PlaySong(void *handle, dboolean looping);
 void I_StopSong(void);
@@ -120,6 +122,7 @@ void S_ResumeMusic(void);
 // Updates music & sounds
 //
 void S_UpdateSounds(void);
+void S_UpdateMusic(void);
 
 void S_SetMusicVolume(int volume);
 void S_LowerMusicVolume(void);
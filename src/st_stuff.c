@@ -1336,6 +1336,71 @@ static void ST_DiffDraw(void)
     ST_DrawWidgets(false);
 }
 
+// Everything that can change what is drawn on the status bar
+typedef struct
+{
+    int         ready;
+    int         health;
+    int         armor;
+    int         ammo[NUMAMMO];
+    int         maxammo[NUMAMMO];
+    int         weaponowned[NUMWEAPONS];
+    int         face;
+    int         keyboxes[3];
+    int         facebackcolor;
+    int         detail;
+    int         screenwidth;
+    dboolean    widescreen;
+    dboolean    smallnums;
+} ststate_t;
+
+static ststate_t    ststate;
+static dboolean     ststatechanged = true;
+
+//
+// ST_StatusBarChanged
+//  The status bar is drawn again only if something shown on it may have
+//  changed since it was last drawn. Otherwise the copy of it kept in
+//  screens[4] is put back instead.
+//
+static dboolean ST_StatusBarChanged(void)
+{
+    ststate_t   state;
+
+    memset(&state, 0, sizeof(state));
+    state.ready = *w_ready.num;
+    state.health = *w_health.n.num;
+    state.armor = *w_armor.n.num;
+
+    for (int i = 0; i < NUMAMMO; i++)
+    {
+        state.ammo[i] = *w_ammo[i].num;
+        state.maxammo[i] = *w_maxammo[i].num;
+    }
+
+    for (int i = 0; i < NUMWEAPONS; i++)
+        state.weaponowned[i] = viewplayer->weaponowned[i];
+
+    state.face = st_faceindex;
+
+    for (int i = 0; i < 3; i++)
+        state.keyboxes[i] = keyboxes[i];
+
+    state.facebackcolor = facebackcolor;
+    state.detail = r_detail;
+    state.screenwidth = SCREENWIDTH;
+    state.widescreen = vid_widescreen;
+    state.smallnums = usesmallnums;
+
+    if (!ststatechanged && !memcmp(&state, &ststate, sizeof(state)))
+        return false;
+
+    ststate = state;
+    ststatechanged = false;
+
+    return true;
+}
+
 void ST_Drawer(dboolean fullscreen, dboolean refresh)
 {
     // Do red-/gold-shifts from damage/items
@@ -1347,6 +1412,22 @@ void ST_Drawer(dboolean fullscreen, dboolean refresh)
     st_statusbaron = (!fullscreen || automapactive);
     st_firsttime = (st_firsttime || refresh);
 
+    if (st_statusbaron)
+    {
+        byte            *statusbar = &screens[0][(SCREENHEIGHT - SBARHEIGHT) * SCREENWIDTH];
+        const size_t    size = (size_t)SCREENWIDTH * SBARHEIGHT;
+
+        if (ST_StatusBarChanged())
+        {
+            ST_DoRefresh();
+            memcpy(screens[4], statusbar, size);
+        }
+        else
+            memcpy(statusbar, screens[4], size);
+
+        return;
+    }
+
     // If just after ST_Start(), refresh all
     if (st_firsttime)
         ST_DoRefresh();
@@ -1476,6 +1557,7 @@ static void ST_InitData(void)
 {
     st_firsttime = true;
     st_statusbaron = true;
+    ststatechanged = true;
     st_faceindex = 0;
     st_palette = -1;
     st_oldhealth = -1;
@@ -1545,7 +1627,7 @@ void ST_Init(void)
 {
     ST_LoadUnloadGraphics(&ST_LoadCallback);
 
-    screens[4] = malloc((size_t)ST_WIDTH * SBARHEIGHT);
+    screens[4] = malloc((size_t)MAXWIDTH * SBARHEIGHT);
 
     // [BH] fix evil grin being displayed when picking up first item after
     // loading save game or entering IDFA/IDKFA cheat
@@ -36,6 +36,7 @@
 ========================================================================
 */
 
+#include <stdint.h>
 #include <string.h>
 
 #include "SDL_image.h"
@@ -56,8 +57,10 @@
 #include "p_setup.h"
 #include "r_draw.h"
 #include "r_main.h"
+#include "v_video.h"
 #include "version.h"
 #include "w_wad.h"
+#include "z_zone.h"
 
 #define WHITE       4
 #define LIGHTGRAY   82
@@ -166,42 +169,371 @@ void V_FillSoftTransRect(int scrn, int x, int y, int width, int height, int colo
 }
 
 //
-// V_DrawPatch
-// Masks a column based masked pic to the screen.
+// V_HashPatch
+//  Returns a hash of everything in a patch, from its header to the end of the
+//  last post of any of its columns. Patches live in purgeable zone memory, so
+//  once zonefrees shows a block has been freed since, this is how anything
+//  compiled from one can tell if it has been replaced by something else at
+//  the same address.
 //
-void V_DrawPatch(int x, int y, int scrn, patch_t *patch)
+static uint64_t V_HashPatch(const patch_t *patch)
 {
-    byte        *desttop;
-    const int   w = SHORT(patch->width) << FRACBITS;
+    const byte  *data = (const byte *)patch;
+    const int   width = SHORT(patch->width);
+    size_t      size = 8 + (size_t)width * 4;
+    uint64_t    hash = HASHSEED;
 
-    y -= SHORT(patch->topoffset);
-    x -= SHORT(patch->leftoffset);
-    x += WIDESCREENDELTA;   // [crispy] horizontal widescreen offset
+    for (int col = 0; col < width; col++)
+    {
+        const byte  *column = data + LONG(patch->columnofs[col]);
 
-    desttop = &screens[scrn][((y * DY) >> FRACBITS) * SCREENWIDTH + ((x * DX) >> FRACBITS)];
+        while (*column != 0xFF)
+            column += column[1] + 4;
 
-    for (int col = 0; col < w; col += DXI, desttop++)
+        if ((size_t)(column + 1 - data) > size)
+            size = column + 1 - data;
+    }
+
+    // hash 8 bytes at a time, and then whatever is left over
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), data += sizeof(uint64_t))
     {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col >> FRACBITS]));
+        uint64_t    word;
+
+        memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ULL;
+        hash ^= hash >> 32;
+    }
+
+    return M_Hash(data, size, hash);
+}
+
+//
+// Compiled patches
+//  Patches drawn by the HUD, status bar, menu and intermission screens are
+//  compiled once into rows of opaque spans, scaled and with their offsets
+//  into the screen already worked out, and then drawn by V_BlitPatch.
+//
+#define PATCHCACHESIZE      512
+#define MAXCOMPILEDPATCHES  (PATCHCACHESIZE * 4)
+
+typedef enum
+{
+    blendsolid,             // *dest = src
+    blendtinttab,           // *dest = table[(src << 8) + *dest]
+    blendreversetinttab,    // *dest = table[(*dest << 8) + src]
+    blendshadow             // *dest = table[*dest]
+} patchblend_t;
+
+typedef struct
+{
+    int                     row;
+    int                     offset;
+    int                     length;
+    const byte              *pixels;
+} patchspan_t;
+
+typedef struct compiledpatch_s
+{
+    const patch_t           *patch;
+    dboolean                scaled;
+    uint64_t                hash;
+    unsigned int            zonefrees;
+    int                     height;
+    int                     numspans;
+    patchspan_t             *spans;
+    struct compiledpatch_s  *next;
+} compiledpatch_t;
+
+static compiledpatch_t  *patchcache[PATCHCACHESIZE];
+static int              patchcachewidth;
+static int              numcompiledpatches;
+
+static void V_FreeCompiledPatches(void)
+{
+    for (int i = 0; i < PATCHCACHESIZE; i++)
+    {
+        compiledpatch_t *cp = patchcache[i];
+
+        while (cp)
+        {
+            compiledpatch_t *next = cp->next;
+
+            free(cp);
+            cp = next;
+        }
+
+        patchcache[i] = NULL;
+    }
+
+    numcompiledpatches = 0;
+}
+
+//
+// V_CompilePatch
+//  Rasterizes a patch into a temporary buffer exactly as the column drawers
+//  would, either scaled to the screen or at 1:1, and then run-length encodes
+//  each row of that buffer into spans of opaque pixels.
+//
+static compiledpatch_t *V_CompilePatch(const patch_t *patch, const dboolean scaled)
+{
+    const int       w = SHORT(patch->width) << FRACBITS;
+    const int       dx = (scaled ? DXI : FRACUNIT);
+    const int       dy = (scaled ? DY : FRACUNIT);
+    const int       dyi = (scaled ? DYI : FRACUNIT);
+    int             width = 0;
+    int             height = 0;
+    int             numspans = 0;
+    int             numpixels = 0;
+    byte            *buffer;
+    byte            *mask;
+    byte            *pixels;
+    compiledpatch_t *cp;
+
+    for (int col = 0; col < w; col += dx, width++)
+    {
+        const column_t  *column = (const column_t *)((const byte *)patch + LONG(patch->columnofs[col >> FRACBITS]));
 
-        // step through the posts in a column
         while (column->topdelta != 0xFF)
         {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[((column->topdelta * DY) >> FRACBITS) * SCREENWIDTH];
-            int     count = (column->length * DY) >> FRACBITS;
-            int     srccol = 0;
+            height = MAX(height, ((column->topdelta * dy) >> FRACBITS) + ((column->length * dy) >> FRACBITS));
+            column = (const column_t *)((const byte *)column + column->length + 4);
+        }
+    }
+
+    buffer = malloc((size_t)MAX(1, width * height));
+    mask = calloc(MAX(1, width * height), 1);
+
+    for (int col = 0, x = 0; col < w; col += dx, x++)
+    {
+        const column_t  *column = (const column_t *)((const byte *)patch + LONG(patch->columnofs[col >> FRACBITS]));
+
+        while (column->topdelta != 0xFF)
+        {
+            const byte  *source = (const byte *)column + 3;
+            int         row = (column->topdelta * dy) >> FRACBITS;
+            int         count = (column->length * dy) >> FRACBITS;
+            int         srccol = 0;
 
             while (count--)
             {
-                *dest = source[srccol >> FRACBITS];
-                dest += SCREENWIDTH;
-                srccol += DYI;
+                buffer[row * width + x] = source[srccol >> FRACBITS];
+                mask[row++ * width + x] = 1;
+                srccol += dyi;
             }
 
-            column = (column_t *)((byte *)column + column->length + 4);
+            column = (const column_t *)((const byte *)column + column->length + 4);
+        }
+    }
+
+    for (int row = 0; row < height; row++)
+        for (int x = 0; x < width; x++)
+            if (mask[row * width + x])
+            {
+                numpixels++;
+
+                if (!x || !mask[row * width + x - 1])
+                    numspans++;
+            }
+
+    cp = malloc(sizeof(*cp) + numspans * sizeof(patchspan_t) + numpixels);
+    cp->patch = patch;
+    cp->scaled = scaled;
+    cp->hash = V_HashPatch(patch);
+    cp->zonefrees = zonefrees;
+    cp->height = height;
+    cp->numspans = 0;
+    cp->spans = (patchspan_t *)(cp + 1);
+    cp->next = NULL;
+    pixels = (byte *)(cp->spans + numspans);
+
+    for (int row = 0; row < height; row++)
+    {
+        int x = 0;
+
+        while (x < width)
+        {
+            patchspan_t *span;
+
+            if (!mask[row * width + x])
+            {
+                x++;
+                continue;
+            }
+
+            span = &cp->spans[cp->numspans++];
+            span->row = row;
+            span->offset = row * SCREENWIDTH + x;
+            span->pixels = pixels;
+
+            while (x < width && mask[row * width + x])
+                *pixels++ = buffer[row * width + x++];
+
+            span->length = (int)(pixels - span->pixels);
         }
     }
+
+    free(buffer);
+    free(mask);
+
+    return cp;
+}
+
+//
+// V_GetCompiledPatch
+//  Returns the compiled form of a patch, compiling it the first time it is
+//  drawn. If any zone blocks have been freed since a cached entry was last
+//  checked, it is only used if the patch at that address still hashes the
+//  same, and is replaced otherwise. The whole cache is emptied if the screen
+//  width changes, or if it fills up with patches since purged.
+//
+static const compiledpatch_t *V_GetCompiledPatch(const patch_t *patch, const dboolean scaled)
+{
+    const int       bucket = (int)((((uintptr_t)patch >> 3) ^ scaled) & (PATCHCACHESIZE - 1));
+    compiledpatch_t **link = &patchcache[bucket];
+    compiledpatch_t *cp;
+
+    if (patchcachewidth != SCREENWIDTH || numcompiledpatches >= MAXCOMPILEDPATCHES)
+    {
+        V_FreeCompiledPatches();
+        patchcachewidth = SCREENWIDTH;
+    }
+
+    for (cp = *link; cp; link = &cp->next, cp = cp->next)
+        if (cp->patch == patch && cp->scaled == scaled)
+        {
+            if (cp->zonefrees == zonefrees)
+                return cp;
+
+            if (cp->hash == V_HashPatch(patch))
+            {
+                cp->zonefrees = zonefrees;
+                return cp;
+            }
+
+            *link = cp->next;
+            free(cp);
+            numcompiledpatches--;
+            break;
+        }
+
+    cp = V_CompilePatch(patch, scaled);
+    cp->next = patchcache[bucket];
+    patchcache[bucket] = cp;
+    numcompiledpatches++;
+
+    return cp;
+}
+
+//
+// V_BlitPatch
+//  Draws a compiled patch with its top-left corner at (x, y) in screen pixels.
+//  The source pixels are first passed through translate, if there is one.
+//  Pixels of the key color, if there is one, instead apply keytable to what
+//  is already on the screen, or are skipped if there is no keytable.
+//
+static void V_BlitPatch(const compiledpatch_t *cp, byte *screen, const int x, const int y, const patchblend_t blend,
+    const byte *table, const byte *translate, const int key, const byte *keytable)
+{
+    const int       top = y * SCREENWIDTH + x;
+    const dboolean  clip = (y < 0 || y + cp->height > SCREENHEIGHT);
+    const dboolean  simple = (!translate && key < 0);
+
+    for (int i = 0; i < cp->numspans; i++)
+    {
+        const patchspan_t   *span = &cp->spans[i];
+        const byte          *source = span->pixels;
+        byte                *dest;
+        int                 count = span->length;
+
+        if (clip && (y + span->row < 0 || y + span->row >= SCREENHEIGHT))
+            continue;
+
+        dest = &screen[top + span->offset];
+
+        if (simple)
+            switch (blend)
+            {
+                case blendsolid:
+                    memcpy(dest, source, count);
+                    break;
+
+                case blendtinttab:
+                    while (count--)
+                    {
+                        *dest = table[(*source++ << 8) + *dest];
+                        dest++;
+                    }
+
+                    break;
+
+                case blendreversetinttab:
+                    while (count--)
+                    {
+                        *dest = table[(*dest << 8) + *source++];
+                        dest++;
+                    }
+
+                    break;
+
+                case blendshadow:
+                    while (count--)
+                    {
+                        *dest = table[*dest];
+                        dest++;
+                    }
+
+                    break;
+            }
+        else
+            for (; count--; dest++)
+            {
+                byte    dot = *source++;
+
+                if (dot == key)
+                {
+                    if (keytable)
+                        *dest = keytable[*dest];
+
+                    continue;
+                }
+
+                if (translate)
+                    dot = translate[dot];
+
+                switch (blend)
+                {
+                    case blendsolid:
+                        *dest = dot;
+                        break;
+
+                    case blendtinttab:
+                        *dest = table[(dot << 8) + *dest];
+                        break;
+
+                    case blendreversetinttab:
+                        *dest = table[(*dest << 8) + dot];
+                        break;
+
+                    case blendshadow:
+                        *dest = table[*dest];
+                        break;
+                }
+            }
+    }
+}
+
+//
+// V_DrawPatch
+// Masks a column based masked pic to the screen.
+//
+void V_DrawPatch(int x, int y, int scrn, patch_t *patch)
+{
+    y -= SHORT(patch->topoffset);
+    x -= SHORT(patch->leftoffset);
+    x += WIDESCREENDELTA;   // [crispy] horizontal widescreen offset
+
+    V_BlitPatch(V_GetCompiledPatch(patch, true), screens[scrn], (x * DX) >> FRACBITS, (y * DY) >> FRACBITS,
+        blendsolid, NULL, NULL, -1, NULL);
 }
 
 void V_DrawWidePatch(int x, int y, int scrn, patch_t *patch)
@@ -498,84 +830,241 @@ void V_DrawBigPatch(int x, int y, patch_t *patch)
     }
 }
 
-void V_DrawConsoleInputTextPatch(int x, int y, patch_t *patch, int width, int color,
-    int backgroundcolor, dboolean italics, byte *translucency)
+//
+// Glyph atlas
+//  The console and alt HUD fonts are rasterized into one atlas the first
+//  time each glyph is drawn. Each cell of a glyph records whether it is
+//  outside the glyph's posts, a transparent pixel within them, an opaque
+//  pixel or the white "ink" of the font, which is all the text drawers need
+//  to know about it.
+//
+#define GLYPHATLASSIZE  1024
+#define GLYPHBATCHSIZE  256
+
+enum
+{
+    GLYPH_NONE,
+    GLYPH_CLEAR,
+    GLYPH_SOLID,
+    GLYPH_INK
+};
+
+typedef struct
 {
-    byte    *desttop = &screens[0][y * SCREENWIDTH + x];
+    const patch_t   *patch;
+    uint64_t        hash;
+    unsigned int    zonefrees;
+    int             width;
+    int             height;
+    int             offset;
+} atlasglyph_t;
+
+static atlasglyph_t glyphs[GLYPHATLASSIZE];
+static int          numglyphs;
+static byte         *glyphatlas;
+static int          glyphatlassize;
+static int          glyphatlasmax;
+static int          glyphatlasgeneration;
+
+static void V_AddGlyph(atlasglyph_t *glyph, const patch_t *patch)
+{
+    const int   width = SHORT(patch->width);
+    int         height = 0;
+    byte        *cells;
 
-    for (int col = 0; col < width; col++, desttop++)
+    for (int col = 0; col < width; col++)
     {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-        byte        topdelta;
+        const column_t  *column = (const column_t *)((const byte *)patch + LONG(patch->columnofs[col]));
 
-        // step through the posts in a column
-        while ((topdelta = column->topdelta) != 0xFF)
+        while (column->topdelta != 0xFF)
         {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[topdelta * SCREENWIDTH];
+            height = MAX(height, column->topdelta + column->length);
+            column = (const column_t *)((const byte *)column + column->length + 4);
+        }
+    }
 
-            for (int i = 0; i < CONSOLELINEHEIGHT; i++)
+    while (glyphatlassize + width * height > glyphatlasmax)
+    {
+        glyphatlasmax = (glyphatlasmax ? glyphatlasmax * 2 : 65536);
+        glyphatlas = I_Realloc(glyphatlas, glyphatlasmax);
+    }
+
+    cells = &glyphatlas[glyphatlassize];
+    memset(cells, GLYPH_NONE, (size_t)width * height);
+
+    for (int col = 0; col < width; col++)
+    {
+        const column_t  *column = (const column_t *)((const byte *)patch + LONG(patch->columnofs[col]));
+
+        while (column->topdelta != 0xFF)
+        {
+            const byte  *source = (const byte *)column + 3;
+            byte        *cell = &cells[column->topdelta * width + col];
+
+            for (int i = 0; i < column->length; i++, cell += width)
             {
-                if (y + i >= CONSOLETOP)
-                {
-                    if (*source == WHITE)
-                        *dest = color;
-                    else if (*dest != color)
-                        *dest = backgroundcolor;
-                }
+                const byte  dot = *source++;
 
-                source++;
-                dest += SCREENWIDTH;
+                *cell = (dot == WHITE ? GLYPH_INK : (dot ? GLYPH_SOLID : GLYPH_CLEAR));
             }
 
-            column = (column_t *)((byte *)column + CONSOLELINEHEIGHT + 4);
+            column = (const column_t *)((const byte *)column + column->length + 4);
         }
     }
+
+    glyph->patch = patch;
+    glyph->hash = V_HashPatch(patch);
+    glyph->zonefrees = zonefrees;
+    glyph->width = width;
+    glyph->height = height;
+    glyph->offset = glyphatlassize;
+    glyphatlassize += width * height;
+    numglyphs++;
 }
 
-void V_DrawConsoleOutputTextPatch(int x, int y, patch_t *patch, int width, int color,
-    int backgroundcolor, dboolean italics, byte *translucency)
+//
+// V_GetGlyph
+//  Returns the atlas entry for a font patch, adding it the first time it is
+//  seen. The atlas is simply emptied if it ever fills up, or if a patch has
+//  been purged and its memory reused for one that hashes differently, which
+//  is only checked for once zone blocks have been freed.
+//
+static const atlasglyph_t *V_GetGlyph(const patch_t *patch)
 {
-    byte        *desttop = &screens[0][y * SCREENWIDTH + x];
-    const int   italicize[] = { 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, -1, -1, -1 };
+    int i = (int)(((uintptr_t)patch >> 3) & (GLYPHATLASSIZE - 1));
 
-    for (int col = 0; col < width; col++, desttop++)
+    while (glyphs[i].patch)
     {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-        byte        topdelta;
+        atlasglyph_t    *glyph = &glyphs[i];
 
-        // step through the posts in a column
-        while ((topdelta = column->topdelta) != 0xFF)
+        if (glyph->patch == patch)
         {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[topdelta * SCREENWIDTH];
+            if (glyph->zonefrees == zonefrees)
+                return glyph;
 
-            for (int i = 0; i < CONSOLELINEHEIGHT; i++)
+            if (glyph->hash == V_HashPatch(patch))
             {
-                if (y + i >= CONSOLETOP && *source)
-                {
-                    byte    *dot = dest;
+                glyph->zonefrees = zonefrees;
+                return glyph;
+            }
 
-                    if (italics)
-                        dot += italicize[i];
+            break;
+        }
 
-                    *dot = (!translucency ? color : translucency[(color << 8) + *dot]);
+        i = (i + 1) & (GLYPHATLASSIZE - 1);
+    }
 
-                    if (!(y + i))
-                        *dot = tinttab50[*dot];
-                    else if (y + i == 1)
-                        *dot = tinttab25[*dot];
-                }
+    if (glyphs[i].patch || numglyphs >= GLYPHATLASSIZE * 3 / 4)
+    {
+        memset(glyphs, 0, sizeof(glyphs));
+        numglyphs = 0;
+        glyphatlassize = 0;
+        glyphatlasgeneration++;
+        i = (int)(((uintptr_t)patch >> 3) & (GLYPHATLASSIZE - 1));
+    }
 
-                source++;
-                dest += SCREENWIDTH;
+    V_AddGlyph(&glyphs[i], patch);
+
+    return &glyphs[i];
+}
+
+//
+// V_DrawConsoleText
+//  Draws up to GLYPHBATCHSIZE glyphs of laid out console text in one pass, a
+//  row at a time. Every pixel still receives its writes in the order the
+//  glyphs were laid out, so overlapping kerned glyphs look the same as they
+//  did when drawn one by one.
+//
+static void V_DrawConsoleText(const textglyph_t *textglyphs, const int count, const int x, const int y,
+    const int *colors, const int backgroundcolor, const byte *translucency, const dboolean input)
+{
+    const atlasglyph_t  *atlasglyphs[GLYPHBATCHSIZE];
+    const int           italicize[] = { 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, -1, -1, -1 };
+    int                 generation;
+    int                 height;
+
+    do
+    {
+        generation = glyphatlasgeneration;
+        height = 0;
+
+        for (int i = 0; i < count; i++)
+            height = MAX(height, (atlasglyphs[i] = V_GetGlyph(textglyphs[i].patch))->height);
+    } while (generation != glyphatlasgeneration);
+
+    for (int row = MAX(0, CONSOLETOP - y); row < height; row++)
+    {
+        byte        *desttop = &screens[0][(y + row) * SCREENWIDTH + x];
+        const byte  *fade = (y + row == 0 ? tinttab50 : (y + row == 1 ? tinttab25 : NULL));
+        const int   slant = (row < (int)arrlen(italicize) ? italicize[row] : 0);
+
+        for (int i = 0; i < count; i++)
+        {
+            const textglyph_t   *textglyph = &textglyphs[i];
+            const atlasglyph_t  *glyph = atlasglyphs[i];
+            const int           color = colors[textglyph->style];
+            const int           width = MIN(textglyph->width, glyph->width);
+            const byte          *cell;
+            byte                *dest;
+
+            if (row >= glyph->height)
+                continue;
+
+            cell = &glyphatlas[glyph->offset + row * glyph->width];
+            dest = desttop + textglyph->x;
+
+            if (input)
+            {
+                for (int col = 0; col < width; col++, cell++, dest++)
+                    if (*cell == GLYPH_INK)
+                        *dest = color;
+                    else if (*cell != GLYPH_NONE && *dest != color)
+                        *dest = backgroundcolor;
             }
+            else
+            {
+                const byte  *tint = (translucency ? &translucency[color << 8] : NULL);
 
-            column = (column_t *)((byte *)column + CONSOLELINEHEIGHT + 4);
+                if (textglyph->slanted)
+                    dest += slant;
+
+                for (int col = 0; col < width; col++, cell++, dest++)
+                    if (*cell >= GLYPH_SOLID)
+                    {
+                        *dest = (tint ? tint[*dest] : color);
+
+                        if (fade)
+                            *dest = fade[*dest];
+                    }
+            }
         }
     }
 }
 
+void V_DrawConsoleInputText(const textglyph_t *textglyphs, const int count, int x, int y, const int *colors,
+    int backgroundcolor, byte *translucency)
+{
+    for (int i = 0; i < count; i += GLYPHBATCHSIZE)
+        V_DrawConsoleText(&textglyphs[i], MIN(count - i, GLYPHBATCHSIZE), x, y, colors, backgroundcolor,
+            translucency, true);
+}
+
+void V_DrawConsoleOutputText(const textglyph_t *textglyphs, const int count, int x, int y, const int *colors,
+    int backgroundcolor, byte *translucency)
+{
+    for (int i = 0; i < count; i += GLYPHBATCHSIZE)
+        V_DrawConsoleText(&textglyphs[i], MIN(count - i, GLYPHBATCHSIZE), x, y, colors, backgroundcolor,
+            translucency, false);
+}
+
+void V_DrawConsoleOutputTextPatch(int x, int y, patch_t *patch, int width, int color,
+    int backgroundcolor, dboolean italics, byte *translucency)
+{
+    const textglyph_t   textglyph = { patch, 0, (short)width, 0, italics };
+
+    V_DrawConsoleText(&textglyph, 1, x, y, &color, backgroundcolor, translucency, false);
+}
+
 void V_DrawConsolePatch(int x, int y, patch_t *patch, int color, int maxwidth)
 {
     byte        *desttop = &screens[0][y * SCREENWIDTH + x];
@@ -674,40 +1163,23 @@ dboolean V_IsEmptyPatch(patch_t *patch)
 
 void V_DrawPatchToTempScreen(int x, int y, patch_t *patch)
 {
-    byte        *desttop;
-    const int   w = SHORT(patch->width) << FRACBITS;
+    const compiledpatch_t   *cp = V_GetCompiledPatch(patch, true);
 
     y -= SHORT(patch->topoffset);
     x -= SHORT(patch->leftoffset);
 
-    desttop = &tempscreen[((y * DY) >> FRACBITS) * SCREENWIDTH + ((x * DX) >> FRACBITS)];
+    x = (x * DX) >> FRACBITS;
+    y = (y * DY) >> FRACBITS;
 
-    for (int col = 0; col < w; col += DXI, desttop++)
+    if (!vanilla)
     {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col >> FRACBITS]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[((column->topdelta * DY) >> FRACBITS) * SCREENWIDTH];
-            int     count = (column->length * DY) >> FRACBITS;
-            int     srccol = 0;
-
-            while (count--)
-            {
-                *dest = source[srccol >> FRACBITS];
-                dest += SCREENWIDTH;
+        byte    shadow[256];
 
-                if (!vanilla)
-                    *(dest + SCREENWIDTH + 2) = nearestblack;
-
-                srccol += DYI;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
+        memset(shadow, nearestblack, 256);
+        V_BlitPatch(cp, tempscreen, x + 2, y + 2, blendshadow, shadow, NULL, -1, NULL);
     }
+
+    V_BlitPatch(cp, tempscreen, x, y, blendsolid, NULL, NULL, -1, NULL);
 }
 
 void V_DrawBigPatchToTempScreen(int x, int y, patch_t *patch)
@@ -752,328 +1224,102 @@ void V_DrawBigPatchToTempScreen(int x, int y, patch_t *patch)
 
 void V_DrawAltHUDText(int x, int y, byte *screen, patch_t *patch, int color)
 {
-    byte        *desttop = &screen[y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
-
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-        int         topdelta;
-
-        // step through the posts in a column
-        while ((topdelta = column->topdelta) != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[topdelta * SCREENWIDTH];
-            int     count = column->length;
-
-            while (count--)
-            {
-                if (*source++ == WHITE)
-                    *dest = color;
-
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
-    }
+    const atlasglyph_t  *glyph = V_GetGlyph(patch);
+    const byte          *cell = &glyphatlas[glyph->offset];
+    byte                *dest = &screen[y * SCREENWIDTH + x];
+
+    for (int row = 0; row < glyph->height; row++, dest += SCREENWIDTH)
+        for (int col = 0; col < glyph->width; col++, cell++)
+            if (*cell == GLYPH_INK)
+                dest[col] = color;
 }
 
 void V_DrawTranslucentAltHUDText(int x, int y, byte *screen, patch_t *patch, int color)
 {
-    byte        *desttop = &screen[y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
-    byte        *tinttab = (automapactive ? tinttab25 : tinttab60);
-
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-        int         topdelta;
-
-        // step through the posts in a column
-        while ((topdelta = column->topdelta) != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[topdelta * SCREENWIDTH];
-            int     count = column->length;
-
-            while (count--)
-            {
-                if (*source++ == WHITE)
-                    *dest = tinttab[(*dest << 8) + color];
-
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
-    }
+    const atlasglyph_t  *glyph = V_GetGlyph(patch);
+    const byte          *cell = &glyphatlas[glyph->offset];
+    byte                *dest = &screen[y * SCREENWIDTH + x];
+    const byte          *tinttab = (automapactive ? tinttab25 : tinttab60);
+
+    for (int row = 0; row < glyph->height; row++, dest += SCREENWIDTH)
+        for (int col = 0; col < glyph->width; col++, cell++)
+            if (*cell == GLYPH_INK)
+                dest[col] = tinttab[(dest[col] << 8) + color];
 }
 
 void V_DrawPatchWithShadow(int x, int y, patch_t *patch, dboolean flag)
 {
-    byte        *desttop;
-    const int   w = SHORT(patch->width) << FRACBITS;
+    const compiledpatch_t   *cp = V_GetCompiledPatch(patch, true);
+    byte                    *shadow = black40;
+    byte                    flagged[256];
 
     y -= SHORT(patch->topoffset);
     x -= SHORT(patch->leftoffset);
     x += WIDESCREENDELTA;   // [crispy] horizontal widescreen offset
 
-    desttop = &screens[0][((y * DY) >> FRACBITS) * SCREENWIDTH + ((x * DX) >> FRACBITS)];
+    x = (x * DX) >> FRACBITS;
+    y = (y * DY) >> FRACBITS;
 
-    for (int col = 0; col < w; col += DXI, desttop++)
+    if (flag)
     {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col >> FRACBITS]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[((column->topdelta * DY) >> FRACBITS) * SCREENWIDTH];
-            int     count = (column->length * DY) >> FRACBITS;
-            int     srccol = 0;
-
-            while (count--)
-            {
-                int height = (((y + column->topdelta + column->length) * DY) >> FRACBITS) - count;
-
-                if (height > 0)
-                    *dest = source[srccol >> FRACBITS];
-
-                dest += SCREENWIDTH;
-
-                if (height + 2 > 0)
-                {
-                    byte    *dot = dest + SCREENWIDTH + 2;
-
-                    if (!flag || (*dot != 47 && *dot != 191))
-                        *dot = black40[*dot];
-                }
-
-                srccol += DYI;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
+        memcpy(flagged, black40, 256);
+        flagged[47] = 47;
+        flagged[191] = 191;
+        shadow = flagged;
     }
+
+    V_BlitPatch(cp, screens[0], x + 2, y + 2, blendshadow, shadow, NULL, -1, NULL);
+    V_BlitPatch(cp, screens[0], x, y, blendsolid, NULL, NULL, -1, NULL);
 }
 
 void V_DrawHUDPatch(int x, int y, patch_t *patch, byte *translucency)
 {
-    byte        *desttop = &screens[0][y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
-
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[column->topdelta * SCREENWIDTH];
-            int     count = column->length;
-
-            while (count--)
-            {
-                *dest = *source++;
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
-    }
+    V_BlitPatch(V_GetCompiledPatch(patch, false), screens[0], x, y, blendsolid, NULL, NULL, -1, NULL);
 }
 
 void V_DrawHighlightedHUDNumberPatch(int x, int y, patch_t *patch, byte *translucency)
 {
-    byte        *desttop = &screens[0][y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
-
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[column->topdelta * SCREENWIDTH];
-            int     count = column->length;
-
-            while (count--)
-            {
-                byte    dot = *source++;
-
-                *dest = (dot == 109 ? tinttab33[*dest] : yellow15[dot]);
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
-    }
+    V_BlitPatch(V_GetCompiledPatch(patch, false), screens[0], x, y, blendsolid, NULL, yellow15, 109, tinttab33);
 }
 
 void V_DrawTranslucentHUDPatch(int x, int y, patch_t *patch, byte *translucency)
 {
-    byte        *desttop = &screens[0][y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
-
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[column->topdelta * SCREENWIDTH];
-            int     count = column->length;
-
-            while (count--)
-            {
-                *dest = translucency[(*source++ << 8) + *dest];
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
-    }
+    V_BlitPatch(V_GetCompiledPatch(patch, false), screens[0], x, y, blendtinttab, translucency, NULL, -1, NULL);
 }
 
 void V_DrawTranslucentHUDNumberPatch(int x, int y, patch_t *patch, byte *translucency)
 {
-    byte        *desttop = &screens[0][y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
-
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[column->topdelta * SCREENWIDTH];
-            int     count = column->length;
-
-            while (count--)
-            {
-                byte    dot = *source++;
-
-                *dest = (dot == 109 ? tinttab33[*dest] : translucency[(dot << 8) + *dest]);
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
-    }
+    V_BlitPatch(V_GetCompiledPatch(patch, false), screens[0], x, y, blendtinttab, translucency, NULL, 109, tinttab33);
 }
 
 void V_DrawAltHUDPatch(int x, int y, patch_t *patch, int from, int to)
 {
-    byte        *desttop = &screens[0][y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
+    byte    colors[256];
 
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[column->topdelta * SCREENWIDTH];
-            byte    length = column->length;
-            byte    count = length;
+    memcpy(colors, nearestcolors, 256);
+    colors[from] = to;
 
-            while (count--)
-            {
-                byte    dot = *source++;
-
-                if (dot == from)
-                    *dest = to;
-                else if (dot)
-                    *dest = nearestcolors[dot];
-
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + length + 4);
-        }
-    }
+    V_BlitPatch(V_GetCompiledPatch(patch, false), screens[0], x, y, blendsolid, NULL, colors, (from ? 0 : -1), NULL);
 }
 
 void V_DrawTranslucentAltHUDPatch(int x, int y, patch_t *patch, int from, int to)
 {
-    byte        *desttop = &screens[0][y * SCREENWIDTH + x];
-    const int   w = SHORT(patch->width);
-
-    to <<= 8;
-
-    for (int col = 0; col < w; col++, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[column->topdelta * SCREENWIDTH];
-            byte    length = column->length;
-            byte    count = length;
-
-            while (count--)
-            {
-                byte    dot = *source++;
-
-                if (dot == from)
-                    *dest = alttinttab60[to + *dest];
-                else if (dot)
-                    *dest = alttinttab60[(nearestcolors[dot] << 8) + *dest];
-
-                dest += SCREENWIDTH;
-            }
-
-            column = (column_t *)((byte *)column + length + 4);
-        }
-    }
-}
-
-void V_DrawTranslucentRedPatch(int x, int y, patch_t *patch)
-{
-    byte        *desttop;
-    const int   w = SHORT(patch->width) << FRACBITS;
-
-    y -= SHORT(patch->topoffset);
-    x -= SHORT(patch->leftoffset);
-    x += WIDESCREENDELTA;   // [crispy] horizontal widescreen offset
-
-    desttop = &screens[0][((y * DY) >> FRACBITS) * SCREENWIDTH + ((x * DX) >> FRACBITS)];
-
-    for (int col = 0; col < w; col += DXI, desttop++)
-    {
-        column_t    *column = (column_t *)((byte *)patch + LONG(patch->columnofs[col >> FRACBITS]));
-
-        // step through the posts in a column
-        while (column->topdelta != 0xFF)
-        {
-            byte    *source = (byte *)column + 3;
-            byte    *dest = &desttop[((column->topdelta * DY) >> FRACBITS) * SCREENWIDTH];
-            int     count = (column->length * DY) >> FRACBITS;
-            int     srccol = 0;
-
-            while (count--)
-            {
-                *dest = tinttabred[(*dest << 8) + source[srccol >> FRACBITS]];
-                dest += SCREENWIDTH;
-                srccol += DYI;
-            }
+    byte    colors[256];
 
-            column = (column_t *)((byte *)column + column->length + 4);
-        }
-    }
+    memcpy(colors, nearestcolors, 256);
+    colors[from] = to;
+
+    V_BlitPatch(V_GetCompiledPatch(patch, false), screens[0], x, y, blendtinttab, alttinttab60, colors, (from ? 0 : -1), NULL);
+}
+
+void V_DrawTranslucentRedPatch(int x, int y, patch_t *patch)
+{
+    y -= SHORT(patch->topoffset);
+    x -= SHORT(patch->leftoffset);
+    x += WIDESCREENDELTA;   // [crispy] horizontal widescreen offset
+
+    V_BlitPatch(V_GetCompiledPatch(patch, true), screens[0], (x * DX) >> FRACBITS, (y * DY) >> FRACBITS,
+        blendreversetinttab, tinttabred, NULL, -1, NULL);
 }
 
 //
@@ -1634,6 +1880,240 @@ void V_InvertScreen(void)
         }
 }
 
+//
+// V_BlurScreen
+//  Blur a screen by blending each pixel with its neighbors in turn in several
+//  directions, after first turning it gray if gray isn't NULL, and with some
+//  noise if noise is set. The result is tinted using tint if it isn't NULL, and
+//  unless there's noise, which changes each time, kept until the screen changes.
+//
+//  Apart from the first two passes, which blend along each row, each pass only
+//  reads the row above or below it, so the screen is split into bands that
+//  are blurred on separate threads, each with enough rows around it that its
+//  own rows come out the same as if the whole screen was blurred at once. The
+//  threads are started the first time a screen is blurred, and then wait for
+//  the next one.
+//
+#define BLURBANDHEIGHT  32
+#define BLURBANDABOVE   3
+#define BLURBANDBELOW   4
+#define BLURNOISESIZE   1024
+#define BLURSCRATCHSIZE ((BLURBANDABOVE + BLURBANDHEIGHT + BLURBANDBELOW + 1) * MAXWIDTH)
+#define MAXBLURTHREADS  16
+
+static blur_t           *currentblur;
+static SDL_atomic_t     nextblurband;
+static int              blurseed;
+static byte             blurnoise[BLURNOISESIZE];
+static dboolean         blurnoiseready;
+
+static int              numblurthreads = -1;
+static SDL_mutex        *blurmutex;
+static SDL_cond         *blurstartcond;
+static SDL_cond         *blurdonecond;
+static int              blurgeneration;
+static int              blurthreadsbusy;
+
+static void V_BlurBand(byte *scratch, const int band)
+{
+    const blur_t    *blur = currentblur;
+    const int       width = blur->width;
+    const int       height = blur->height;
+    const int       top = band * BLURBANDHEIGHT;
+    const int       bottom = MIN(top + BLURBANDHEIGHT, height);
+    const int       first = MAX(0, top - BLURBANDABOVE);
+    const int       last = MIN(height, bottom + BLURBANDBELOW);
+    const int       offsets[4] = { 0, 2, width * 2, width * 2 + 2 };
+    byte            *rows = scratch - first * width;
+
+    // copy the band, along with the rows around it
+    if (blur->gray)
+        for (int i = first * width; i < last * width; i++)
+            rows[i] = blur->gray[blur->screen[i]];
+    else
+        memcpy(scratch, blur->screen + first * width, ((size_t)last - first) * width);
+
+    // blend along each row, in both directions
+    for (int y = first * width; y < last * width; y += width)
+    {
+        for (int x = y; x <= y + width - 2; x++)
+            rows[x] = tinttab50[(rows[x + 1] << 8) + rows[x]];
+
+        for (int x = y + width - 2; x > y; x--)
+            rows[x] = tinttab50[(rows[x - 1] << 8) + rows[x]];
+    }
+
+    if (blur->noise)
+        for (int y = MAX(1, first); y <= MIN(height - 2, last - 1); y++)
+        {
+            // don't look below the last row
+            const int   mask = (y + 2 < last ? 3 : 1);
+
+            for (int x = y * width; x <= y * width + width - 2; x++)
+                rows[x] = tinttab50[(rows[x + offsets[blurnoise[(x + blurseed) & (BLURNOISESIZE - 1)] & mask]] << 8)
+                    + rows[x]];
+        }
+
+    for (int y = (last - 1) * width; y >= MAX(1, first + 1) * width; y -= width)
+        for (int x = y + width - 1; x >= y + 1; x--)
+            rows[x] = tinttab50[(rows[x - width - 1] << 8) + rows[x]];
+
+    for (int y = first * width; y <= MIN(height - 2, last - 2) * width; y += width)
+        for (int x = y; x <= y + width - 1; x++)
+            rows[x] = tinttab50[(rows[x + width] << 8) + rows[x]];
+
+    for (int y = (last - 1) * width; y >= MAX(1, first + 1) * width; y -= width)
+        for (int x = y; x <= y + width - 1; x++)
+            rows[x] = tinttab50[(rows[x - width] << 8) + rows[x]];
+
+    for (int y = first * width; y <= MIN(height - 2, last - 2) * width; y += width)
+        for (int x = y + width - 1; x >= y + 1; x--)
+            rows[x] = tinttab50[(rows[x + width - 1] << 8) + rows[x]];
+
+    for (int y = (last - 1) * width; y >= MAX(1, first + 1) * width; y -= width)
+        for (int x = y; x <= y + width - 2; x++)
+            rows[x] = tinttab50[(rows[x - width + 1] << 8) + rows[x]];
+
+    // copy back only the band itself
+    if (blur->tint)
+        for (int i = top * width; i < bottom * width; i++)
+            blur->blurscreen[i] = blur->tint[rows[i]];
+    else
+        memcpy(blur->blurscreen + top * width, rows + top * width, ((size_t)bottom - top) * width);
+}
+
+static void V_BlurBands(byte *scratch)
+{
+    const int   numbands = (currentblur->height + BLURBANDHEIGHT - 1) / BLURBANDHEIGHT;
+    int         band;
+
+    while ((band = SDL_AtomicAdd(&nextblurband, 1)) < numbands)
+        V_BlurBand(scratch, band);
+}
+
+static int SDLCALL V_BlurThread(void *data)
+{
+    byte    *scratch = malloc(BLURSCRATCHSIZE);
+    int     generation = 0;
+
+    SDL_LockMutex(blurmutex);
+
+    while (true)
+    {
+        while (blurgeneration == generation)
+            SDL_CondWait(blurstartcond, blurmutex);
+
+        generation = blurgeneration;
+        SDL_UnlockMutex(blurmutex);
+
+        V_BlurBands(scratch);
+
+        SDL_LockMutex(blurmutex);
+
+        if (!--blurthreadsbusy)
+            SDL_CondSignal(blurdonecond);
+    }
+
+    return 0;
+}
+
+static void V_InitBlurThreads(void)
+{
+    numblurthreads = MIN(SDL_GetCPUCount() - 1, MAXBLURTHREADS);
+
+    if (numblurthreads <= 0 || !(blurmutex = SDL_CreateMutex()))
+    {
+        numblurthreads = 0;
+        return;
+    }
+
+    blurstartcond = SDL_CreateCond();
+    blurdonecond = SDL_CreateCond();
+
+    for (int i = 0; i < numblurthreads; i++)
+    {
+        SDL_Thread  *thread = SDL_CreateThread(V_BlurThread, "V_BlurThread", NULL);
+
+        if (!thread)
+        {
+            numblurthreads = i;
+            break;
+        }
+
+        // the threads wait for more screens to blur until the game quits
+        SDL_DetachThread(thread);
+    }
+}
+
+byte *V_BlurScreen(blur_t *blur, const byte *screen, const int width, const int height, const byte *gray,
+    const byte *tint, const dboolean noise)
+{
+    const size_t    size = (size_t)width * height;
+    static byte     *scratch;
+
+    if (!noise && blur->blurscreen && blur->width == width && blur->height == height && blur->gray == gray
+        && blur->tint == tint && blur->noise == noise && !memcmp(blur->screen, screen, size))
+        return blur->blurscreen;
+
+    if (blur->width * blur->height < (int)size)
+    {
+        blur->screen = I_Realloc(blur->screen, size);
+        blur->blurscreen = I_Realloc(blur->blurscreen, size);
+    }
+
+    memcpy(blur->screen, screen, size);
+    blur->width = width;
+    blur->height = height;
+    blur->gray = gray;
+    blur->tint = tint;
+    blur->noise = noise;
+
+    if (noise)
+    {
+        if (!blurnoiseready)
+        {
+            for (int i = 0; i < BLURNOISESIZE; i++)
+                blurnoise[i] = M_BigRandom() & 3;
+
+            blurnoiseready = true;
+        }
+
+        blurseed = M_BigRandom();
+    }
+
+    if (numblurthreads == -1)
+    {
+        V_InitBlurThreads();
+        scratch = malloc(BLURSCRATCHSIZE);
+    }
+
+    currentblur = blur;
+    SDL_AtomicSet(&nextblurband, 0);
+
+    if (numblurthreads)
+    {
+        SDL_LockMutex(blurmutex);
+        blurthreadsbusy = numblurthreads;
+        blurgeneration++;
+        SDL_CondBroadcast(blurstartcond);
+        SDL_UnlockMutex(blurmutex);
+    }
+
+    V_BlurBands(scratch);
+
+    if (numblurthreads)
+    {
+        SDL_LockMutex(blurmutex);
+
+        while (blurthreadsbusy)
+            SDL_CondWait(blurdonecond, blurmutex);
+
+        SDL_UnlockMutex(blurmutex);
+    }
+
+    return blur->blurscreen;
+}
+
 //
 // V_Init
 //
@@ -1674,28 +2154,435 @@ char    lbmname1[MAX_PATH];
 char    lbmpath1[MAX_PATH];
 char    lbmpath2[MAX_PATH];
 
-static dboolean V_SavePNG(SDL_Renderer *sdlrenderer, char *path)
+//
+// Screenshots and frame dumps
+//
+// The 8-bit screen and the current palette are copied into one of a ring of
+// capture buffers, and then encoded by worker threads so the game thread never
+// waits on an encoder. Frames dumped to a Y4M file are written strictly in the
+// order they were captured.
+//
+#define NUMCAPTUREBUFFERS   8
+#define NUMCAPTURETHREADS   2
+
+typedef enum
+{
+    capture_free,
+    capture_filled,
+    capture_encoding
+} capturestate_t;
+
+typedef struct
+{
+    capturestate_t  state;
+    framedump_t     type;
+    int             sequence;
+    int             frame;
+    int             width;
+    int             height;
+    byte            *pixels;
+    size_t          pixelssize;
+    byte            *yuv;
+    size_t          yuvsize;
+    SDL_Color       colors[256];
+    char            path[MAX_PATH];
+} capture_t;
+
+framedump_t         framedump = framedump_none;
+char                framedumpfolder[MAX_PATH];
+int                 framedumpframes;
+
+static capture_t    captures[NUMCAPTUREBUFFERS];
+static SDL_Thread   *capturethreads[NUMCAPTURETHREADS];
+static SDL_mutex    *capturemutex;
+static SDL_cond     *capturefilledcond;
+static SDL_cond     *capturefreedcond;
+static int          capturesequence;
+static int          captureinprogress;
+static int          capturefailures;
+static dboolean     captureshutdown;
+
+static FILE         *y4mfile;
+static int          y4mnextframe;
+static int          y4mwidth;
+static int          y4mheight;
+static int          lastframedumptime = -1;
+
+static dboolean V_EncodePNG(capture_t *capture)
 {
     dboolean    result = false;
-    int         rendererwidth;
-    int         rendererheight;
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom(capture->pixels, capture->width, capture->height,
+                    8, capture->width, SDL_PIXELFORMAT_INDEX8);
+
+    if (surface)
+    {
+        if (!SDL_SetPaletteColors(surface->format->palette, capture->colors, 0, 256))
+            result = !IMG_SavePNG(surface, capture->path);
+
+        SDL_FreeSurface(surface);
+    }
+
+    return result;
+}
+
+static dboolean V_EncodeY4M(capture_t *capture)
+{
+    const int   area = capture->width * capture->height;
+    byte        y[256], u[256], v[256];
+    byte        *pixels = capture->pixels;
+    byte        *yplane, *uplane, *vplane;
+    dboolean    result;
+
+    if (capture->yuvsize < (size_t)area * 3)
+    {
+        capture->yuvsize = (size_t)area * 3;
+        capture->yuv = I_Realloc(capture->yuv, capture->yuvsize);
+    }
+
+    // BT.601 limited range
+    for (int i = 0; i < 256; i++)
+    {
+        const int   r = capture->colors[i].r;
+        const int   g = capture->colors[i].g;
+        const int   b = capture->colors[i].b;
+
+        y[i] = (byte)(16 + (65481 * r + 128553 * g + 24966 * b) / 255000);
+        u[i] = (byte)(128 + (-37797 * r - 74203 * g + 112000 * b) / 255000);
+        v[i] = (byte)(128 + (112000 * r - 93786 * g - 18214 * b) / 255000);
+    }
+
+    yplane = capture->yuv;
+    uplane = yplane + area;
+    vplane = uplane + area;
+
+    for (int i = 0; i < area; i++)
+    {
+        const byte  dot = pixels[i];
+
+        yplane[i] = y[dot];
+        uplane[i] = u[dot];
+        vplane[i] = v[dot];
+    }
+
+    // wait for any earlier frames to be written first
+    SDL_LockMutex(capturemutex);
+
+    while (y4mnextframe != capture->frame)
+        SDL_CondWait(capturefreedcond, capturemutex);
+
+    SDL_UnlockMutex(capturemutex);
+
+    result = (fputs("FRAME\n", y4mfile) >= 0 && fwrite(capture->yuv, 1, (size_t)area * 3, y4mfile) == (size_t)area * 3);
+
+    SDL_LockMutex(capturemutex);
+    y4mnextframe++;
+    SDL_CondBroadcast(capturefreedcond);
+    SDL_UnlockMutex(capturemutex);
+
+    return result;
+}
+
+static int SDLCALL V_CaptureThread(void *data)
+{
+    while (true)
+    {
+        capture_t   *capture = NULL;
+        dboolean    result;
+
+        SDL_LockMutex(capturemutex);
+
+        while (!capture)
+        {
+            // take the oldest filled buffer
+            for (int i = 0; i < NUMCAPTUREBUFFERS; i++)
+                if (captures[i].state == capture_filled && (!capture || captures[i].sequence < capture->sequence))
+                    capture = &captures[i];
+
+            if (capture)
+                capture->state = capture_encoding;
+            else if (captureshutdown)
+            {
+                SDL_UnlockMutex(capturemutex);
+                return 0;
+            }
+            else
+                SDL_CondWait(capturefilledcond, capturemutex);
+        }
+
+        SDL_UnlockMutex(capturemutex);
+
+        result = (capture->type == framedump_y4m ? V_EncodeY4M(capture) : V_EncodePNG(capture));
+
+        if (!result && capture->type != framedump_y4m)
+            remove(capture->path);
+
+        SDL_LockMutex(capturemutex);
+
+        if (!result)
+            capturefailures++;
+
+        capture->state = capture_free;
+        captureinprogress--;
+        SDL_CondBroadcast(capturefreedcond);
+        SDL_UnlockMutex(capturemutex);
+    }
+}
+
+static void V_InitCapture(void)
+{
+    capturemutex = SDL_CreateMutex();
+    capturefilledcond = SDL_CreateCond();
+    capturefreedcond = SDL_CreateCond();
+
+    for (int i = 0; i < NUMCAPTURETHREADS; i++)
+        capturethreads[i] = SDL_CreateThread(V_CaptureThread, "V_CaptureThread", NULL);
+}
+
+//
+// V_QueueCapture
+//  Copy an 8-bit screen into a free capture buffer, waiting for one to become
+//  free if the encoders have fallen behind. If stretch is set, rows are
+//  repeated so the capture has the same 4:3 aspect ratio as the display.
+//
+static void V_QueueCapture(byte *screen, int width, int height, dboolean stretch, framedump_t type, int frame,
+    const char *path)
+{
+    capture_t   *capture = NULL;
+    const int   outputheight = (stretch ? height * 6 / 5 : height);
+    size_t      size = (size_t)width * outputheight;
+    SDL_Color   *colors = I_GetPaletteColors();
+
+    if (!capturemutex)
+        V_InitCapture();
+
+    SDL_LockMutex(capturemutex);
+
+    while (true)
+    {
+        for (int i = 0; i < NUMCAPTUREBUFFERS; i++)
+            if (captures[i].state == capture_free)
+            {
+                capture = &captures[i];
+                break;
+            }
+
+        if (capture)
+            break;
+
+        SDL_CondWait(capturefreedcond, capturemutex);
+    }
+
+    SDL_UnlockMutex(capturemutex);
+
+    if (capture->pixelssize < size)
+    {
+        capture->pixelssize = size;
+        capture->pixels = I_Realloc(capture->pixels, size);
+    }
+
+    if (stretch)
+        for (int y = 0; y < outputheight; y++)
+            memcpy(&capture->pixels[y * width], &screen[y * 5 / 6 * width], width);
+    else
+        memcpy(capture->pixels, screen, size);
+
+    memcpy(capture->colors, colors, sizeof(capture->colors));
+    capture->type = type;
+    capture->frame = frame;
+    capture->width = width;
+    capture->height = outputheight;
+    M_StringCopy(capture->path, path, sizeof(capture->path));
+
+    SDL_LockMutex(capturemutex);
+    capture->sequence = capturesequence++;
+    capture->state = capture_filled;
+    captureinprogress++;
+    SDL_CondSignal(capturefilledcond);
+    SDL_UnlockMutex(capturemutex);
+}
+
+//
+// V_FinishCapture
+//  Wait for all queued captures to be encoded.
+//
+void V_FinishCapture(void)
+{
+    if (!capturemutex)
+        return;
+
+    SDL_LockMutex(capturemutex);
+
+    while (captureinprogress)
+        SDL_CondWait(capturefreedcond, capturemutex);
+
+    SDL_UnlockMutex(capturemutex);
+}
+
+//
+// V_ShutdownCapture
+//  Flush any queued captures, close the Y4M file and stop the worker threads.
+//  Nothing is done if called from one of those threads (by I_Error when an
+//  encoder fails), since waiting on them then would never return.
+//
+void V_ShutdownCapture(void)
+{
+    if (capturemutex)
+    {
+        const SDL_threadID  thread = SDL_ThreadID();
+
+        for (int i = 0; i < NUMCAPTURETHREADS; i++)
+            if (capturethreads[i] && SDL_GetThreadID(capturethreads[i]) == thread)
+                return;
+    }
+
+    if (framedump != framedump_none)
+        V_StopFrameDump();
+
+    if (!capturemutex)
+        return;
+
+    V_FinishCapture();
+
+    SDL_LockMutex(capturemutex);
+    captureshutdown = true;
+    SDL_CondBroadcast(capturefilledcond);
+    SDL_UnlockMutex(capturemutex);
+
+    for (int i = 0; i < NUMCAPTURETHREADS; i++)
+        SDL_WaitThread(capturethreads[i], NULL);
+}
+
+static void V_CheckCaptureFailures(void)
+{
+    int failures;
+
+    SDL_LockMutex(capturemutex);
+    failures = capturefailures;
+    capturefailures = 0;
+    SDL_UnlockMutex(capturemutex);
+
+    if (failures)
+    {
+        char    *temp = commify(failures);
+
+        C_Warning(0, "%s %s couldn't be saved.", temp, (failures == 1 ? "screenshot" : "screenshots"));
+        free(temp);
+    }
+}
+
+//
+// V_StartFrameDump
+//  Start capturing every new frame, either as a numbered sequence of PNG
+//  files, or as a single Y4M file, in a new folder in the screenshots folder.
+//
+dboolean V_StartFrameDump(framedump_t type)
+{
+    int count = 0;
+
+    M_snprintf(framedumpfolder, sizeof(framedumpfolder), "%sframedump", screenshotfolder);
+
+    while (M_FileExists(framedumpfolder))
+    {
+        char    *temp = commify(++count);
 
-    if (!SDL_GetRendererOutputSize(sdlrenderer, &rendererwidth, &rendererheight))
+        M_snprintf(framedumpfolder, sizeof(framedumpfolder), "%sframedump (%s)", screenshotfolder, temp);
+        free(temp);
+    }
+
+    M_MakeDirectory(framedumpfolder);
+
+    if (type == framedump_y4m)
+    {
+        char    path[MAX_PATH];
+
+        M_snprintf(path, sizeof(path), "%s" DIR_SEPARATOR_S "framedump.y4m", framedumpfolder);
+
+        if (!(y4mfile = fopen(path, "wb")))
+            return false;
+
+        // each pixel is displayed 6/5 as tall as it is wide
+        fprintf(y4mfile, "YUV4MPEG2 W%i H%i F%i:1 Ip A5:6 C444\n", SCREENWIDTH, SCREENHEIGHT, TICRATE);
+        y4mnextframe = 0;
+        y4mwidth = SCREENWIDTH;
+        y4mheight = SCREENHEIGHT;
+    }
+
+    framedump = type;
+    framedumpframes = 0;
+    lastframedumptime = -1;
+
+    return true;
+}
+
+void V_StopFrameDump(void)
+{
+    V_FinishCapture();
+
+    if (y4mfile)
     {
-        int         width = (vid_widescreen ? rendererwidth : rendererheight * 4 / 3);
-        int         height = rendererheight;
-        SDL_Surface *screenshot;
+        fclose(y4mfile);
+        y4mfile = NULL;
+    }
 
-        if ((screenshot = SDL_CreateRGBSurface(0, width, height, 32, 0, 0, 0, 0)))
+    framedump = framedump_none;
+}
+
+//
+// V_DumpFrame
+//  Called after each frame is blitted. Captures the screen once per tic while
+//  a frame dump is in progress.
+//
+void V_DumpFrame(void)
+{
+    if (capturemutex)
+        V_CheckCaptureFailures();
+
+    if (framedump == framedump_none || gametime == lastframedumptime)
+        return;
+
+    lastframedumptime = gametime;
+
+    if (framedump == framedump_y4m)
+    {
+        // a Y4M file can't change size partway through, so stop dumping
+        if (SCREENWIDTH != y4mwidth || SCREENHEIGHT != y4mheight)
         {
-            if (!SDL_RenderReadPixels(sdlrenderer, NULL, 0, screenshot->pixels, screenshot->pitch))
-                result = !IMG_SavePNG(screenshot, path);
+            char    *temp = commify(framedumpframes);
 
-            SDL_FreeSurface(screenshot);
+            V_StopFrameDump();
+            C_Warning(0, "Dumped %s frame%s to <b>%s</b> before the screen size changed.",
+                temp, (framedumpframes == 1 ? "" : "s"), framedumpfolder);
+            free(temp);
+            return;
         }
+
+        V_QueueCapture(screens[0], SCREENWIDTH, SCREENHEIGHT, false, framedump_y4m, framedumpframes, "");
+    }
+    else
+    {
+        char    path[MAX_PATH];
+
+        M_snprintf(path, sizeof(path), "%s" DIR_SEPARATOR_S "frame%06i.png", framedumpfolder, framedumpframes);
+        V_QueueCapture(screens[0], SCREENWIDTH, SCREENHEIGHT, false, framedump_png, framedumpframes, path);
     }
 
-    return result;
+    framedumpframes++;
+}
+
+//
+// V_ReserveScreenShotPath
+//  Create an empty file so the path isn't reused before the screenshot is
+//  written by a worker thread.
+//
+static dboolean V_ReserveScreenShotPath(const char *path)
+{
+    FILE    *file = fopen(path, "wb");
+
+    if (!file)
+        return false;
+
+    fclose(file);
+    return true;
 }
 
 dboolean V_ScreenShot(void)
@@ -1769,24 +2656,30 @@ dboolean V_ScreenShot(void)
         M_snprintf(lbmpath1, sizeof(lbmpath1), "%s%s", screenshotfolder, lbmname1);
     } while (M_FileExists(lbmpath1));
 
-    free(temp1);
-
-    result = V_SavePNG(renderer, lbmpath1);
+    lbmpath2[0] = '\0';
 
-    if (result && mapwindow && gamestate == GS_LEVEL)
+    if ((result = V_ReserveScreenShotPath(lbmpath1)))
     {
-        lbmpath2[0] = '\0';
+        V_QueueCapture(screens[0], SCREENWIDTH, SCREENHEIGHT, true, framedump_none, 0, lbmpath1);
 
-        do
+        if (mapwindow && gamestate == GS_LEVEL)
         {
-            char    *temp2 = commify(count++);
+            do
+            {
+                char    *temp2 = commify(count++);
 
-            M_snprintf(lbmpath2, sizeof(lbmpath2), "%s%s (%s).png", screenshotfolder, temp1, temp2);
-            free(temp2);
-        } while (M_FileExists(lbmpath2));
+                M_snprintf(lbmpath2, sizeof(lbmpath2), "%s%s (%s).png", screenshotfolder, temp1, temp2);
+                free(temp2);
+            } while (M_FileExists(lbmpath2));
 
-        V_SavePNG(maprenderer, lbmpath2);
+            if (V_ReserveScreenShotPath(lbmpath2))
+                V_QueueCapture(mapscreen, SCREENWIDTH, SCREENHEIGHT - SBARHEIGHT, true, framedump_none, 0, lbmpath2);
+            else
+                lbmpath2[0] = '\0';
+        }
     }
 
+    free(temp1);
+
     return result;
 }
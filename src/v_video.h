@@ -55,6 +55,37 @@ extern int  lowpixelheight;
 
 extern char screenshotfolder[MAX_PATH];
 
+typedef enum
+{
+    framedump_none,
+    framedump_png,
+    framedump_y4m
+} framedump_t;
+
+extern framedump_t  framedump;
+extern char         framedumpfolder[MAX_PATH];
+extern int          framedumpframes;
+
+typedef struct
+{
+    byte        *screen;
+    byte        *blurscreen;
+    int         width;
+    int         height;
+    const byte  *gray;
+    const byte  *tint;
+    dboolean    noise;
+} blur_t;
+
+typedef struct
+{
+    patch_t     *patch;
+    short       x;
+    short       width;
+    byte        style;
+    dboolean    slanted;
+} textglyph_t;
+
 // Allocates buffer screens, call before R_Init.
 void V_Init(void);
 
@@ -68,8 +99,10 @@ void V_DrawBigPatch(int x, int y, patch_t *patch);
 void V_DrawBigWidePatch(int x, int y, int scrn, patch_t *patch);
 void V_DrawConsolePatch(int x, int y, patch_t *patch, int color, int maxwidth);
 void V_DrawConsoleBrandingPatch(int x, int y, patch_t *patch, int color);
-void V_DrawConsoleInputTextPatch(int x, int y, patch_t *patch, int width, int color,
-    int backgroundcolor, dboolean italics, byte *translucency);
+void V_DrawConsoleInputText(const textglyph_t *textglyphs, const int count, int x, int y, const int *colors,
+    int backgroundcolor, byte *translucency);
+void V_DrawConsoleOutputText(const textglyph_t *textglyphs, const int count, int x, int y, const int *colors,
+    int backgroundcolor, byte *translucency);
 void V_DrawConsoleOutputTextPatch(int x, int y, patch_t *patch, int width, int color,
     int backgroundcolor, dboolean italics, byte *translucency);
 void V_DrawShadowPatch(int x, int y, patch_t *patch);
@@ -106,7 +139,14 @@ void V_DrawPixel(int x, int y, byte color, dboolean drawshadow);
 void GetPixelSize(dboolean reset);
 void V_LowGraphicDetail(int left, int top, int width, int height, int pixelwidth, int pixelheight);
 void V_InvertScreen(void);
+byte *V_BlurScreen(blur_t *blur, const byte *screen, const int width, const int height, const byte *gray,
+    const byte *tint, const dboolean noise);
 
 dboolean V_ScreenShot(void);
+dboolean V_StartFrameDump(framedump_t type);
+void V_StopFrameDump(void);
+void V_DumpFrame(void);
+void V_FinishCapture(void);
+void V_ShutdownCapture(void);
 
 #endif
@@ -44,11 +44,14 @@
 #include "doomstat.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_misc.h"
 #include "w_merge.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
+#include "SDL.h"
+
 #if defined(_MSC_VER) || defined(__GNUC__)
 #pragma pack(push, 1)
 #endif
@@ -633,12 +636,224 @@ static void W_ReadLump(int lump, void *dest)
         I_Error("W_ReadLump: only read %zd of %i on lump %i", c, l->size, lump);
 }
 
+//
+// Lump prefetching
+//
+// Lumps that will soon be needed can be queued with W_PrefetchLump(), and are
+// then read by a worker thread while the main thread is busy with something
+// else. The worker has its own handle to each WAD so it never shares a file
+// position with W_Read(), and it reads into malloc'd buffers since the zone
+// may only be touched by the main thread. W_CacheLumpNum() copies a finished
+// buffer into the zone, or waits for one that is still being read.
+//
+enum
+{
+    PREFETCH_NONE,
+    PREFETCH_QUEUED,
+    PREFETCH_READING,
+    PREFETCH_DONE
+};
+
+typedef struct
+{
+    wadfile_t   *wadfile;
+    FILE        *fstream;
+} prefetchfile_t;
+
+static byte             *prefetchstate;
+static void             **prefetchdata;
+static int              *prefetchqueue;
+static int              prefetchqueuesize;
+static int              prefetchhead;
+static int              prefetchtail;
+static prefetchfile_t   *prefetchfiles;
+static int              numprefetchfiles;
+
+static SDL_Thread       *prefetchthread;
+static SDL_mutex        *prefetchmutex;
+static SDL_cond         *prefetchqueuecond;
+static SDL_cond         *prefetchdonecond;
+
+static FILE *W_PrefetchFile(wadfile_t *wadfile)
+{
+    for (int i = 0; i < numprefetchfiles; i++)
+        if (prefetchfiles[i].wadfile == wadfile)
+            return prefetchfiles[i].fstream;
+
+    prefetchfiles = I_Realloc(prefetchfiles, (numprefetchfiles + 1) * sizeof(*prefetchfiles));
+    prefetchfiles[numprefetchfiles].wadfile = wadfile;
+    prefetchfiles[numprefetchfiles].fstream = fopen(wadfile->path, "rb");
+
+    return prefetchfiles[numprefetchfiles++].fstream;
+}
+
+static void *W_PrefetchRead(int lumpnum)
+{
+    lumpinfo_t  *lump = lumpinfo[lumpnum];
+    FILE        *fstream = W_PrefetchFile(lump->wadfile);
+    void        *data;
+
+    if (!fstream || !(data = malloc(lump->size)))
+        return NULL;
+
+    if (fseek(fstream, lump->position, SEEK_SET) || fread(data, 1, lump->size, fstream) < (size_t)lump->size)
+    {
+        free(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+static int SDLCALL W_PrefetchThread(void *data)
+{
+    SDL_LockMutex(prefetchmutex);
+
+    while (true)
+    {
+        int     lumpnum;
+        void    *buffer;
+
+        while (prefetchhead == prefetchtail)
+            SDL_CondWait(prefetchqueuecond, prefetchmutex);
+
+        lumpnum = prefetchqueue[prefetchhead++];
+
+        // skip lumps that were claimed or cancelled while queued
+        if (prefetchstate[lumpnum] != PREFETCH_QUEUED)
+            continue;
+
+        prefetchstate[lumpnum] = PREFETCH_READING;
+        SDL_UnlockMutex(prefetchmutex);
+
+        buffer = W_PrefetchRead(lumpnum);
+
+        SDL_LockMutex(prefetchmutex);
+
+        if (prefetchstate[lumpnum] == PREFETCH_READING)
+        {
+            prefetchdata[lumpnum] = buffer;
+            prefetchstate[lumpnum] = PREFETCH_DONE;
+            SDL_CondBroadcast(prefetchdonecond);
+        }
+        else
+            free(buffer);
+    }
+
+    return 0;
+}
+
+//
+// W_PrefetchLump
+// Queues a lump to be read in the background before it is needed.
+//
+void W_PrefetchLump(int lumpnum)
+{
+    if (lumpnum < 0 || lumpnum >= numlumps || lumpinfo[lumpnum]->cache || lumpinfo[lumpnum]->size <= 0)
+        return;
+
+    if (!prefetchthread)
+    {
+        prefetchstate = calloc(numlumps, sizeof(*prefetchstate));
+        prefetchdata = calloc(numlumps, sizeof(*prefetchdata));
+        prefetchmutex = SDL_CreateMutex();
+        prefetchqueuecond = SDL_CreateCond();
+        prefetchdonecond = SDL_CreateCond();
+
+        if (!prefetchstate || !prefetchdata || !prefetchmutex || !prefetchqueuecond || !prefetchdonecond
+            || !(prefetchthread = SDL_CreateThread(W_PrefetchThread, "W_PrefetchThread", NULL)))
+            I_Error("W_PrefetchLump: Unable to start prefetching");
+
+        SDL_DetachThread(prefetchthread);
+    }
+
+    SDL_LockMutex(prefetchmutex);
+
+    if (prefetchstate[lumpnum] == PREFETCH_NONE)
+    {
+        if (prefetchhead == prefetchtail)
+            prefetchhead = prefetchtail = 0;
+
+        if (prefetchtail == prefetchqueuesize)
+        {
+            prefetchqueuesize = MAX(256, prefetchqueuesize * 2);
+            prefetchqueue = I_Realloc(prefetchqueue, prefetchqueuesize * sizeof(*prefetchqueue));
+        }
+
+        prefetchqueue[prefetchtail++] = lumpnum;
+        prefetchstate[lumpnum] = PREFETCH_QUEUED;
+        SDL_CondSignal(prefetchqueuecond);
+    }
+
+    SDL_UnlockMutex(prefetchmutex);
+}
+
+//
+// W_CancelPrefetches
+// Drops every queued lump, and frees those that were read but never used.
+//
+void W_CancelPrefetches(void)
+{
+    if (!prefetchthread)
+        return;
+
+    SDL_LockMutex(prefetchmutex);
+
+    for (int i = 0; i < numlumps; i++)
+    {
+        free(prefetchdata[i]);
+        prefetchdata[i] = NULL;
+        prefetchstate[i] = PREFETCH_NONE;
+    }
+
+    prefetchhead = prefetchtail = 0;
+    SDL_UnlockMutex(prefetchmutex);
+}
+
+static void *W_ClaimPrefetch(int lumpnum)
+{
+    void    *data = NULL;
+
+    if (!prefetchthread)
+        return NULL;
+
+    SDL_LockMutex(prefetchmutex);
+
+    while (prefetchstate[lumpnum] == PREFETCH_READING)
+        SDL_CondWait(prefetchdonecond, prefetchmutex);
+
+    if (prefetchstate[lumpnum] == PREFETCH_DONE)
+    {
+        data = prefetchdata[lumpnum];
+        prefetchdata[lumpnum] = NULL;
+    }
+
+    prefetchstate[lumpnum] = PREFETCH_NONE;
+    SDL_UnlockMutex(prefetchmutex);
+
+    return data;
+}
+
 void *W_CacheLumpNum(int lumpnum)
 {
     lumpinfo_t  *lump = lumpinfo[lumpnum];
 
     if (!lump->cache)
-        W_ReadLump(lumpnum, Z_Malloc(lump->size, PU_CACHE, &lump->cache));
+    {
+        void    *data;
+
+        I_StartProfile("W_CacheLumpNum");
+
+        if ((data = W_ClaimPrefetch(lumpnum)))
+        {
+            memcpy(Z_Malloc(lump->size, PU_CACHE, &lump->cache), data, lump->size);
+            free(data);
+        }
+        else
+            W_ReadLump(lumpnum, Z_Malloc(lump->size, PU_CACHE, &lump->cache));
+
+        I_EndProfile();
+    }
 
     return lump->cache;
 }
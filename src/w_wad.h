@@ -97,6 +97,9 @@ int W_LumpLength(int lump);
 
 void *W_CacheLumpNum(int lumpnum);
 
+void W_PrefetchLump(int lumpnum);
+void W_CancelPrefetches(void);
+
 #define W_CacheLumpName(name)       W_CacheLumpNum(W_GetNumForName(name))
 #define W_CacheLastLumpName(name)   W_CacheLumpNum(W_GetLastNumForName(name))
 
@@ -58,6 +58,12 @@ static const size_t headersize = (sizeof(memblock_t) + CHUNK_SIZE - 1) & ~(CHUNK
 
 static memblock_t   *blockbytag[PU_MAX];
 
+// total number of bytes ever allocated by Z_Malloc()
+uint64_t            zonebytes;
+
+// number of blocks freed by Z_Free() that had a user, such as cached lumps
+unsigned int        zonefrees;
+
 //
 // Z_Malloc
 // You can pass a NULL user if the tag is < PU_PURGELEVEL.
@@ -101,6 +107,7 @@ void *Z_Malloc(size_t size, int tag, void **user)
     }
 
     block->size = size;
+    zonebytes += size;
 
     block->tag = tag;                                   // tag
     block->user = user;                                 // user
@@ -122,7 +129,10 @@ void Z_Free(void *ptr)
     memblock_t  *block = (memblock_t *)((char *)ptr - headersize);
 
     if (block->user)                                    // Nullify user if one exists
+    {
         *block->user = NULL;
+        zonefrees++;
+    }
 
     if (block == block->next)
         blockbytag[block->tag] = NULL;
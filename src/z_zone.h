@@ -43,6 +43,7 @@
 // active before macro replacements below are in effect.
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
 
 //
 // ZONE MEMORY
@@ -66,4 +67,7 @@ void Z_Free(void *ptr);
 void Z_FreeTags(int lowtag, int hightag);
 void Z_ChangeTag(void *ptr, int tag);
 
+extern uint64_t zonebytes;
+extern unsigned int zonefrees;
+
 #endif